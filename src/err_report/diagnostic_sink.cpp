@@ -0,0 +1,67 @@
+#include "diagnostic_sink.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace error
+{
+
+DiagnosticSink::~DiagnosticSink()
+{
+    auto* p_node = head.load(std::memory_order_relaxed);
+    while (p_node != nullptr)
+    {
+        auto* p_next = p_node->next;
+        delete p_node;
+        p_node = p_next;
+    }
+}
+
+/**
+ * @brief 提交一个工作单元的错误，可在任意线程上并发调用
+ * @param unit 工作单元编号，同一收集器中各单元的编号互不相同
+ * @param errs 该单元的错误，提交后为空
+ */
+void DiagnosticSink::submit(std::size_t unit, ErrorReporter&& errs)
+{
+    auto cnt = errs.errCount();
+    if (cnt == 0)
+    {  // 没有错误的单元不占用结点
+        return;
+    }
+
+    auto* p_node = new Node{unit, ErrorReporter{}, nullptr};
+    p_node->errs.merge(std::move(errs));
+
+    p_node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(p_node->next, p_node, std::memory_order_release,
+                                       std::memory_order_relaxed))
+    {
+    }
+    err_cnt.fetch_add(cnt, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 按 (阶段, 单元编号, 单元内顺序) 将已提交的错误移入报告器
+ * @param reporter 目标错误报告器，调用时不能再有并发的 submit
+ */
+void DiagnosticSink::drainInto(ErrorReporter& reporter)
+{
+    std::vector<Node*> nodes;
+    for (auto* p_node = head.exchange(nullptr, std::memory_order_acquire); p_node != nullptr;
+         p_node = p_node->next)
+    {
+        nodes.push_back(p_node);
+    }
+    std::ranges::sort(nodes, {}, &Node::unit);
+
+    // 报告器按阶段分别保存错误，依单元顺序逐个追加即得到 (阶段, 单元, 顺序) 的排列
+    for (auto* p_node : nodes)
+    {
+        reporter.merge(std::move(p_node->errs));
+        delete p_node;
+    }
+    err_cnt.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace error
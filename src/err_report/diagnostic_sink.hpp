@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "error_reporter.hpp"
+
+namespace error
+{
+
+// 并行阶段的诊断收集器
+// 每个工作单元 (如一个函数体) 在自己的线程上向独立的 ErrorReporter 追加错误，
+// 完成后通过 submit 提交：提交只是一次无锁的链表头插入，不需要全局锁。
+// 全部单元完成后由 drainInto 按 (阶段, 单元编号, 单元内顺序) 合并，
+// 因此输出与线程数及完成顺序无关。errorCount 供检查过程提前放弃后续工作
+class DiagnosticSink
+{
+   public:
+    DiagnosticSink() = default;
+    DiagnosticSink(const DiagnosticSink&) = delete;
+    auto operator=(const DiagnosticSink&) -> DiagnosticSink& = delete;
+    ~DiagnosticSink();
+
+   public:
+    void submit(std::size_t unit, ErrorReporter&& errs);
+    void drainInto(ErrorReporter& reporter);
+
+    [[nodiscard]]
+    auto errorCount() const -> std::size_t
+    {
+        return err_cnt.load(std::memory_order_relaxed);
+    }
+
+   private:
+    struct Node
+    {
+        std::size_t unit;    // 工作单元编号，合并时的排序键
+        ErrorReporter errs;  // 该单元的错误，保持报告顺序
+        Node* next = nullptr;
+    };
+
+    std::atomic<Node*> head{nullptr};     // 已提交的单元，后提交的在前
+    std::atomic<std::size_t> err_cnt{0};  // 已提交且尚未取出的错误数
+};
+
+}  // namespace error
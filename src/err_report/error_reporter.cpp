@@ -3,6 +3,11 @@
 #include <cassert>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#include "util/buffered_writer.hpp"
+#include "util/json_writer.hpp"
 
 namespace error
 {
@@ -17,38 +22,53 @@ static inline const std::string BOLD = "\033[1m";
 /*---------------- LexError ----------------*/
 
 /**
- * @brief 控制台输出未知Token
- * @param err  词法错误实例
+ * @brief 输出错误所在的源码行及指向错误列的定位符
+ * @param out 缓冲输出
+ * @param row 错误所在行
+ * @param col 错误所在列
  */
-void ErrorReporter::displayUnknownType(const LexError& err) const
+void ErrorReporter::displaySourceLine(util::BufferedWriter& out, std::size_t row,
+                                      std::size_t col) const
 {
-    std::cerr << BOLD << YELLOW << "warning[UnknownToken]" << RESET << BOLD
-              << ": 识别到未知 token '" << err.token << "'" << RESET << std::endl;
+    auto line_no = std::to_string(row + 1);
+    // 输入末尾缺少 token 时错误位于最后一行之后
+    std::string_view line = row < this->text.size() ? std::string_view{this->text[row]} : "";
+    out << BLUE << "  |  " << '\n' << BLUE << " " << line_no << " | " << RESET << line << '\n';
+
+    // 定位符与源码行中的错误列对齐：" <行号> | " 比 "  |" 多出 行号位数 + 1 个字符
+    out << BLUE << "  |" << std::string(line_no.size() + 1 + col, ' ') << "^" << RESET << '\n'
+        << '\n';
+}
 
-    std::cerr << BLUE << " --> " << RESET << "<row: " << err.row + 1 << ", col: " << err.col + 1
-              << ">" << std::endl;
+/**
+ * @brief 输出未知Token
+ * @param out 缓冲输出
+ * @param err 词法错误实例
+ */
+void ErrorReporter::displayUnknownType(util::BufferedWriter& out, const LexError& err) const
+{
+    out << BOLD << YELLOW << "warning[UnknownToken]" << RESET << BOLD << ": 识别到未知 token '"
+        << err.token << "'" << RESET << '\n';
 
-    std::cerr << BLUE << "  |  " << std::endl
-              << BLUE << " " << err.row + 1 << " | " << RESET << this->text[err.row] << std::endl;
+    out << BLUE << " --> " << RESET << "<row: " << err.row + 1 << ", col: " << err.col + 1 << ">"
+        << '\n';
 
-    std::ostringstream oss;
-    oss << " " << err.row + 1 << " | ";
-    int delta = oss.str().length() + err.col - 3;
-    std::cerr << BLUE << "  |" << std::string(delta, ' ') << "^" << RESET << std::endl << std::endl;
+    displaySourceLine(out, err.row, err.col);
 }
 
 /**
  * @brief 分发处理词法错误
- * @param err  词法错误实例
+ * @param out 缓冲输出
+ * @param err 词法错误实例
  */
-void ErrorReporter::displayLexErr(const LexError& err) const
+void ErrorReporter::displayLexErr(util::BufferedWriter& out, const LexError& err) const
 {
     switch (err.type)
     {
         default:
             break;
         case LexErrorType::UnknownToken:
-            displayUnknownType(err);
+            displayUnknownType(out, err);
             break;
     }
 }
@@ -57,6 +77,41 @@ void ErrorReporter::displayLexErr(const LexError& err) const
 
 /*---------------- ParseError ----------------*/
 
+/**
+ * @brief 分发处理不同种类语法错误
+ * @param type  语法错误种类
+ * @return 根据type返回特定的错误报告提示
+ */
+static auto displayParseErrorType(ParseErrorType type)
+    -> std::pair<std::string_view, std::string_view>
+{
+    switch (type)
+    {
+        case ParseErrorType::UnexpectToken:
+            return {"UnexpectedToken", "并非期望的 token"};
+    }
+    return {"Unknown", "未知错误"};
+}
+
+/**
+ * @brief 输出语法错误结果
+ * @param out 缓冲输出
+ * @param err 语法错误实例
+ */
+void ErrorReporter::displayParseErr(util::BufferedWriter& out, const ParseError& err) const
+{
+    auto pair = displayParseErrorType(err.type);
+    out << BOLD << RED << "Error[" << pair.first << "]" << RESET << BOLD << ": " << pair.second
+        << " '" << err.token << "'" << RESET << '\n';
+
+    out << BLUE << "--> " << RESET << "<row: " << err.row + 1 << ", col: " << err.col + 1 << ">"
+        << '\n';
+
+    displaySourceLine(out, err.row, err.col);
+
+    out << "    Details: " << err.msg << '\n' << '\n';
+}
+
 /*---------------- ParseError ----------------*/
 
 /*---------------- SemanticError ----------------*/
@@ -66,57 +121,55 @@ void ErrorReporter::displayLexErr(const LexError& err) const
  * @param type  语义错误种类
  * @return 根据type返回特定的错误报告提示
  */
-static auto displaySemanticErrorType(SemanticErrorType type) -> std::pair<std::string, std::string>
+static auto displaySemanticErrorType(SemanticErrorType type)
+    -> std::pair<std::string_view, std::string_view>
 {
     switch (type)
     {
         case SemanticErrorType::ArgCountMismatch:
-            return {std::string{"ArgMismatch"}, std::string{"函数参数个数不匹配"}};
+            return {"ArgMismatch", "函数参数个数不匹配"};
         case SemanticErrorType::VoidFuncReturnValue:
         case SemanticErrorType::FuncReturnTypeMismatch:
-            return {std::string{"FuncReturnMismatch"}, std::string{"函数返回值类型不匹配"}};
+            return {"FuncReturnMismatch", "函数返回值类型不匹配"};
         case SemanticErrorType::MissingReturnValue:
-            return {std::string{"MissingReturnValue"}, std::string{"函数有返回值但未返回任何值"}};
+            return {"MissingReturnValue", "函数有返回值但未返回任何值"};
         case SemanticErrorType::UndefinedFunctionCall:
-            return {std::string{"UndefinedFunction"}, std::string{"函数未定义"}};
+            return {"UndefinedFunction", "函数未定义"};
         case SemanticErrorType::UndeclaredVariable:
-            return {std::string{"UndeclaredVariable"}, std::string{"变量未声明"}};
+            return {"UndeclaredVariable", "变量未声明"};
         case SemanticErrorType::UninitializedVariable:
-            return {std::string{"UninitializedVariable"}, std::string{"变量未初始化"}};
+            return {"UninitializedVariable", "变量未初始化"};
         case SemanticErrorType::AssignToNonVariable:
-            return {std::string{"InvalidAssignment"}, std::string{"无效赋值语句"}};
+            return {"InvalidAssignment", "无效赋值语句"};
         case SemanticErrorType::AssignToUndeclaredVar:
-            return {std::string{"InvalidAssignment"}, std::string{"无效赋值语句"}};
+            return {"InvalidAssignment", "无效赋值语句"};
         case SemanticErrorType::TypeInferenceFailure:
-            return {std::string{"TypeInferenceFailure"},
-                    std::string{"变量无法通过自动类型推导确定类型"}};
+            return {"TypeInferenceFailure", "变量无法通过自动类型推导确定类型"};
         case SemanticErrorType::TypeMismatch:
-            return {std::string{"TypeMismatch"}, std::string{"变量类型不匹配"}};
+            return {"TypeMismatch", "变量类型不匹配"};
+        case SemanticErrorType::FuncRedefinition:
+            return {"FuncRedefinition", "函数重复定义"};
     }
+    return {"Unknown", "未知错误"};
 }
 
 /**
- * @brief 控制台输出语义错误结果
- * @param err  语义错误实例
+ * @brief 输出语义错误结果
+ * @param out 缓冲输出
+ * @param err 语义错误实例
  */
-void ErrorReporter::displaySemanticErr(const SemanticError& err) const
+void ErrorReporter::displaySemanticErr(util::BufferedWriter& out, const SemanticError& err) const
 {
     auto pair = displaySemanticErrorType(err.type);
-    std::cerr << BOLD << RED << "Error[" << pair.first << "]" << RESET << BOLD << ": "
-              << pair.second << RESET << std::endl;
-
-    std::cerr << BLUE << "--> " << RESET << "scope: " << err.scope_name << " <row: " << err.row + 1
-              << ", col: " << err.col + 1 << ">" << std::endl;
+    out << BOLD << RED << "Error[" << pair.first << "]" << RESET << BOLD << ": " << pair.second
+        << RESET << '\n';
 
-    std::cerr << BLUE << "  |  " << std::endl
-              << BLUE << " " << err.row + 1 << " | " << RESET << this->text[err.row] << std::endl;
+    out << BLUE << "--> " << RESET << "scope: " << err.scope_name << " <row: " << err.row + 1
+        << ", col: " << err.col + 1 << ">" << '\n';
 
-    std::ostringstream oss;
-    oss << " " << err.row + 1 << " | ";
-    int delta = oss.str().length() + err.col - 3;
-    std::cerr << BLUE << "  |" << std::string(delta, ' ') << "^" << RESET << std::endl << std::endl;
+    displaySourceLine(out, err.row, err.col);
 
-    std::cerr << "    Details: " << err.msg << std::endl << std::endl;
+    out << "    Details: " << err.msg << '\n' << '\n';
 }
 
 /*---------------- SemanticError ----------------*/
@@ -125,6 +178,138 @@ void ErrorReporter::displaySemanticErr(const SemanticError& err) const
 
 /*---------------- InternalError ----------------*/
 
+/*---------------- Structured ----------------*/
+
+// 结构化输出中一条诊断的分类字段
+struct DiagFields
+{
+    std::string_view phase;  // 所属阶段
+    std::string_view level;  // error / warning
+    std::string_view code;   // 错误码，与文本输出中方括号内的名字相同
+    std::string_view title;  // 错误种类的说明
+};
+
+static auto fieldsOf(const LexError& /*err*/) -> DiagFields
+{
+    // 词法错误只有 UnknownToken 一种，文本输出中也以 warning 报告
+    return {"lex", "warning", "UnknownToken", "识别到未知 token"};
+}
+
+static auto fieldsOf(const ParseError& err) -> DiagFields
+{
+    auto [code, title] = displayParseErrorType(err.type);
+    return {"parse", "error", code, title};
+}
+
+static auto fieldsOf(const SemanticError& err) -> DiagFields
+{
+    auto [code, title] = displaySemanticErrorType(err.type);
+    return {"semantic", "error", code, title};
+}
+
+/**
+ * @brief 以 JSON 或 SARIF 格式输出一组错误，字段直接取自错误实例
+ * @param json JSON 输出器
+ * @param errs 错误列表
+ */
+template <typename E>
+void ErrorReporter::displayStructured(util::JsonWriter& json, const std::list<E>& errs) const
+{
+    if (format == DiagFormat::Json)
+    {
+        json.beginObject().key("diagnostics").beginArray();
+        for (const auto& err : errs)
+        {
+            auto fields = fieldsOf(err);
+            json.beginObject();
+            json.key("phase").string(fields.phase);
+            json.key("level").string(fields.level);
+            json.key("code").string(fields.code);
+            json.key("title").string(fields.title);
+            json.key("message").string(err.msg);
+            json.key("file").string(file_name);
+            json.key("row").number(err.row + 1);
+            json.key("col").number(err.col + 1);
+            if constexpr (std::is_same_v<E, SemanticError>)
+            {
+                json.key("scope").string(err.scope_name);
+            }
+            else
+            {
+                json.key("token").string(err.token);
+            }
+            json.endObject();
+        }
+        json.endArray().endObject();
+        return;
+    }
+
+    json.beginObject();
+    json.key("version").string("2.1.0");
+    json.key("$schema").string("https://json.schemastore.org/sarif-2.1.0.json");
+    json.key("runs").beginArray().beginObject();
+    json.key("tool").beginObject().key("driver").beginObject();
+    json.key("name").string("toy_compiler");
+    json.endObject().endObject();
+    json.key("results").beginArray();
+    for (const auto& err : errs)
+    {
+        auto fields = fieldsOf(err);
+        json.beginObject();
+        json.key("ruleId").string(fields.code);
+        json.key("level").string(fields.level);
+        json.key("message").beginObject().key("text").string(err.msg).endObject();
+        json.key("locations").beginArray().beginObject();
+        json.key("physicalLocation").beginObject();
+        json.key("artifactLocation").beginObject().key("uri").string(file_name).endObject();
+        json.key("region").beginObject();
+        json.key("startLine").number(err.row + 1);
+        json.key("startColumn").number(err.col + 1);
+        json.endObject();
+        json.endObject();
+        json.endObject().endArray();
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject().endArray();
+    json.endObject();
+}
+
+/**
+ * @brief 按设定的格式输出一组错误：全部渲染到缓冲区，再成块写入标准错误输出
+ * @param errs 错误列表
+ */
+template <typename E>
+void ErrorReporter::display(const std::list<E>& errs) const
+{
+    util::BufferedWriter out{std::cerr};
+    if (format != DiagFormat::Human)
+    {
+        util::JsonWriter json{out};
+        displayStructured(json, errs);
+        out << '\n';
+        return;
+    }
+
+    for (const auto& err : errs)
+    {
+        if constexpr (std::is_same_v<E, SemanticError>)
+        {
+            displaySemanticErr(out, err);
+        }
+        else if constexpr (std::is_same_v<E, ParseError>)
+        {
+            displayParseErr(out, err);
+        }
+        else
+        {
+            displayLexErr(out, err);
+        }
+    }
+}
+
+/*---------------- Structured ----------------*/
+
 /*---------------- ErrorReporter ----------------*/
 
 ErrorReporter::ErrorReporter(const std::string& t)
@@ -199,25 +384,68 @@ void ErrorReporter::report(SemanticErrorType type, const std::string& msg, std::
 }
 
 /**
- * @brief 处理所有词法错误
+ * @brief 将另一个报告器中暂存的错误按原顺序追加到本报告器
+ * @param other 暂存错误的报告器，合并后为空
  */
-void ErrorReporter::displayLexErrs() const
+void ErrorReporter::merge(ErrorReporter&& other)
 {
-    for (const auto& lex_err : lex_errs)
+    lex_errs.splice(lex_errs.end(), other.lex_errs);
+    parse_errs.splice(parse_errs.end(), other.parse_errs);
+    semantic_errs.splice(semantic_errs.end(), other.semantic_errs);
+}
+
+/**
+ * @brief 将语义错误插入到已有语义错误之间
+ * @param errs (下标, 错误) 列表，按下标非降序排列；错误插入到插入前第 下标 个语义错误之前，
+ *             下标等于错误总数时追加到末尾，下标相同的错误保持列表中的顺序
+ */
+void ErrorReporter::insertSemanticErrs(std::vector<std::pair<std::size_t, SemanticError>>&& errs)
+{
+    auto it = semantic_errs.begin();
+    std::size_t idx = 0;
+    for (auto& [pos, err] : errs)
     {
-        displayLexErr(lex_err);
+        for (; idx < pos; ++idx)
+        {
+            ++it;
+        }
+        semantic_errs.insert(it, std::move(err));
     }
 }
 
+/**
+ * @brief 设置诊断信息的输出格式
+ * @param format    输出格式
+ * @param file_name 输入文件名，结构化输出中用作错误位置所在的文件
+ */
+void ErrorReporter::setFormat(DiagFormat format, std::string file_name)
+{
+    this->format = format;
+    this->file_name = std::move(file_name);
+}
+
+/**
+ * @brief 处理所有词法错误
+ */
+void ErrorReporter::displayLexErrs() const
+{
+    display(lex_errs);
+}
+
+/**
+ * @brief 处理所有语法错误
+ */
+void ErrorReporter::displayParseErrs() const
+{
+    display(parse_errs);
+}
+
 /**
  * @brief 处理所有语义错误
  */
 void ErrorReporter::displaySemanticErrs() const
 {
-    for (const auto& semantic_err : semantic_errs)
-    {
-        displaySemanticErr(semantic_err);
-    }
+    display(semantic_errs);
 }
 
 }  // namespace error
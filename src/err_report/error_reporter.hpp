@@ -1,14 +1,30 @@
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "error_type.hpp"
 
+namespace util
+{
+class BufferedWriter;
+class JsonWriter;
+}  // namespace util
+
 namespace error
 {
 
+// 诊断信息的输出格式
+enum class DiagFormat : std::uint8_t
+{
+    Human,  // 带源码行与定位符的文本
+    Json,   // {"diagnostics": [...]}
+    Sarif,  // SARIF 2.1.0
+};
+
 struct Error
 {
     std::string msg;  // error message
@@ -100,7 +116,7 @@ struct SemanticError : Error
 class ErrorReporter
 {
    public:
-    ErrorReporter() = delete;
+    ErrorReporter() = default;  // 不含原始文本，只用于暂存错误，之后通过 merge 并入
     explicit ErrorReporter(const std::string& t);
 
     ~ErrorReporter() = default;
@@ -115,6 +131,11 @@ class ErrorReporter
     void report(SemanticErrorType type, const std::string& msg, std::size_t r, std::size_t c,
                 const std::string& scope_name);
 
+    void merge(ErrorReporter&& other);
+    void insertSemanticErrs(std::vector<std::pair<std::size_t, SemanticError>>&& errs);
+
+    void setFormat(DiagFormat format, std::string file_name);
+
    public:
     void displayLexErrs() const;
     void displayParseErrs() const;
@@ -136,6 +157,16 @@ class ErrorReporter
     {
         return !semantic_errs.empty();
     }
+    [[nodiscard]]
+    auto semanticErrCount() const -> std::size_t
+    {
+        return semantic_errs.size();
+    }
+    [[nodiscard]]
+    auto errCount() const -> std::size_t
+    {
+        return lex_errs.size() + parse_errs.size() + semantic_errs.size();
+    }
 
    private:
     [[nodiscard]]
@@ -144,12 +175,22 @@ class ErrorReporter
         return !(lex_errs.empty() && parse_errs.empty() && parse_errs.empty());
     }
 
-    void displayLexErr(const LexError& err) const;
-    void displayUnknownType(const LexError& err) const;
+    template <typename E>
+    void display(const std::list<E>& errs) const;
+    template <typename E>
+    void displayStructured(util::JsonWriter& json, const std::list<E>& errs) const;
+
+    void displayLexErr(util::BufferedWriter& out, const LexError& err) const;
+    void displayUnknownType(util::BufferedWriter& out, const LexError& err) const;
 
-    void displaySemanticErr(const SemanticError& err) const;
+    void displayParseErr(util::BufferedWriter& out, const ParseError& err) const;
+    void displaySemanticErr(util::BufferedWriter& out, const SemanticError& err) const;
+    void displaySourceLine(util::BufferedWriter& out, std::size_t row, std::size_t col) const;
 
    private:
+    DiagFormat format = DiagFormat::Human;  // 诊断信息的输出格式
+    std::string file_name;                  // 输入文件名，结构化输出中的位置
+
     std::vector<std::string> text;           // 输入文件原始文本
     std::list<LexError> lex_errs;            // 词法错误列表
     std::list<ParseError> parse_errs;        // 语法错误列表
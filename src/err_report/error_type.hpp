@@ -39,6 +39,7 @@ enum class SemanticErrorType : std::uint8_t
     AssignToUndeclaredVar,   // 赋值给未声明变量
     TypeInferenceFailure,    // 变量无法通过自动类型推导确定类型
     TypeMismatch,            // 变量类型不匹配
+    FuncRedefinition,        // 函数重复定义
 
 };
 
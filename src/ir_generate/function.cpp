@@ -0,0 +1,385 @@
+#include "function.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "util/id_map.hpp"
+
+namespace ir
+{
+
+static auto endsBlock(OpCode op) -> bool
+{
+    return isCondJump(op) || op == OpCode::Goto || op == OpCode::Return;
+}
+
+/**
+ * @brief 由一个函数的四元式建立控制流图
+ * @param quads 函数的四元式，以函数名标号开始
+ * @param names 四元式中操作数所在的名字表，须比函数活得长
+ */
+Function::Function(std::vector<Quad> quads, NameTable& names)
+    : p_names(&names), code(std::move(quads))
+{
+    analyze();
+}
+
+auto Function::quadsOf(BlockId b) const -> std::span<const Quad>
+{
+    return std::span<const Quad>{code}.subspan(blocks[b].begin, blocks[b].end - blocks[b].begin);
+}
+
+auto Function::succs(BlockId b) const -> std::span<const BlockId>
+{
+    return std::span<const BlockId>{succ_list}.subspan(succ_first[b],
+                                                       succ_first[b + 1] - succ_first[b]);
+}
+
+auto Function::preds(BlockId b) const -> std::span<const BlockId>
+{
+    return std::span<const BlockId>{pred_list}.subspan(pred_first[b],
+                                                       pred_first[b + 1] - pred_first[b]);
+}
+
+auto Function::domChildren(BlockId b) const -> std::span<const BlockId>
+{
+    return std::span<const BlockId>{child_list}.subspan(child_first[b],
+                                                        child_first[b + 1] - child_first[b]);
+}
+
+/**
+ * @brief  判断 a 是否支配 b (每个块都支配自身)
+ * @param  a 块号
+ * @param  b 块号
+ * @return 两块都可达且 a 支配 b 时为 true
+ */
+auto Function::dominates(BlockId a, BlockId b) const -> bool
+{
+    if (!reachable(a) || !reachable(b))
+    {
+        return false;
+    }
+    return dom_in[a] <= dom_in[b] && dom_in[b] < dom_out[a];
+}
+
+/**
+ * @brief 由当前的四元式重新建立基本块、控制流图与支配树
+ */
+void Function::analyze()
+{
+    buildCfg();
+    buildDominators();
+}
+
+/**
+ * @brief 由当前的四元式重新划分基本块并建立控制流图
+ */
+void Function::buildCfg()
+{
+    blocks.clear();
+    succ_first.clear();
+    succ_list.clear();
+    pred_first.clear();
+    pred_list.clear();
+    splitBlocks();
+    buildEdges();
+}
+
+/**
+ * @brief 由当前的控制流图重新求逆后序与支配树
+ */
+void Function::buildDominators()
+{
+    rpo_order.clear();
+    child_list.clear();
+    computeDominators();
+}
+
+/**
+ * @brief 整体替换函数的四元式，之后须重建控制流图与支配树
+ * @param quads 新的四元式，以函数名标号开始
+ */
+void Function::setQuads(std::vector<Quad> quads)
+{
+    if (ssa)
+    {
+        throw std::runtime_error{"SSA 形式下不能整体替换四元式"};
+    }
+    code = std::move(quads);
+}
+
+/**
+ * @brief   删去标记的四元式
+ * @details 块的划分与控制流图保持不变，只更新各块的范围，因此块可能变空。
+ *          调用者须保证删去的四元式不是标号、跳转或返回
+ * @param   dead 下标为四元式在函数中的位置，置位的被删去
+ */
+void Function::removeQuads(const util::BitVector& dead)
+{
+    std::uint32_t kept = 0;
+    for (auto& block : blocks)
+    {
+        auto begin = kept;
+        for (auto i = block.begin; i < block.end; ++i)
+        {
+            if (!dead.test(i))
+            {
+                code[kept++] = code[i];
+            }
+        }
+        block = BasicBlock{begin, kept};
+    }
+    code.resize(kept);
+}
+
+/**
+ * @brief 输出函数的四元式
+ * @param out 输出文件流
+ */
+void Function::print(std::ofstream& out) const
+{
+    util::BufferedWriter sink{out};
+    for (const auto& quad : code)
+    {
+        printQuad(sink, *p_names, quad);
+    }
+}
+
+/**
+ * @brief 在标号处及跳转、返回之后切分基本块
+ */
+void Function::splitBlocks()
+{
+    for (std::uint32_t i = 0; i < code.size(); ++i)
+    {
+        bool leader = i == 0 || code[i].op == OpCode::Label || endsBlock(code[i - 1].op);
+        if (leader)
+        {
+            if (!blocks.empty())
+            {
+                blocks.back().end = i;
+            }
+            blocks.push_back(BasicBlock{i, i});
+        }
+    }
+    if (!blocks.empty())
+    {
+        blocks.back().end = static_cast<std::uint32_t>(code.size());
+    }
+}
+
+/**
+ * @brief 解析跳转目标，建立后继表与前驱表
+ */
+void Function::buildEdges()
+{
+    // 标号只出现在块首，因此每个标号对应唯一的块
+    util::IdMap<BlockId> label_block;
+    for (BlockId b = 0; b < blocks.size(); ++b)
+    {
+        const auto& first = code[blocks[b].begin];
+        if (first.op == OpCode::Label)
+        {
+            label_block.insertOrAssign(first.arg1.value, b);
+        }
+    }
+
+    auto target = [&](Operand label) -> BlockId
+    {
+        const auto* p_block = label_block.find(label.value);
+        if (p_block == nullptr)
+        {
+            throw std::runtime_error{"跳转到函数中不存在的标号"};
+        }
+        return *p_block;
+    };
+
+    succ_first.reserve(blocks.size() + 1);
+    succ_first.push_back(0);
+    for (BlockId b = 0; b < blocks.size(); ++b)
+    {
+        const auto& last = code[blocks[b].end - 1];
+        BlockId next = b + 1 < blocks.size() ? b + 1 : NO_BLOCK;
+        if (last.op == OpCode::Goto)
+        {
+            succ_list.push_back(target(last.arg1));
+        }
+        else if (isCondJump(last.op))
+        {
+            auto taken = target(last.res);
+            succ_list.push_back(taken);
+            if (next != NO_BLOCK && next != taken)
+            {
+                succ_list.push_back(next);
+            }
+        }
+        else if (last.op != OpCode::Return && next != NO_BLOCK)
+        {
+            succ_list.push_back(next);
+        }
+        succ_first.push_back(static_cast<std::uint32_t>(succ_list.size()));
+    }
+
+    // 计数后按块号顺序填入前驱
+    pred_first.assign(blocks.size() + 1, 0);
+    for (auto s : succ_list)
+    {
+        ++pred_first[s + 1];
+    }
+    std::partial_sum(pred_first.begin(), pred_first.end(), pred_first.begin());
+    pred_list.resize(succ_list.size());
+    std::vector<std::uint32_t> fill(pred_first.begin(), pred_first.end() - 1);
+    for (BlockId b = 0; b < blocks.size(); ++b)
+    {
+        for (auto s : succs(b))
+        {
+            pred_list[fill[s]++] = b;
+        }
+    }
+}
+
+/**
+ * @brief   求逆后序与支配树
+ * @details Semi-NCA 算法：先按深度优先先序自后向前求半支配者 (带路径压缩的森林)，
+ *          再自前向后沿生成树上溯，取父结点链上第一个不大于半支配者的结点为直接支配者。
+ *          以下除 vertex 外的数组都以先序编号为下标
+ */
+void Function::computeDominators()
+{
+    constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+    auto n = blocks.size();
+    idoms.assign(n, NO_BLOCK);
+    dom_in.assign(n, 0);
+    dom_out.assign(n, 0);
+    child_first.assign(n + 1, 0);
+    if (n == 0)
+    {
+        return;
+    }
+
+    struct Frame
+    {
+        BlockId b;
+        std::uint32_t edge;  // 下一条待访问的出边
+    };
+
+    // Step1. 深度优先遍历：先序编号供求支配者使用，后序的逆序即逆后序
+    std::vector<std::uint32_t> pre(n, NONE);
+    std::vector<BlockId> vertex{0};       // 先序编号 -> 块号
+    std::vector<std::uint32_t> parent{0};  // 生成树上的父结点
+    std::vector<Frame> frames{Frame{0, 0}};
+    pre[0] = 0;
+    while (!frames.empty())
+    {
+        auto& top = frames.back();
+        auto out = succs(top.b);
+        if (top.edge < out.size())
+        {
+            auto s = out[top.edge++];
+            if (pre[s] == NONE)
+            {
+                pre[s] = static_cast<std::uint32_t>(vertex.size());
+                parent.push_back(pre[top.b]);
+                vertex.push_back(s);
+                frames.push_back(Frame{s, 0});
+            }
+            continue;
+        }
+        rpo_order.push_back(top.b);
+        frames.pop_back();
+    }
+    std::ranges::reverse(rpo_order);
+
+    // Step2. 求半支配者
+    auto m = static_cast<std::uint32_t>(vertex.size());
+    std::vector<std::uint32_t> semi(m);
+    std::vector<std::uint32_t> label(m);
+    std::vector<std::uint32_t> ancestor(m, NONE);
+    std::iota(semi.begin(), semi.end(), 0);
+    std::iota(label.begin(), label.end(), 0);
+
+    std::vector<std::uint32_t> path;
+    auto eval = [&](std::uint32_t v) -> std::uint32_t
+    {
+        if (ancestor[v] == NONE)
+        {
+            return v;
+        }
+        // 路径压缩：自靠近根的一端起，让路径上的结点直接指向森林的根
+        path.clear();
+        for (auto x = v; ancestor[ancestor[x]] != NONE; x = ancestor[x])
+        {
+            path.push_back(x);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it)
+        {
+            auto x = *it;
+            auto a = ancestor[x];
+            if (semi[label[a]] < semi[label[x]])
+            {
+                label[x] = label[a];
+            }
+            ancestor[x] = ancestor[a];
+        }
+        return label[v];
+    };
+
+    for (auto w = m - 1; w > 0; --w)
+    {
+        for (auto p : preds(vertex[w]))
+        {
+            if (pre[p] != NONE)
+            {
+                semi[w] = std::min(semi[w], semi[eval(pre[p])]);
+            }
+        }
+        ancestor[w] = parent[w];
+    }
+
+    // Step3. 直接支配者是父结点链上第一个先序编号不大于半支配者的结点
+    std::vector<std::uint32_t> idom_pre(m, 0);
+    for (std::uint32_t i = 1; i < m; ++i)
+    {
+        auto x = parent[i];
+        while (x > semi[i])
+        {
+            x = idom_pre[x];
+        }
+        idom_pre[i] = x;
+        idoms[vertex[i]] = vertex[x];
+    }
+
+    // Step4. 建立支配树的孩子表，并求先序区间以 O(1) 判断支配关系
+    for (std::uint32_t i = 1; i < m; ++i)
+    {
+        ++child_first[idoms[vertex[i]] + 1];
+    }
+    std::partial_sum(child_first.begin(), child_first.end(), child_first.begin());
+    child_list.resize(m - 1);
+    std::vector<std::uint32_t> fill(child_first.begin(), child_first.end() - 1);
+    for (std::uint32_t i = 1; i < m; ++i)
+    {
+        child_list[fill[idoms[vertex[i]]]++] = vertex[i];
+    }
+
+    std::uint32_t counter = 0;
+    frames.push_back(Frame{0, 0});
+    dom_in[0] = counter++;
+    while (!frames.empty())
+    {
+        auto& top = frames.back();
+        auto children = domChildren(top.b);
+        if (top.edge < children.size())
+        {
+            auto c = children[top.edge++];
+            dom_in[c] = counter++;
+            frames.push_back(Frame{c, 0});
+            continue;
+        }
+        dom_out[top.b] = counter;
+        frames.pop_back();
+    }
+}
+
+}  // namespace ir
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "quad.hpp"
+#include "util/bit_vector.hpp"
+
+namespace ir
+{
+
+using BlockId = std::uint32_t;
+
+// 基本块：Function 四元式序列中连续的一段，[begin, end)
+struct BasicBlock
+{
+    std::uint32_t begin;
+    std::uint32_t end;
+};
+
+// φ 函数：args 与所在块的前驱一一对应，前驱上没有定值到达时为空操作数
+struct Phi
+{
+    Operand res;
+    std::uint32_t var;  // 变量的函数内编号
+    std::vector<Operand> args;
+};
+
+// 一个函数的四元式及其控制流图
+// 四元式在标号处开始新块，在跳转与返回之后结束当前块；跳转目标在构造时解析为块号。
+// 条件跳转的后继依次为跳转目标与下一块，两者相同时只记一次。前驱与后继以 CSR 形式存放。
+// 逆后序与支配树只覆盖从入口 (0 号块) 可达的块。支配树用 Semi-NCA 算法求出，
+// 深度优先遍历与路径压缩都以显式栈实现，很大的控制流图也不会耗尽线程栈。
+// toSsa / fromSsa 进行 SSA 的构造与消去 (见 ssa.cpp)，之后控制流图随四元式一并更新。
+// 优化遍可以原地改写操作数、删去四元式 (块的划分不变) 或整体替换四元式；整体替换后控制流图
+// 与支配树失效，须由 buildCfg / buildDominators 重建 (通常由 AnalysisManager 按需调用)
+class Function
+{
+   public:
+    static constexpr BlockId NO_BLOCK = std::numeric_limits<BlockId>::max();
+
+    Function(std::vector<Quad> quads, NameTable& names);
+
+   public:
+    [[nodiscard]] auto quads() const -> std::span<const Quad> { return code; }
+    [[nodiscard]] auto quads() -> std::span<Quad> { return code; }
+    [[nodiscard]] auto numBlocks() const -> std::size_t { return blocks.size(); }
+    [[nodiscard]] auto block(BlockId b) const -> const BasicBlock& { return blocks[b]; }
+    [[nodiscard]] auto quadsOf(BlockId b) const -> std::span<const Quad>;
+
+    [[nodiscard]] auto succs(BlockId b) const -> std::span<const BlockId>;
+    [[nodiscard]] auto preds(BlockId b) const -> std::span<const BlockId>;
+
+    [[nodiscard]] auto rpo() const -> const std::vector<BlockId>& { return rpo_order; }
+    [[nodiscard]] auto reachable(BlockId b) const -> bool { return b == 0 || idoms[b] != NO_BLOCK; }
+
+    [[nodiscard]] auto idom(BlockId b) const -> BlockId { return idoms[b]; }
+    [[nodiscard]] auto domChildren(BlockId b) const -> std::span<const BlockId>;
+    [[nodiscard]] auto dominates(BlockId a, BlockId b) const -> bool;
+
+    [[nodiscard]] auto names() const -> const NameTable& { return *p_names; }
+
+    void toSsa();
+    void fromSsa();
+    [[nodiscard]] auto inSsa() const -> bool { return ssa; }
+    [[nodiscard]] auto phisOf(BlockId b) const -> std::span<const Phi>;
+    [[nodiscard]] auto phisOf(BlockId b) -> std::span<Phi>;
+
+    void setQuads(std::vector<Quad> quads);
+    void removeQuads(const util::BitVector& dead);
+
+    /**
+     * @brief  删去满足条件的 φ 函数
+     * @param  pred 谓词 (const Phi&) -> bool
+     * @return 删去的个数
+     */
+    template <typename Pred>
+    auto erasePhis(Pred pred) -> std::size_t
+    {
+        std::size_t cnt = 0;
+        for (auto& block_phis : phis)
+        {
+            cnt += std::erase_if(block_phis, pred);
+        }
+        return cnt;
+    }
+
+    void buildCfg();
+    void buildDominators();
+
+    void print(std::ofstream& out) const;
+
+   private:
+    using CopyList = std::vector<std::pair<Operand, Operand>>;  // (目标, 源) 的并行复制
+
+    void analyze();
+    void splitBlocks();
+    void buildEdges();
+    void computeDominators();
+
+    void compact();
+    [[nodiscard]] auto dominanceFrontiers() const -> std::vector<std::vector<BlockId>>;
+    [[nodiscard]] auto predIndex(BlockId b, BlockId pred) const -> std::size_t;
+    auto newTemp() -> Operand;
+    void edgeCopies(BlockId from, BlockId to, CopyList& copies) const;
+    void sequentialize(const CopyList& copies, std::vector<Quad>& out);
+
+   private:
+    NameTable* p_names;
+    std::vector<Quad> code;
+    std::vector<BasicBlock> blocks;
+
+    // 后继表 succ_list[succ_first[b], succ_first[b + 1])，前驱表同理
+    std::vector<std::uint32_t> succ_first;
+    std::vector<BlockId> succ_list;
+    std::vector<std::uint32_t> pred_first;
+    std::vector<BlockId> pred_list;
+
+    std::vector<BlockId> rpo_order;
+
+    std::vector<BlockId> idoms;  // 直接支配者，入口与不可达块为 NO_BLOCK
+    std::vector<std::uint32_t> child_first;
+    std::vector<BlockId> child_list;
+    std::vector<std::uint32_t> dom_in;  // 支配树上的先序区间 [dom_in, dom_out)
+    std::vector<std::uint32_t> dom_out;
+
+    bool ssa = false;
+    std::vector<std::vector<Phi>> phis;  // 各块的 φ 函数，只在 SSA 形式下非空
+    std::uint32_t next_temp = 0;         // 新临时变量的编号
+    std::uint32_t split_cnt = 0;         // 拆分关键边时生成的标号个数
+};
+
+}  // namespace ir
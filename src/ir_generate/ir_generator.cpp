@@ -1,42 +1,70 @@
 #include "ir_generator.hpp"
 
 #include <cassert>
-#include <regex>
+#include <string_view>
+
+#include "function.hpp"
+#include "pass_manager.hpp"
+#include "semantic_check/symbol_table.hpp"
+#include "util/buffered_writer.hpp"
 
 using namespace parser::ast;
 
 namespace ir
 {
 
-static const Operand NULL_OPERAND{std::string{"-"}};
+static constexpr Operand NULL_OPERAND{};
+static constexpr Operand I32_OPERAND{Operand::Kind::Type, 0};
 
-void IrGenerator::setSymbolTable(std::shared_ptr<symbol::SymbolTable> p_stable)
+/**
+ * @brief  取当前作用域中变量的操作数
+ * @param  var_name 变量名
+ * @param  p_symbol 语义检查标注的变量符号
+ * @return 文本为 "作用域全名::变量名" 的变量操作数
+ */
+auto IrGenerator::getVar(std::string_view var_name, const symbol::Variable* p_symbol) -> Operand
 {
-    this->p_stable = std::move(p_stable);
+    assert(p_symbol != nullptr);
+    name_buf.assign(*p_scope);
+    name_buf.append("::");
+    name_buf.append(var_name);
+    return names.var(name_buf, p_symbol->local_id);
 }
 
-auto IrGenerator::getVarName(const std::string& var_name) const -> std::string
+/**
+ * @brief  取标号的操作数
+ * @param  prefix 标号前缀 (语句的标号或函数名)
+ * @param  suffix 标号后缀
+ * @return 以 "前缀后缀" 在名字表中的编号表示的操作数
+ */
+auto IrGenerator::getLabel(std::string_view prefix, std::string_view suffix) -> Operand
 {
-    return std::format("{}::{}", p_stable->getCurScope(), var_name);
+    name_buf.assign(prefix);
+    name_buf.append(suffix);
+    return names.label(name_buf);
 }
 
-auto IrGenerator::getFuncName() const -> std::string
+auto IrGenerator::getTempVal() -> Operand
 {
-    std::regex re{R"(^global::(\w*))"};
-    std::smatch match;
-    std::regex_search(p_stable->getCurScope(), match, re);
-    return match[1];
+    return Operand::temp(tv_cnt++);
 }
 
-void IrGenerator::pushQuads(OpCode op, const Operand& arg1, const Operand& arg2, const Operand& res)
+void IrGenerator::pushQuads(OpCode op, Operand arg1, Operand arg2, Operand res)
 {
-    quads.emplace_back(op, arg1, arg2, res);
+    if (op == OpCode::Label || op == OpCode::Goto || isCondJump(op) || op == OpCode::Call)
+    {  // 跳转与标号划分基本块；被调函数可能经可变引用修改变量
+        forgetExprs();
+    }
+    quads.push_back(Quad{op, arg1, arg2, res});
 }
 
-static auto replaceScopeQualifiers(const std::string& str) -> std::string
+/**
+ * @brief 丢弃已求值的共享结点，其后再遇到时重新计算
+ */
+void IrGenerator::forgetExprs()
 {
-    std::regex re{"::"};
-    return std::regex_replace(str, re, "_");
+    expr_temps.clear();
+    expr_reads.clear();
 }
 
 void IrGenerator::generateProg(const ProgPtr& p_prog)
@@ -51,14 +79,17 @@ void IrGenerator::generateProg(const ProgPtr& p_prog)
 
 void IrGenerator::generateFuncDecl(const FuncDeclPtr& p_fdecl)
 {
-    p_stable->enterScope(p_fdecl->header->name, false);
+    func_begins.push_back(quads.size());
+    tv_cnt = 0;
+    forgetExprs();
+    p_scope = &p_fdecl->body->scope;  // 形参声明在函数体所在的函数作用域中
     generateFuncHeaderDecl(std::dynamic_pointer_cast<FuncHeaderDecl>(p_fdecl->header));
     bool has_ret = generateBlockStmt(std::dynamic_pointer_cast<BlockStmt>(p_fdecl->body));
     if (!has_ret)
     {
         pushQuads(OpCode::Return, NULL_OPERAND, NULL_OPERAND, NULL_OPERAND);
     }
-    p_stable->exitScope();
+    p_scope = nullptr;
 }
 
 void IrGenerator::generateFuncHeaderDecl(const FuncHeaderDeclPtr& p_fhdecl)
@@ -66,17 +97,18 @@ void IrGenerator::generateFuncHeaderDecl(const FuncHeaderDeclPtr& p_fhdecl)
     // 函数声明对应的四元式分为两部分
     // 1. 函数名对应的标号；
     // 2. 构建参数
-    pushQuads(OpCode::Label, p_fhdecl->name, NULL_OPERAND, NULL_OPERAND);
+    pushQuads(OpCode::Label, getLabel(p_fhdecl->name), NULL_OPERAND, NULL_OPERAND);
     for (const auto& arg : p_fhdecl->argv)
     {
-        pushQuads(OpCode::Pop, NULL_OPERAND, NULL_OPERAND, getVarName(arg->variable->name));
+        auto param = getVar(arg->variable->name, arg->variable->p_symbol);
+        pushQuads(OpCode::Pop, NULL_OPERAND, NULL_OPERAND, param);
     }
 }
 
 auto IrGenerator::generateBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
 {
-    int if_cnt = 1;
-    int while_cnt = 1;
+    const auto* p_outer = p_scope;
+    p_scope = &p_bstmt->scope;
 
     for (const auto& p_stmt : p_bstmt->stmts)
     {
@@ -89,6 +121,7 @@ auto IrGenerator::generateBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
                 break;
             case NodeType::RetStmt:
                 generateRetStmt(std::dynamic_pointer_cast<RetStmt>(p_stmt));
+                p_scope = p_outer;
                 return true;
                 // break;
             case NodeType::ExprStmt:
@@ -98,20 +131,17 @@ auto IrGenerator::generateBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
                 generateAssignStmt(std::dynamic_pointer_cast<AssignStmt>(p_stmt));
                 break;
             case NodeType::IfStmt:
-                p_stable->enterScope(std::format("if{}", if_cnt++), false);
                 generateIfStmt(std::dynamic_pointer_cast<IfStmt>(p_stmt));
-                p_stable->exitScope();
                 break;
             case NodeType::WhileStmt:
-                p_stable->enterScope(std::format("while{}", while_cnt++), false);
                 generateWhileStmt(std::dynamic_pointer_cast<WhileStmt>(p_stmt));
-                p_stable->exitScope();
                 break;
             case NodeType::NullStmt:
                 break;
         }
     }
 
+    p_scope = p_outer;
     return false;
 }
 
@@ -125,25 +155,19 @@ void IrGenerator::generateVarDeclStmt(const VarDeclStmtPtr& p_vdstmt)
 
     // 由于暂时只有 i32 类型，因此这里直接将所有变量声明为 i32 的
     // 这样假设的前提是所有异常都已经被检查出
-    pushQuads(OpCode::Decl, getVarName(p_vdstmt->variable->name), std::string{"i32"}, NULL_OPERAND);
+    const auto& p_body = p_vdstmt->variable;
+    pushQuads(OpCode::Decl, getVar(p_body->name, p_body->p_symbol), I32_OPERAND, NULL_OPERAND);
 }
 
 void IrGenerator::generateRetStmt(const RetStmtPtr& p_rstmt)
 {
-    auto p_func = p_stable->lookupFunc(getFuncName());
-    assert(p_func.has_value());
-
-    std::string name;
-    if (p_func.value()->retval_type == symbol::VarType::Null)
+    // 语义检查已保证有返回值表达式当且仅当函数有返回类型
+    Operand value = NULL_OPERAND;
+    if (p_rstmt->ret_val.has_value())
     {
-        assert(!p_rstmt->ret_val.has_value());
-        name = "-";
+        value = generateExpr(p_rstmt->ret_val.value());
     }
-    else
-    {
-        name = generateExpr(p_rstmt->ret_val.value());
-    }
-    pushQuads(OpCode::Return, name, NULL_OPERAND, NULL_OPERAND);
+    pushQuads(OpCode::Return, value, NULL_OPERAND, NULL_OPERAND);
 }
 
 void IrGenerator::generateExprStmt(const ExprStmtPtr& p_estmt)
@@ -160,10 +184,16 @@ void IrGenerator::generateExprStmt(const ExprStmtPtr& p_estmt)
 
 /**
  *
- * @return 返回表达式结果所存储的临时变量名
+ * @return 返回表达式结果所在的操作数
  */
-auto IrGenerator::generateExpr(const ExprPtr& p_expr) -> std::string
+auto IrGenerator::generateExpr(const ExprPtr& p_expr) -> Operand
 {
+    // 语义检查时已折叠为常量的表达式直接使用其值
+    if (p_expr->const_val.has_value())
+    {
+        return Operand::imm(p_expr->const_val.value());
+    }
+
     switch (p_expr->type())
     {
         default:
@@ -183,22 +213,27 @@ auto IrGenerator::generateExpr(const ExprPtr& p_expr) -> std::string
     }
 }
 
-auto IrGenerator::generateCallExpr(const CallExprPtr& p_caexpr) -> std::string
+auto IrGenerator::generateCallExpr(const CallExprPtr& p_caexpr) -> Operand
 {
+    // 编译期已求值的纯函数调用不产生任何四元式
+    if (p_caexpr->const_val.has_value())
+    {
+        return Operand::imm(p_caexpr->const_val.value());
+    }
+
     // Step1. 获取函数符号指针
-    std::string func_name = p_caexpr->callee;
-    auto p_func = p_stable->lookupFunc(func_name);
-    assert(p_func.has_value());
+    const auto* p_func = p_caexpr->p_func;
+    assert(p_func != nullptr);
 
     // Step2. 检查函数是否有返回值
-    std::string rv_name{"-"};
-    if (p_func.value()->retval_type != symbol::VarType::Null)
+    Operand rv = NULL_OPERAND;
+    if (p_func->retval_type != symbol::VarType::Null)
     {
-        rv_name = p_stable->getTempValName();
+        rv = getTempVal();
     }
 
     // Step3. 为函数构造形参
-    std::vector<std::string> argv;
+    std::vector<Operand> argv;
     for (const auto& p_expr : p_caexpr->argv)
     {
         argv.push_back(generateExpr(p_expr));
@@ -208,18 +243,23 @@ auto IrGenerator::generateCallExpr(const CallExprPtr& p_caexpr) -> std::string
         pushQuads(OpCode::Push, arg, NULL_OPERAND, NULL_OPERAND);
     }
 
-    pushQuads(OpCode::Call, func_name, NULL_OPERAND, rv_name);
+    pushQuads(OpCode::Call, getLabel(p_caexpr->callee), NULL_OPERAND, rv);
 
-    return rv_name;
+    return rv;
 }
 
-auto IrGenerator::generateComparExpr(const ComparExprPtr& p_coexpr) -> std::string
+auto IrGenerator::generateComparExpr(const ComparExprPtr& p_coexpr) -> Operand
 {
     // 调用到该函数的情况都不是比较表达式作为控制条件的情况
-    std::string lhs = generateExpr(p_coexpr->lhs);
-    std::string rhs = generateExpr(p_coexpr->rhs);
+    if (auto it = expr_temps.find(p_coexpr.get()); it != expr_temps.end())
+    {  // 同一基本块内已求值的共享结点，其读过的变量此后未被赋值
+        return it->second;
+    }
 
-    std::string rv_name = p_stable->getTempValName();
+    Operand lhs = generateExpr(p_coexpr->lhs);
+    Operand rhs = generateExpr(p_coexpr->rhs);
+
+    Operand rv = getTempVal();
     OpCode op;
     switch (p_coexpr->op)
     {
@@ -243,17 +283,26 @@ auto IrGenerator::generateComparExpr(const ComparExprPtr& p_coexpr) -> std::stri
             break;
     }
 
-    pushQuads(op, lhs, rhs, rv_name);
-    return rv_name;
+    pushQuads(op, lhs, rhs, rv);
+    if (reuse_exprs)
+    {
+        expr_temps.emplace(p_coexpr.get(), rv);
+    }
+    return rv;
 }
 
-auto IrGenerator::generateArithExpr(const ArithExprPtr& p_aexpr) -> std::string
+auto IrGenerator::generateArithExpr(const ArithExprPtr& p_aexpr) -> Operand
 {
     // 调用到该函数的情况都不是比较表达式作为控制条件的情况
-    std::string lhs = generateExpr(p_aexpr->lhs);
-    std::string rhs = generateExpr(p_aexpr->rhs);
+    if (auto it = expr_temps.find(p_aexpr.get()); it != expr_temps.end())
+    {  // 同一基本块内已求值的共享结点，其读过的变量此后未被赋值
+        return it->second;
+    }
 
-    std::string rv_name = p_stable->getTempValName();
+    Operand lhs = generateExpr(p_aexpr->lhs);
+    Operand rhs = generateExpr(p_aexpr->rhs);
+
+    Operand rv = getTempVal();
     OpCode op;
     switch (p_aexpr->op)
     {
@@ -271,27 +320,40 @@ auto IrGenerator::generateArithExpr(const ArithExprPtr& p_aexpr) -> std::string
             break;
     }
 
-    pushQuads(op, lhs, rhs, rv_name);
-    return rv_name;
+    pushQuads(op, lhs, rhs, rv);
+    if (reuse_exprs)
+    {
+        expr_temps.emplace(p_aexpr.get(), rv);
+    }
+    return rv;
 }
 
 void IrGenerator::generateAssignStmt(const AssignStmtPtr& p_astmt)
 {
-    std::string rvalue_name = generateExpr(p_astmt->expr);
+    Operand rvalue = generateExpr(p_astmt->expr);
     auto p_lvalue = std::dynamic_pointer_cast<Variable>(p_astmt->lvalue);
     assert(p_lvalue);
-    std::string lvalue_name = getVarName(p_lvalue->name);
+    Operand lvalue = getVar(p_lvalue->name, p_lvalue->p_symbol);
+    if (expr_reads.contains(p_lvalue->p_symbol->local_id))
+    {  // 读过该变量的结点的值已过时
+        forgetExprs();
+    }
 
-    pushQuads(OpCode::Assign, rvalue_name, NULL_OPERAND, lvalue_name);
+    pushQuads(OpCode::Assign, rvalue, NULL_OPERAND, lvalue);
 }
 
-auto IrGenerator::generateFactor(const FactorPtr& p_factor) -> std::string
+auto IrGenerator::generateFactor(const FactorPtr& p_factor) -> Operand
 {
     return generateElement(p_factor->element);
 }
 
-auto IrGenerator::generateElement(const parser::ast::ExprPtr& p_element) -> std::string
+auto IrGenerator::generateElement(const parser::ast::ExprPtr& p_element) -> Operand
 {
+    if (p_element->const_val.has_value())
+    {
+        return Operand::imm(p_element->const_val.value());
+    }
+
     switch (p_element->type())
     {
         default:
@@ -308,43 +370,59 @@ auto IrGenerator::generateElement(const parser::ast::ExprPtr& p_element) -> std:
 }
 
 auto IrGenerator::generateParenthesisExpr(const parser::ast::ParenthesisExprPtr& p_pexpr)
-    -> std::string
+    -> Operand
 {
     return generateExpr(p_pexpr->expr);
 }
 
-auto IrGenerator::generateNumber(const parser::ast::NumberPtr& p_number) -> std::string
+auto IrGenerator::generateNumber(const parser::ast::NumberPtr& p_number) -> Operand
 {
-    // auto tv_name = p_stable->getTempValName();
+    // auto tv_name = getTempValName();
     // pushQuads(OpCode::Assign, std::format("{}", p_number->value), NULL_OPERAND, tv_name);
     // return tv_name;
-    return std::to_string(p_number->value);
+    return Operand::imm(p_number->value);
 }
 
-auto IrGenerator::generateVariable(const parser::ast::VariablePtr& p_variable) -> std::string
+auto IrGenerator::generateVariable(const parser::ast::VariablePtr& p_variable) -> Operand
 {
-    return getVarName(p_variable->name);
+    if (reuse_exprs)
+    {
+        expr_reads.insert(p_variable->p_symbol->local_id);
+    }
+    return getVar(p_variable->name, p_variable->p_symbol);
 }
 
 // 假定标号支持前向声明
 void IrGenerator::generateIfStmt(const IfStmtPtr& p_istmt)
 {
-    std::string label_true =
-        std::format("{}_true", replaceScopeQualifiers(p_stable->getCurScope()));
-    std::string label_false =
-        std::format("{}_false", replaceScopeQualifiers(p_stable->getCurScope()));
-    std::string label_end = std::format("{}_end", replaceScopeQualifiers(p_stable->getCurScope()));
-
-    std::string lhs;
-    std::string rhs;
+    // 条件为常量时只生成会执行的分支
+    if (p_istmt->expr->const_val.has_value())
+    {
+        if (p_istmt->expr->const_val.value() != 0)
+        {
+            generateBlockStmt(p_istmt->if_branch);
+        }
+        else if (!p_istmt->else_clauses.empty())
+        {
+            generateBlockStmt(p_istmt->else_clauses[0]->block);
+        }
+        return;
+    }
+
+    Operand label_true = getLabel(p_istmt->label, "_true");
+    Operand label_false = getLabel(p_istmt->label, "_false");
+    Operand label_end = getLabel(p_istmt->label, "_end");
+
+    Operand lhs;
+    Operand rhs;
     OpCode op;  // 跳转到 true
 
+    // 条件表达式位于 if 语句所在的作用域中
     // 如果 if 语句的判断条件并非比较表达式，则使用 jne condition 0 来跳转到 if 分支
-    std::string scope = p_stable->exitScope();
     if (p_istmt->expr->type() != NodeType::ComparExpr)
     {
         lhs = generateExpr(p_istmt->expr);
-        rhs = "0";
+        rhs = Operand::imm(0);
         op = OpCode::Jne;
     }
     else
@@ -375,7 +453,6 @@ void IrGenerator::generateIfStmt(const IfStmtPtr& p_istmt)
                 break;
         }
     }
-    p_stable->enterScope(scope, false);
 
     pushQuads(op, lhs, rhs, label_true);
 
@@ -408,21 +485,35 @@ void IrGenerator::generateIfStmt(const IfStmtPtr& p_istmt)
 
 void IrGenerator::generateWhileStmt(const WhileStmtPtr& p_wstmt)
 {
-    std::string label_start =
-        std::format("{}_start", replaceScopeQualifiers(p_stable->getCurScope()));
-    std::string label_end = std::format("{}_end", replaceScopeQualifiers(p_stable->getCurScope()));
+    // 条件恒假的循环不生成；条件恒真的循环省去条件跳转
+    const auto& cond = p_wstmt->expr->const_val;
+    if (cond.has_value() && cond.value() == 0)
+    {
+        return;
+    }
+
+    Operand label_start = getLabel(p_wstmt->label, "_start");
+    Operand label_end = getLabel(p_wstmt->label, "_end");
 
     pushQuads(OpCode::Label, label_start, NULL_OPERAND, NULL_OPERAND);
 
-    std::string lhs;
-    std::string rhs;
+    if (cond.has_value())
+    {
+        generateBlockStmt(p_wstmt->block);
+        pushQuads(OpCode::Goto, label_start, NULL_OPERAND, NULL_OPERAND);
+        pushQuads(OpCode::Label, label_end, NULL_OPERAND, NULL_OPERAND);
+        return;
+    }
+
+    Operand lhs;
+    Operand rhs;
     OpCode op;  // 跳转到 true
 
-    std::string scope = p_stable->exitScope();
+    // 条件表达式位于 while 语句所在的作用域中
     if (p_wstmt->expr->type() != NodeType::ComparExpr)
     {
         lhs = generateExpr(p_wstmt->expr);
-        rhs = "0";
+        rhs = Operand::imm(0);
         op = OpCode::Jeq;
     }
     else
@@ -453,7 +544,6 @@ void IrGenerator::generateWhileStmt(const WhileStmtPtr& p_wstmt)
                 break;
         }
     }
-    p_stable->enterScope(scope, false);
 
     pushQuads(op, lhs, rhs, label_end);
 
@@ -463,74 +553,59 @@ void IrGenerator::generateWhileStmt(const WhileStmtPtr& p_wstmt)
     pushQuads(OpCode::Label, label_end, NULL_OPERAND, NULL_OPERAND);
 }
 
-static auto opCode2Str(OpCode op) -> std::string
+void IrGenerator::printQuads(std::ofstream& out) const
+{
+    util::BufferedWriter sink{out};
+    for (const auto& quad : quads)
+    {
+        printQuad(sink, names, quad);
+    }
+}
+
+/**
+ * @brief  按函数切分已生成的四元式并建立各自的控制流图
+ * @return 按生成顺序排列的函数
+ */
+auto IrGenerator::buildFunctions() -> std::vector<Function>
 {
-    switch (op)
-    {
-        case OpCode::Add:
-            return "+";
-        case OpCode::Sub:
-            return "-";
-        case OpCode::Mul:
-            return "*";
-        case OpCode::Div:
-            return "/";
-
-        case OpCode::Jeq:
-            return "j=";
-        case OpCode::Jne:
-            return "j!=";
-        case OpCode::Jge:
-            return "j>=";
-        case OpCode::Jgt:
-            return "j>";
-        case OpCode::Jle:
-            return "j<=";
-        case OpCode::Jlt:
-            return "j<";
-
-        case OpCode::Eq:
-            return "==";
-        case OpCode::Neq:
-            return "!=";
-        case OpCode::Geq:
-            return ">=";
-        case OpCode::Gne:
-            return ">";
-        case OpCode::Leq:
-            return "<=";
-        case OpCode::Lne:
-            return "<";
-
-        case OpCode::Decl:
-            return "decl";
-        case OpCode::Assign:
-            return "=";
-
-        case OpCode::Label:
-            return "label";
-        case OpCode::Goto:
-            return "goto";
-
-        case OpCode::Push:
-            return "push";
-        case OpCode::Pop:
-            return "pop";
-        case OpCode::Call:
-            return "call";
-        case OpCode::Return:
-            return "return";
+    std::vector<Function> funcs;
+    funcs.reserve(func_begins.size());
+    for (std::size_t i = 0; i < func_begins.size(); ++i)
+    {
+        auto begin = quads.begin() + static_cast<std::ptrdiff_t>(func_begins[i]);
+        auto end = i + 1 < func_begins.size()
+                       ? quads.begin() + static_cast<std::ptrdiff_t>(func_begins[i + 1])
+                       : quads.end();
+        funcs.emplace_back(std::vector<Quad>(begin, end), names);
     }
+    return funcs;
 }
 
-void IrGenerator::printQuads(std::ofstream& out) const
+/**
+ * @brief 用优化遍改写已生成的各函数，之后输出的是优化后的四元式
+ * @param pm 优化遍
+ */
+void IrGenerator::optimize(PassManager& pm)
 {
-    for (const auto& quad : quads)
+    auto funcs = buildFunctions();
+    quads.clear();
+    func_begins.clear();
+    for (auto& func : funcs)
     {
-        out << std::format("({}, {}, {}, {})", opCode2Str(quad.op), quad.arg1.name, quad.arg2.name,
-                           quad.res.name)
-            << std::endl;
+        pm.run(func);
+        func_begins.push_back(quads.size());
+        quads.insert(quads.end(), func.quads().begin(), func.quads().end());
     }
 }
 
+/**
+ * @brief 清空已生成的四元式，名字表一并清空
+ */
+void IrGenerator::clearQuads()
+{
+    quads.clear();
+    func_begins.clear();
+    names.clear();
+}
+
 }  // namespace ir
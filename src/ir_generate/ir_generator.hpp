@@ -1,106 +1,83 @@
 #pragma once
 
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "parser/ast.hpp"
-#include "semantic_check/symbol_table.hpp"
+#include "quad.hpp"
 
 namespace ir
 {
 
-enum class OpCode : std::int8_t
-{
-    Add,
-    Sub,
-    Mul,
-    Div,
-
-    Jeq,
-    Jne,
-    Jge,
-    Jgt,
-    Jle,
-    Jlt,
-
-    Eq,
-    Neq,
-    Geq,
-    Gne,
-    Leq,
-    Lne,
-
-    Decl,
-    Assign,
-
-    Label,
-    Goto,
-
-    Push,
-    Pop,
-    Call,
-    Return
-};
-
-struct Operand
-{
-    std::string name;
-
-    Operand() = default;
-    Operand(std::string name) : name(std::move(name)) {}
-};
-
-struct Quad
-{
-    OpCode op;
-    Operand arg1;
-    Operand arg2;
-    Operand res;
-};
+class Function;
+class PassManager;
 
+// 中间代码生成器
+// 只对语义检查后的 AST 做翻译：作用域名、跳转标签前缀与调用的函数符号均取自语义检查的标注，
+// 不查询符号表。临时变量在每个函数内从 t0 编号，标号由作用域名得出，名字表也只属于本生成器，
+// 因此各函数可以用各自的生成器在不同线程上翻译，输出与翻译顺序无关
 class IrGenerator
 {
    public:
     IrGenerator() = default;
     ~IrGenerator() = default;
 
-    void setSymbolTable(std::shared_ptr<symbol::SymbolTable> p_stable);
-
    public:
     void generateProg(const parser::ast::ProgPtr& p_prog);
+    void generateFuncDecl(const parser::ast::FuncDeclPtr& p_fdecl);
+    void setFuncNames(NameTable::FuncNameFilter is_func) { names.setFuncNames(std::move(is_func)); }
+    void enableExprReuse() { reuse_exprs = true; }
 
     void printQuads(std::ofstream& out) const;
+    void clearQuads();
+
+    auto buildFunctions() -> std::vector<Function>;
+    void optimize(PassManager& pm);
 
    private:
-    void generateFuncDecl(const parser::ast::FuncDeclPtr& p_fdecl);
     void generateFuncHeaderDecl(const parser::ast::FuncHeaderDeclPtr& p_fhdecl);
     auto generateBlockStmt(const parser::ast::BlockStmtPtr& p_bstmt) -> bool;
     void generateVarDeclStmt(const parser::ast::VarDeclStmtPtr& p_vdstmt);
     void generateRetStmt(const parser::ast::RetStmtPtr& p_rstmt);
     void generateExprStmt(const parser::ast::ExprStmtPtr& p_estmt);
-    auto generateExpr(const parser::ast::ExprPtr& p_expr) -> std::string;
-    auto generateCallExpr(const parser::ast::CallExprPtr& p_caexpr) -> std::string;
-    auto generateComparExpr(const parser::ast::ComparExprPtr& p_coexpr) -> std::string;
-    auto generateArithExpr(const parser::ast::ArithExprPtr& p_aexpr) -> std::string;
-    auto generateFactor(const parser::ast::FactorPtr& p_factor) -> std::string;
-    auto generateElement(const parser::ast::ExprPtr& p_element) -> std::string;
-    auto generateParenthesisExpr(const parser::ast::ParenthesisExprPtr& p_pexpr) -> std::string;
-    auto generateNumber(const parser::ast::NumberPtr& p_number) -> std::string;
-    auto generateVariable(const parser::ast::VariablePtr& p_variable) -> std::string;
+    auto generateExpr(const parser::ast::ExprPtr& p_expr) -> Operand;
+    auto generateCallExpr(const parser::ast::CallExprPtr& p_caexpr) -> Operand;
+    auto generateComparExpr(const parser::ast::ComparExprPtr& p_coexpr) -> Operand;
+    auto generateArithExpr(const parser::ast::ArithExprPtr& p_aexpr) -> Operand;
+    auto generateFactor(const parser::ast::FactorPtr& p_factor) -> Operand;
+    auto generateElement(const parser::ast::ExprPtr& p_element) -> Operand;
+    auto generateParenthesisExpr(const parser::ast::ParenthesisExprPtr& p_pexpr) -> Operand;
+    auto generateNumber(const parser::ast::NumberPtr& p_number) -> Operand;
+    auto generateVariable(const parser::ast::VariablePtr& p_variable) -> Operand;
     void generateAssignStmt(const parser::ast::AssignStmtPtr& p_astmt);
     void generateIfStmt(const parser::ast::IfStmtPtr& p_istmt);
     void generateWhileStmt(const parser::ast::WhileStmtPtr& p_wstmt);
 
-    [[nodiscard]]
-    auto getVarName(const std::string& var_name) const -> std::string;
-    [[nodiscard]]
-    auto getFuncName() const -> std::string;
+    auto getVar(std::string_view var_name, const symbol::Variable* p_symbol) -> Operand;
+    auto getLabel(std::string_view prefix, std::string_view suffix = {}) -> Operand;
+    auto getTempVal() -> Operand;
 
-    void pushQuads(OpCode op, const Operand& arg1, const Operand& arg2, const Operand& res);
+    void pushQuads(OpCode op, Operand arg1, Operand arg2, Operand res);
+    void forgetExprs();
 
    private:
     std::vector<Quad> quads;
+    std::vector<std::size_t> func_begins;  // 各函数第一条四元式的下标
+
+    NameTable names;       // 随 clearQuads 一并清空
+    std::string name_buf;  // 拼接名字用的缓冲区
+
+    std::uint32_t tv_cnt = 0;  // 临时变量计数，每个函数从 0 开始
+
+    const std::string* p_scope = nullptr;  // 正在翻译的语句块所在作用域的全名
 
-    std::shared_ptr<symbol::SymbolTable> p_stable;
+    // 共享表达式结点 (--hash-cons) 的临时变量复用，只在一个基本块内有效
+    bool reuse_exprs = false;
+    std::unordered_map<const parser::ast::Expr*, Operand> expr_temps;  // 已求值的共享结点
+    std::unordered_set<std::uint32_t> expr_reads;  // 这些结点读过的变量 (函数内编号)
 };
 
 }  // namespace ir
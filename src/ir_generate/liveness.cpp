@@ -0,0 +1,162 @@
+#include "liveness.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace ir
+{
+
+/**
+ * @brief   求函数中各块入口与出口处活跃的值
+ * @details 逐个值求活跃范围：从该值向上暴露的使用 (块内使用前没有定值) 所在的块出发，
+ *          逆着控制流边上溯，沿途的块在出口处活跃，未定值该值的块在入口处也活跃，
+ *          到达定值块或已访问的块为止。按编号依次处理各值，结果自然有序
+ * @param   func 非 SSA 形式的函数
+ */
+Liveness::Liveness(const Function& func) : p_names(&func.names())
+{
+    if (func.inSsa())
+    {
+        throw std::runtime_error{"活跃性分析只用于非 SSA 形式"};
+    }
+
+    // Step1. 确定值的编号范围
+    temp_base = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t temp_end = 0;
+    for (const auto& quad : func.quads())
+    {
+        for (auto opnd : {quad.arg1, quad.arg2, quad.res})
+        {
+            if (opnd.kind == Operand::Kind::Var)
+            {
+                nvars = std::max(nvars, p_names->localId(opnd) + 1);
+            }
+            else if (opnd.kind == Operand::Kind::Temp)
+            {
+                temp_base = std::min(temp_base, opnd.value);
+                temp_end = std::max(temp_end, opnd.value + 1);
+            }
+        }
+    }
+    nvalues = nvars + (temp_end > temp_base ? temp_end - temp_base : 0);
+
+    // Step2. 按值分组各块向上暴露的使用与定值，以 CSR 形式存放
+    auto n = static_cast<BlockId>(func.numBlocks());
+    std::vector<std::pair<std::uint32_t, BlockId>> uses;  // (值, 块)
+    std::vector<std::pair<std::uint32_t, BlockId>> defs;
+    std::vector<BlockId> def_in(nvalues, Function::NO_BLOCK);  // 值最近一次定值所在的块
+    for (BlockId b = 0; b < n; ++b)
+    {
+        for (const auto& quad : func.quadsOf(b))
+        {
+            if (quad.op != OpCode::Decl)
+            {
+                for (auto opnd : {quad.arg1, quad.arg2})
+                {
+                    auto v = index(opnd);
+                    if (v != NO_VALUE && def_in[v] != b)
+                    {
+                        uses.emplace_back(v, b);
+                    }
+                }
+            }
+            auto d = index(quad.res);
+            if (d != NO_VALUE && def_in[d] != b)
+            {
+                def_in[d] = b;
+                defs.emplace_back(d, b);
+            }
+        }
+    }
+
+    auto group = [&](std::vector<std::pair<std::uint32_t, BlockId>>& pairs,
+                     std::vector<std::uint32_t>& first, std::vector<BlockId>& blocks)
+    {
+        first.assign(nvalues + 1, 0);
+        for (auto [v, b] : pairs)
+        {
+            ++first[v + 1];
+        }
+        std::partial_sum(first.begin(), first.end(), first.begin());
+        blocks.resize(pairs.size());
+        std::vector<std::uint32_t> fill(first.begin(), first.end() - 1);
+        for (auto [v, b] : pairs)
+        {
+            blocks[fill[v]++] = b;
+        }
+        pairs.clear();
+        pairs.shrink_to_fit();
+    };
+    std::vector<std::uint32_t> use_first;
+    std::vector<BlockId> use_blocks;
+    std::vector<std::uint32_t> def_first;
+    std::vector<BlockId> def_blocks;
+    group(uses, use_first, use_blocks);
+    group(defs, def_first, def_blocks);
+
+    // Step3. 逐个值上溯。标记数组记录块最近一次被哪个值 (编号 + 1) 标记，不必逐值清空
+    in.assign(n, {});
+    out.assign(n, {});
+    std::vector<std::uint32_t> defined(n, 0);
+    std::vector<std::uint32_t> live_in(n, 0);
+    std::vector<std::uint32_t> live_out(n, 0);
+    std::vector<BlockId> work;
+    for (std::uint32_t v = 0; v < nvalues; ++v)
+    {
+        auto mark = v + 1;
+        for (auto i = def_first[v]; i < def_first[v + 1]; ++i)
+        {
+            defined[def_blocks[i]] = mark;
+        }
+        for (auto i = use_first[v]; i < use_first[v + 1]; ++i)
+        {
+            auto b = use_blocks[i];
+            if (live_in[b] != mark)
+            {
+                live_in[b] = mark;
+                in[b].push_back(v);
+                work.push_back(b);
+            }
+        }
+        while (!work.empty())
+        {
+            auto b = work.back();
+            work.pop_back();
+            for (auto p : func.preds(b))
+            {
+                if (live_out[p] != mark)
+                {
+                    live_out[p] = mark;
+                    out[p].push_back(v);
+                }
+                if (defined[p] != mark && live_in[p] != mark)
+                {
+                    live_in[p] = mark;
+                    in[p].push_back(v);
+                    work.push_back(p);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief  取操作数对应的值编号
+ * @param  opnd 操作数
+ * @return 变量或临时变量的编号，其余操作数为 NO_VALUE
+ */
+auto Liveness::index(Operand opnd) const -> std::uint32_t
+{
+    if (opnd.kind == Operand::Kind::Var)
+    {
+        return p_names->localId(opnd);
+    }
+    if (opnd.kind == Operand::Kind::Temp)
+    {
+        return nvars + opnd.value - temp_base;
+    }
+    return NO_VALUE;
+}
+
+}  // namespace ir
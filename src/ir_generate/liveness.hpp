@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "function.hpp"
+
+namespace ir
+{
+
+// 变量与临时变量的活跃性
+// 每个值有一个编号：变量按函数内编号排在前面 (同一变量在不同作用域中的文本不同，
+// 但编号相同)，临时变量按编号紧随其后。各块入口与出口处活跃的值以升序的编号表存放，
+// 占用的空间与各值活跃范围的总长成正比，而不是值数与块数之积。只用于非 SSA 形式
+class Liveness
+{
+   public:
+    static constexpr std::uint32_t NO_VALUE = std::numeric_limits<std::uint32_t>::max();
+
+    explicit Liveness(const Function& func);
+
+   public:
+    [[nodiscard]] auto numValues() const -> std::size_t { return nvalues; }
+    [[nodiscard]] auto index(Operand opnd) const -> std::uint32_t;
+
+    [[nodiscard]] auto liveIn(BlockId b) const -> std::span<const std::uint32_t> { return in[b]; }
+    [[nodiscard]] auto liveOut(BlockId b) const -> std::span<const std::uint32_t>
+    {
+        return out[b];
+    }
+
+   private:
+    const NameTable* p_names;
+    std::uint32_t nvars = 0;      // 变量个数，即临时变量的起始编号
+    std::uint32_t temp_base = 0;  // 函数中最小的临时变量编号
+    std::size_t nvalues = 0;
+
+    std::vector<std::vector<std::uint32_t>> in;   // 块入口处活跃的值，升序
+    std::vector<std::vector<std::uint32_t>> out;  // 块出口处活跃的值，升序
+};
+
+}  // namespace ir
@@ -0,0 +1,202 @@
+#include "pass_manager.hpp"
+
+#include <bit>
+#include <iomanip>
+#include <stdexcept>
+
+#include "passes.hpp"
+
+namespace ir
+{
+
+/**
+ * @brief  确保控制流图有效
+ * @return 函数
+ */
+auto AnalysisManager::cfg() -> const Function&
+{
+    if ((valid & ANALYSIS_CFG) == 0)
+    {
+        auto start = PassManager::Clock::now();
+        p_func->buildCfg();
+        auto& stats = p_pm->analyses[std::countr_zero(ANALYSIS_CFG)];
+        ++stats.runs;
+        stats.time += PassManager::Clock::now() - start;
+        valid |= ANALYSIS_CFG;
+    }
+    return *p_func;
+}
+
+/**
+ * @brief  确保控制流图与支配树有效
+ * @return 函数
+ */
+auto AnalysisManager::dominators() -> const Function&
+{
+    cfg();
+    if ((valid & ANALYSIS_DOMINATORS) == 0)
+    {
+        auto start = PassManager::Clock::now();
+        p_func->buildDominators();
+        auto& stats = p_pm->analyses[std::countr_zero(ANALYSIS_DOMINATORS)];
+        ++stats.runs;
+        stats.time += PassManager::Clock::now() - start;
+        valid |= ANALYSIS_DOMINATORS;
+    }
+    return *p_func;
+}
+
+/**
+ * @brief  取活跃性，失效时重新计算
+ * @return 活跃性
+ */
+auto AnalysisManager::liveness() -> const Liveness&
+{
+    cfg();
+    if ((valid & ANALYSIS_LIVENESS) == 0 || !live.has_value())
+    {
+        auto start = PassManager::Clock::now();
+        live.emplace(*p_func);
+        auto& stats = p_pm->analyses[std::countr_zero(ANALYSIS_LIVENESS)];
+        ++stats.runs;
+        stats.time += PassManager::Clock::now() - start;
+        valid |= ANALYSIS_LIVENESS;
+    }
+    return live.value();
+}
+
+/**
+ * @brief 使分析失效，依赖于失效分析的分析一并失效
+ * @param lost 失效的分析
+ */
+void AnalysisManager::invalidate(AnalysisSet lost)
+{
+    if ((lost & ANALYSIS_CFG) != 0)
+    {
+        lost = ANALYSIS_ALL;
+    }
+    valid &= ~lost;
+    if ((valid & ANALYSIS_LIVENESS) == 0)
+    {
+        live.reset();
+    }
+}
+
+/**
+ * @brief  建立优化级别对应的流水线
+ * @param  level 优化级别：0 不优化；1 简化控制流并删去死代码；
+ *               2 另在 SSA 形式上做常量与复制传播
+ * @return 流水线
+ */
+auto PassManager::forLevel(std::size_t level) -> PassManager
+{
+    PassManager pm;
+    if (level >= 2)
+    {
+        pm.addPass(std::make_unique<SimplifyCfgPass>());
+        pm.addPass(std::make_unique<ToSsaPass>());
+        pm.addPass(std::make_unique<ConstPropPass>());
+        pm.addPass(std::make_unique<DeadCodePass>());
+        pm.addPass(std::make_unique<OutOfSsaPass>());
+    }
+    if (level >= 1)
+    {
+        pm.addPass(std::make_unique<SimplifyCfgPass>());
+        pm.addPass(std::make_unique<DeadCodePass>());
+    }
+    return pm;
+}
+
+void PassManager::addPass(std::unique_ptr<FunctionPass> pass)
+{
+    passes.push_back(PassStats{.pass = std::move(pass)});
+}
+
+/**
+ * @brief   对函数依次运行各优化遍
+ * @details 遍报告有改动时，未声明保留的分析失效，由之后需要它的遍重新计算。
+ *          遍改动四元式后控制流图可能失效，返回时不重建 (输出只需要四元式)
+ * @param   func 函数
+ */
+void PassManager::run(Function& func)
+{
+    AnalysisManager am{func, *this};
+    for (auto& stats : passes)
+    {
+        auto start = Clock::now();
+        auto result = stats.pass->run(func, am);
+        stats.time += Clock::now() - start;
+        ++stats.runs;
+        stats.changes += result.changes;
+        if (result.changes > 0)
+        {
+            am.invalidate(~result.preserved);
+        }
+    }
+}
+
+/**
+ * @brief 并入同一流水线的另一副本的统计
+ * @param other 由同一优化级别建立的流水线
+ */
+void PassManager::mergeStats(const PassManager& other)
+{
+    if (other.passes.size() != passes.size())
+    {
+        throw std::runtime_error{"只能并入同一流水线的统计"};
+    }
+    for (std::size_t i = 0; i < passes.size(); ++i)
+    {
+        passes[i].runs += other.passes[i].runs;
+        passes[i].changes += other.passes[i].changes;
+        passes[i].time += other.passes[i].time;
+    }
+    for (std::size_t i = 0; i < analyses.size(); ++i)
+    {
+        analyses[i].runs += other.analyses[i].runs;
+        analyses[i].time += other.analyses[i].time;
+    }
+}
+
+/**
+ * @brief   输出各遍与各分析的累计耗时 (--time-passes)
+ * @details 遍的耗时包含其间计算分析的耗时；并行优化时为各线程耗时之和
+ * @param   out 输出流
+ */
+void PassManager::report(std::ostream& out) const
+{
+    static constexpr std::array<std::string_view, 3> ANALYSIS_NAMES{"cfg", "dominators",
+                                                                    "liveness"};
+
+    auto ms = [](Clock::duration d) -> double
+    { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    Clock::duration total{};
+    for (const auto& stats : passes)
+    {
+        total += stats.time;
+    }
+
+    auto flags = out.flags();
+    out << "===-- Pass execution timing report --===" << '\n'
+        << "  Total pass time: " << std::fixed << std::setprecision(3) << ms(total) << " ms"
+        << '\n'
+        << '\n'
+        << std::setw(12) << "time (ms)" << std::setw(10) << "runs" << std::setw(10) << "changes"
+        << "  pass" << '\n';
+    for (const auto& stats : passes)
+    {
+        out << std::setw(12) << ms(stats.time) << std::setw(10) << stats.runs << std::setw(10)
+            << stats.changes << "  " << stats.pass->name() << '\n';
+    }
+    out << '\n'
+        << std::setw(12) << "time (ms)" << std::setw(10) << "computed" << "  analysis" << '\n';
+    for (std::size_t i = 0; i < analyses.size(); ++i)
+    {
+        out << std::setw(12) << ms(analyses[i].time) << std::setw(10) << analyses[i].runs << "  "
+            << ANALYSIS_NAMES[i] << '\n';
+    }
+    out.flags(flags);
+}
+
+}  // namespace ir
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "function.hpp"
+#include "liveness.hpp"
+
+namespace ir
+{
+
+// 可缓存的分析，按位组合
+using AnalysisSet = std::uint32_t;
+
+inline constexpr AnalysisSet ANALYSIS_CFG = 1U << 0;         // 基本块与控制流图
+inline constexpr AnalysisSet ANALYSIS_DOMINATORS = 1U << 1;  // 逆后序与支配树，依赖控制流图
+inline constexpr AnalysisSet ANALYSIS_LIVENESS = 1U << 2;    // 活跃性，依赖控制流图
+inline constexpr AnalysisSet ANALYSIS_ALL =
+    ANALYSIS_CFG | ANALYSIS_DOMINATORS | ANALYSIS_LIVENESS;
+
+// 优化遍一次运行的结果
+struct PassResult
+{
+    std::size_t changes = 0;    // 改动的处数，为 0 时所有分析保持有效
+    AnalysisSet preserved = 0;  // 有改动时仍然有效的分析
+};
+
+class PassManager;
+
+// 一个函数的分析缓存
+// 优化遍通过它取得分析结果，结果失效时才重新计算。控制流图与支配树存放在 Function 中，
+// 这里只记录它们是否有效；活跃性等独立的分析结果由这里持有
+class AnalysisManager
+{
+   public:
+    AnalysisManager(Function& func, PassManager& pm) : p_func(&func), p_pm(&pm) {}
+
+   public:
+    auto cfg() -> const Function&;
+    auto dominators() -> const Function&;
+    auto liveness() -> const Liveness&;
+
+    void invalidate(AnalysisSet lost);
+
+   private:
+    Function* p_func;
+    PassManager* p_pm;  // 统计分析的计算次数与耗时
+
+    AnalysisSet valid = ANALYSIS_CFG | ANALYSIS_DOMINATORS;  // Function 构造时已建好
+    std::optional<Liveness> live;
+};
+
+// 函数级优化遍
+class FunctionPass
+{
+   public:
+    virtual ~FunctionPass() = default;
+
+   public:
+    [[nodiscard]] virtual auto name() const -> std::string_view = 0;
+    virtual auto run(Function& func, AnalysisManager& am) -> PassResult = 0;
+};
+
+// 按顺序对每个函数运行一组优化遍，并统计各遍与各分析的耗时
+// 一个 PassManager 只在一个线程上使用；并行优化时每个线程使用同一流水线的副本，
+// 最后把统计并入一处 (mergeStats)
+class PassManager
+{
+   public:
+    PassManager() = default;
+    PassManager(const PassManager&) = delete;
+    auto operator=(const PassManager&) -> PassManager& = delete;
+    PassManager(PassManager&&) = default;
+    auto operator=(PassManager&&) -> PassManager& = default;
+    ~PassManager() = default;
+
+    static auto forLevel(std::size_t level) -> PassManager;
+
+   public:
+    void addPass(std::unique_ptr<FunctionPass> pass);
+    [[nodiscard]] auto empty() const -> bool { return passes.empty(); }
+
+    void run(Function& func);
+    void mergeStats(const PassManager& other);
+    void report(std::ostream& out) const;
+
+   private:
+    friend class AnalysisManager;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct PassStats
+    {
+        std::unique_ptr<FunctionPass> pass;
+        std::size_t runs = 0;
+        std::size_t changes = 0;
+        Clock::duration time{};
+    };
+
+    struct AnalysisStats
+    {
+        std::size_t runs = 0;
+        Clock::duration time{};
+    };
+
+    std::vector<PassStats> passes;
+    std::array<AnalysisStats, 3> analyses{};  // 下标为分析在 AnalysisSet 中的位
+};
+
+}  // namespace ir
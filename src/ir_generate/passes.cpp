@@ -0,0 +1,793 @@
+#include "passes.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace ir
+{
+
+static constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * @brief  判断四元式是否没有副作用，即结果不被使用时可以删去
+ * @details 除数不是非零立即数的除法可能除以零，保守地视为有副作用
+ * @param  quad 四元式
+ * @return 没有副作用时为 true
+ */
+static auto isPure(const Quad& quad) -> bool
+{
+    switch (quad.op)
+    {
+        case OpCode::Add:
+        case OpCode::Sub:
+        case OpCode::Mul:
+        case OpCode::Eq:
+        case OpCode::Neq:
+        case OpCode::Geq:
+        case OpCode::Gne:
+        case OpCode::Leq:
+        case OpCode::Lne:
+        case OpCode::Assign:
+            return true;
+        case OpCode::Div:
+            return quad.arg2.kind == Operand::Kind::Imm && quad.arg2.immValue() != 0;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief  求比较运算或条件跳转的条件
+ * @param  op 比较运算符或条件跳转
+ * @param  a  左操作数
+ * @param  b  右操作数
+ * @return 条件是否成立
+ */
+static auto compare(OpCode op, std::int32_t a, std::int32_t b) -> bool
+{
+    switch (op)
+    {
+        case OpCode::Eq:
+        case OpCode::Jeq:
+            return a == b;
+        case OpCode::Neq:
+        case OpCode::Jne:
+            return a != b;
+        case OpCode::Geq:
+        case OpCode::Jge:
+            return a >= b;
+        case OpCode::Gne:
+        case OpCode::Jgt:
+            return a > b;
+        case OpCode::Leq:
+        case OpCode::Jle:
+            return a <= b;
+        case OpCode::Lne:
+        case OpCode::Jlt:
+            return a < b;
+        default:
+            throw std::runtime_error{"不是比较运算"};
+    }
+}
+
+/**
+ * @brief  折叠两个常量的运算
+ * @param  op 算术或比较运算符
+ * @param  a  左操作数
+ * @param  b  右操作数
+ * @return 结果；溢出或除以零时为空
+ */
+static auto fold(OpCode op, std::int32_t a, std::int32_t b) -> std::optional<std::int32_t>
+{
+    std::int64_t x = a;
+    std::int64_t y = b;
+    std::int64_t r = 0;
+    switch (op)
+    {
+        case OpCode::Add:
+            r = x + y;
+            break;
+        case OpCode::Sub:
+            r = x - y;
+            break;
+        case OpCode::Mul:
+            r = x * y;
+            break;
+        case OpCode::Div:
+            if (y == 0)
+            {
+                return std::nullopt;
+            }
+            r = x / y;
+            break;
+        default:
+            return compare(op, a, b) ? 1 : 0;
+    }
+    if (r < std::numeric_limits<std::int32_t>::min() ||
+        r > std::numeric_limits<std::int32_t>::max())
+    {
+        return std::nullopt;
+    }
+    return static_cast<std::int32_t>(r);
+}
+
+/**
+ * @brief  取条件相反的条件跳转
+ * @param  op 条件跳转
+ * @return 条件取反后的条件跳转
+ */
+static auto invertJump(OpCode op) -> OpCode
+{
+    switch (op)
+    {
+        case OpCode::Jeq:
+            return OpCode::Jne;
+        case OpCode::Jne:
+            return OpCode::Jeq;
+        case OpCode::Jge:
+            return OpCode::Jlt;
+        case OpCode::Jlt:
+            return OpCode::Jge;
+        case OpCode::Jgt:
+            return OpCode::Jle;
+        case OpCode::Jle:
+            return OpCode::Jgt;
+        default:
+            throw std::runtime_error{"不是条件跳转"};
+    }
+}
+
+/**
+ * @brief  取跳转四元式的目标标号
+ * @param  quad 四元式
+ * @return 目标标号，不是跳转时为空操作数
+ */
+static auto jumpTarget(const Quad& quad) -> Operand
+{
+    if (quad.op == OpCode::Goto)
+    {
+        return quad.arg1;
+    }
+    if (isCondJump(quad.op))
+    {
+        return quad.res;
+    }
+    return Operand{};
+}
+
+/**
+ * @brief  删去没有被跳转引用的标号 (函数名标号除外)
+ * @param  code 函数的四元式
+ * @return 删去的个数
+ */
+static auto removeUnusedLabels(std::vector<Quad>& code) -> std::size_t
+{
+    std::unordered_map<std::uint32_t, std::uint32_t> refs;
+    for (const auto& quad : code)
+    {
+        auto target = jumpTarget(quad);
+        if (target.kind == Operand::Kind::Label)
+        {
+            ++refs[target.value];
+        }
+    }
+    auto unused = [&](const Quad& quad)
+    { return quad.op == OpCode::Label && !refs.contains(quad.arg1.value); };
+    auto dead = std::remove_if(code.begin() + 1, code.end(), unused);
+    auto cnt = static_cast<std::size_t>(code.end() - dead);
+    code.erase(dead, code.end());
+    return cnt;
+}
+
+/**
+ * @brief   简化控制流
+ * @details 先改写跳转目标并折叠常量条件跳转；若有改动则重建控制流图，再删去不可达的块、
+ *          没有引用的标号与跳到紧随其后的标号的跳转，并把越过一条 goto 的条件跳转取反
+ *          (if 语句的翻译 "jcc T; goto F; T:" 变为 "j!cc F; T:")
+ * @param   func 非 SSA 形式的函数
+ * @param   am   分析缓存
+ * @return  改动的处数
+ */
+auto SimplifyCfgPass::run(Function& func, AnalysisManager& am) -> PassResult
+{
+    if (func.inSsa())
+    {
+        return {};
+    }
+    std::size_t changes = 0;
+
+    // Step1. 穿过只含 goto 的块：标号 -> 最终的跳转目标
+    const auto& cfg = am.cfg();
+    std::unordered_map<std::uint32_t, Operand> forward;
+    for (BlockId b = 0; b < cfg.numBlocks(); ++b)
+    {
+        auto qs = cfg.quadsOf(b);
+        if (qs.size() == 2 && qs[0].op == OpCode::Label && qs[1].op == OpCode::Goto)
+        {
+            forward.emplace(qs[0].arg1.value, qs[1].arg1);
+        }
+    }
+    auto resolve = [&](Operand label) -> Operand
+    {
+        // 只含 goto 的块可能成环，最多前进 forward.size() 步
+        for (std::size_t step = 0; step < forward.size(); ++step)
+        {
+            auto it = forward.find(label.value);
+            if (it == forward.end() || it->second == label)
+            {
+                break;
+            }
+            label = it->second;
+        }
+        return label;
+    };
+
+    // Step2. 改写跳转目标，折叠常量条件跳转
+    std::vector<Quad> code;
+    code.reserve(func.quads().size());
+    for (auto quad : func.quads())
+    {
+        if (quad.op == OpCode::Goto)
+        {
+            auto target = resolve(quad.arg1);
+            changes += target != quad.arg1 ? 1 : 0;
+            quad.arg1 = target;
+        }
+        else if (isCondJump(quad.op))
+        {
+            auto target = resolve(quad.res);
+            changes += target != quad.res ? 1 : 0;
+            quad.res = target;
+            if (quad.arg1.kind == Operand::Kind::Imm && quad.arg2.kind == Operand::Kind::Imm)
+            {
+                ++changes;
+                if (!compare(quad.op, quad.arg1.immValue(), quad.arg2.immValue()))
+                {
+                    continue;
+                }
+                quad = Quad{OpCode::Goto, target, Operand{}, Operand{}};
+            }
+        }
+        code.push_back(quad);
+    }
+    if (changes > 0)
+    {
+        func.setQuads(std::move(code));
+        am.invalidate(ANALYSIS_CFG);
+    }
+
+    // Step3. 删去不可达的块
+    const auto& dom = am.dominators();
+    code.clear();
+    for (BlockId b = 0; b < dom.numBlocks(); ++b)
+    {
+        auto qs = dom.quadsOf(b);
+        if (dom.reachable(b))
+        {
+            code.insert(code.end(), qs.begin(), qs.end());
+        }
+        else
+        {
+            changes += qs.size();
+        }
+    }
+
+    // Step4. 删去没有引用的标号，再自后向前删去跳到紧随其后的标号的跳转。
+    // 删去一条跳转后，它之前的跳转可能也紧邻该标号，因此逆序处理；最后删去因此失去引用的标号
+    changes += removeUnusedLabels(code);
+    std::vector<Quad> kept;
+    kept.reserve(code.size());
+    for (auto it = code.rbegin(); it != code.rend(); ++it)
+    {
+        auto target = jumpTarget(*it);
+        if (target.kind == Operand::Kind::Label && !kept.empty() &&
+            kept.back().op == OpCode::Label && kept.back().arg1 == target)
+        {
+            ++changes;
+            continue;
+        }
+        kept.push_back(*it);
+    }
+    std::ranges::reverse(kept);
+
+    // Step5. 条件跳转越过紧随其后的 goto 时取反条件，goto 随之删去
+    code.clear();
+    for (std::size_t i = 0; i < kept.size(); ++i)
+    {
+        if (isCondJump(kept[i].op) && i + 2 < kept.size() && kept[i + 1].op == OpCode::Goto &&
+            kept[i + 2].op == OpCode::Label && kept[i + 2].arg1 == kept[i].res)
+        {
+            code.push_back(
+                Quad{invertJump(kept[i].op), kept[i].arg1, kept[i].arg2, kept[i + 1].arg1});
+            ++i;
+            ++changes;
+            continue;
+        }
+        code.push_back(kept[i]);
+    }
+    changes += removeUnusedLabels(code);
+
+    if (changes == 0)
+    {
+        return {};
+    }
+    func.setQuads(std::move(code));
+    return {changes, 0};
+}
+
+/**
+ * @brief  删去死代码
+ * @param  func 函数
+ * @param  am   分析缓存
+ * @return 删去的四元式个数，控制流图与支配树保持有效
+ */
+auto DeadCodePass::run(Function& func, AnalysisManager& am) -> PassResult
+{
+    if (func.inSsa())
+    {
+        return runOnSsa(func);
+    }
+
+    // 删去一处定值后其操作数可能也变为死值，因此重新求活跃性直到没有可删的四元式
+    std::size_t removed = 0;
+    std::vector<std::uint32_t> work;
+    std::uint32_t stamp = 0;
+    while (true)
+    {
+        const auto& live = am.liveness();
+        work.resize(live.numValues(), 0);
+        auto quads = func.quads();
+        util::BitVector dead{quads.size()};
+        std::size_t cnt = 0;
+
+        // Step1. 逐块自后向前维护活跃集合，删去结果不活跃的无副作用四元式。
+        // 集合以标记表示：work[v] == stamp 表示 v 活跃，换块时只需递增 stamp
+        for (BlockId b = 0; b < func.numBlocks(); ++b)
+        {
+            ++stamp;
+            for (auto v : live.liveOut(b))
+            {
+                work[v] = stamp;
+            }
+            for (auto i = func.block(b).end; i-- > func.block(b).begin;)
+            {
+                const auto& quad = quads[i];
+                if (quad.op == OpCode::Decl)
+                {
+                    continue;
+                }
+                auto d = live.index(quad.res);
+                if (d != Liveness::NO_VALUE && isPure(quad) && work[d] != stamp)
+                {
+                    dead.set(i);
+                    ++cnt;
+                    continue;
+                }
+                if (d != Liveness::NO_VALUE)
+                {
+                    work[d] = 0;
+                }
+                for (auto opnd : {quad.arg1, quad.arg2})
+                {
+                    auto v = live.index(opnd);
+                    if (v != Liveness::NO_VALUE)
+                    {
+                        work[v] = stamp;
+                    }
+                }
+            }
+        }
+
+        // Step2. 删去不再被引用的变量的声明
+        util::BitVector referenced{live.numValues()};
+        for (std::size_t i = 0; i < quads.size(); ++i)
+        {
+            if (dead.test(i) || quads[i].op == OpCode::Decl)
+            {
+                continue;
+            }
+            for (auto opnd : {quads[i].arg1, quads[i].arg2, quads[i].res})
+            {
+                if (opnd.kind == Operand::Kind::Var)
+                {
+                    referenced.set(live.index(opnd));
+                }
+            }
+        }
+        for (std::size_t i = 0; i < quads.size(); ++i)
+        {
+            if (quads[i].op == OpCode::Decl && !referenced.test(live.index(quads[i].arg1)))
+            {
+                dead.set(i);
+                ++cnt;
+            }
+        }
+
+        if (cnt == 0)
+        {
+            break;
+        }
+        func.removeQuads(dead);
+        am.invalidate(ANALYSIS_LIVENESS);
+        removed += cnt;
+    }
+    return {removed, ANALYSIS_CFG | ANALYSIS_DOMINATORS};
+}
+
+namespace
+{
+
+// SSA 形式下函数中的临时变量，编号映射到 [0, size)
+struct TempRange
+{
+    std::uint32_t base = NONE;
+    std::uint32_t end = 0;
+
+    explicit TempRange(const Function& func)
+    {
+        auto add = [&](Operand opnd)
+        {
+            if (opnd.kind == Operand::Kind::Temp)
+            {
+                base = std::min(base, opnd.value);
+                end = std::max(end, opnd.value + 1);
+            }
+        };
+        for (const auto& quad : func.quads())
+        {
+            add(quad.arg1);
+            add(quad.arg2);
+            add(quad.res);
+        }
+        for (BlockId b = 0; b < func.numBlocks(); ++b)
+        {
+            for (const auto& phi : func.phisOf(b))
+            {
+                add(phi.res);
+                std::ranges::for_each(phi.args, add);
+            }
+        }
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return end > base ? end - base : 0; }
+    [[nodiscard]] auto index(Operand temp) const -> std::uint32_t { return temp.value - base; }
+};
+
+}  // namespace
+
+/**
+ * @brief   在 SSA 形式上删去死代码
+ * @details 有副作用的四元式 (跳转、返回、调用、传参等) 是有用的；有用的四元式与 φ 函数
+ *          使用的临时变量，其定值也是有用的。沿定值-使用链传播后删去其余的定值
+ * @param   func SSA 形式的函数
+ * @return  删去的四元式与 φ 函数个数
+ */
+auto DeadCodePass::runOnSsa(Function& func) -> PassResult
+{
+    TempRange temps{func};
+    auto quads = func.quads();
+    std::vector<std::uint32_t> def_quad(temps.size(), NONE);
+    std::vector<const Phi*> def_phi(temps.size(), nullptr);
+    for (std::uint32_t i = 0; i < quads.size(); ++i)
+    {
+        if (quads[i].res.kind == Operand::Kind::Temp)
+        {
+            def_quad[temps.index(quads[i].res)] = i;
+        }
+    }
+    for (BlockId b = 0; b < func.numBlocks(); ++b)
+    {
+        for (const auto& phi : func.phisOf(b))
+        {
+            def_phi[temps.index(phi.res)] = &phi;
+        }
+    }
+
+    util::BitVector useful{temps.size()};
+    std::vector<std::uint32_t> work;
+    auto use = [&](Operand opnd)
+    {
+        if (opnd.kind == Operand::Kind::Temp && !useful.test(temps.index(opnd)))
+        {
+            useful.set(temps.index(opnd));
+            work.push_back(temps.index(opnd));
+        }
+    };
+
+    for (const auto& quad : quads)
+    {
+        if (!isPure(quad))
+        {
+            use(quad.arg1);
+            use(quad.arg2);
+        }
+    }
+    while (!work.empty())
+    {
+        auto t = work.back();
+        work.pop_back();
+        if (def_quad[t] != NONE)
+        {
+            use(quads[def_quad[t]].arg1);
+            use(quads[def_quad[t]].arg2);
+        }
+        else if (def_phi[t] != nullptr)
+        {
+            std::ranges::for_each(def_phi[t]->args, use);
+        }
+    }
+
+    util::BitVector dead{quads.size()};
+    std::size_t cnt = 0;
+    for (std::size_t i = 0; i < quads.size(); ++i)
+    {
+        if (isPure(quads[i]) && !useful.test(temps.index(quads[i].res)))
+        {
+            dead.set(i);
+            ++cnt;
+        }
+    }
+    cnt += func.erasePhis([&](const Phi& phi) { return !useful.test(temps.index(phi.res)); });
+    if (cnt == 0)
+    {
+        return {};
+    }
+    func.removeQuads(dead);
+    return {cnt, ANALYSIS_CFG | ANALYSIS_DOMINATORS};
+}
+
+/**
+ * @brief   稀疏的常量与复制传播
+ * @details 格值为 未定 > 常量 > 不定。先乐观地把所有临时变量置为未定，从各定值出发求值，
+ *          值下降时重新求值其使用者，直到不动点。之后把常量的使用替换为立即数；
+ *          源不是常量的复制 (赋值，以及除自身外只有一个实参的 φ 函数) 的使用替换为其源
+ * @param   func SSA 形式的函数
+ * @param   am   分析缓存
+ * @return  替换的操作数个数，控制流图与支配树保持有效
+ */
+auto ConstPropPass::run(Function& func, AnalysisManager& /* am */) -> PassResult
+{
+    if (!func.inSsa())
+    {
+        return {};
+    }
+
+    struct Value
+    {
+        enum class State : std::uint8_t
+        {
+            Top,    // 未定
+            Const,  // 常量
+            Bottom  // 不定
+        };
+
+        State state = State::Top;
+        std::int32_t c = 0;
+
+        auto operator==(const Value&) const -> bool = default;
+    };
+    static constexpr Value BOTTOM{Value::State::Bottom, 0};
+
+    TempRange temps{func};
+    auto quads = func.quads();
+    auto nquads = static_cast<std::uint32_t>(quads.size());
+
+    // Step1. 收集定值 (四元式下标，φ 函数排在四元式之后) 与使用者
+    std::vector<Phi*> all_phis;
+    for (BlockId b = 0; b < func.numBlocks(); ++b)
+    {
+        for (auto& phi : func.phisOf(b))
+        {
+            all_phis.push_back(&phi);
+        }
+    }
+    std::vector<std::vector<std::uint32_t>> users(temps.size());
+    auto addUser = [&](Operand opnd, std::uint32_t user)
+    {
+        if (opnd.kind == Operand::Kind::Temp)
+        {
+            users[temps.index(opnd)].push_back(user);
+        }
+    };
+    for (std::uint32_t i = 0; i < nquads; ++i)
+    {
+        addUser(quads[i].arg1, i);
+        addUser(quads[i].arg2, i);
+    }
+    for (std::uint32_t k = 0; k < all_phis.size(); ++k)
+    {
+        for (auto arg : all_phis[k]->args)
+        {
+            addUser(arg, nquads + k);
+        }
+    }
+
+    // Step2. 求不动点
+    std::vector<Value> values(temps.size());
+    auto valueOf = [&](Operand opnd) -> Value
+    {
+        switch (opnd.kind)
+        {
+            case Operand::Kind::Imm:
+                return Value{Value::State::Const, opnd.immValue()};
+            case Operand::Kind::Temp:
+                return values[temps.index(opnd)];
+            default:  // 没有定值到达的变量
+                return BOTTOM;
+        }
+    };
+
+    auto evaluate = [&](std::uint32_t user) -> std::pair<Operand, Value>
+    {
+        if (user >= nquads)
+        {
+            const auto& phi = *all_phis[user - nquads];
+            Value v{};
+            for (auto arg : phi.args)
+            {
+                auto a = arg.kind == Operand::Kind::None ? BOTTOM : valueOf(arg);
+                if (a.state == Value::State::Top)
+                {
+                    continue;
+                }
+                if (v.state == Value::State::Top)
+                {
+                    v = a;
+                }
+                else if (v != a)
+                {
+                    v = BOTTOM;
+                }
+            }
+            return {phi.res, v};
+        }
+
+        const auto& quad = quads[user];
+        if (quad.res.kind != Operand::Kind::Temp)
+        {
+            return {Operand{}, BOTTOM};
+        }
+        if (quad.op == OpCode::Assign)
+        {
+            return {quad.res, valueOf(quad.arg1)};
+        }
+        if (quad.op == OpCode::Call || quad.op == OpCode::Pop)
+        {
+            return {quad.res, BOTTOM};
+        }
+        auto a = valueOf(quad.arg1);
+        auto b = valueOf(quad.arg2);
+        if (a.state == Value::State::Bottom || b.state == Value::State::Bottom)
+        {
+            return {quad.res, BOTTOM};
+        }
+        if (a.state == Value::State::Top || b.state == Value::State::Top)
+        {
+            return {quad.res, Value{}};
+        }
+        auto r = fold(quad.op, a.c, b.c);
+        return {quad.res, r.has_value() ? Value{Value::State::Const, r.value()} : BOTTOM};
+    };
+
+    std::vector<std::uint32_t> work(nquads + all_phis.size());
+    std::iota(work.rbegin(), work.rend(), 0);  // 自前向后求值
+    while (!work.empty())
+    {
+        auto user = work.back();
+        work.pop_back();
+        auto [res, v] = evaluate(user);
+        if (res.kind != Operand::Kind::Temp || values[temps.index(res)] == v)
+        {
+            continue;
+        }
+        values[temps.index(res)] = v;
+        work.insert(work.end(), users[temps.index(res)].begin(), users[temps.index(res)].end());
+    }
+
+    // Step3. 确定复制的源
+    std::vector<Operand> copy_of(temps.size());
+    for (const auto& quad : quads)
+    {
+        if (quad.op == OpCode::Assign && quad.res.kind == Operand::Kind::Temp &&
+            quad.arg1.kind != Operand::Kind::Imm)
+        {
+            copy_of[temps.index(quad.res)] = quad.arg1;
+        }
+    }
+    for (const auto* p_phi : all_phis)
+    {
+        Operand src{};
+        bool trivial = true;
+        for (auto arg : p_phi->args)
+        {
+            if (arg == p_phi->res || arg == src)
+            {
+                continue;
+            }
+            if (arg.kind == Operand::Kind::None || src.kind != Operand::Kind::None)
+            {
+                trivial = false;
+                break;
+            }
+            src = arg;
+        }
+        if (trivial && src.kind != Operand::Kind::None)
+        {
+            copy_of[temps.index(p_phi->res)] = src;
+        }
+    }
+
+    // 复制的源支配复制本身，因此沿复制链上溯不会成环
+    auto replacement = [&](Operand opnd) -> Operand
+    {
+        if (opnd.kind != Operand::Kind::Temp)
+        {
+            return opnd;
+        }
+        while (opnd.kind == Operand::Kind::Temp)
+        {
+            const auto& v = values[temps.index(opnd)];
+            if (v.state == Value::State::Const)
+            {
+                return Operand::imm(v.c);
+            }
+            auto src = copy_of[temps.index(opnd)];
+            if (src.kind == Operand::Kind::None)
+            {
+                break;
+            }
+            opnd = src;
+        }
+        return opnd;
+    };
+
+    // Step4. 替换使用
+    std::size_t changes = 0;
+    auto rewrite = [&](Operand& opnd)
+    {
+        auto r = replacement(opnd);
+        if (r != opnd)
+        {
+            opnd = r;
+            ++changes;
+        }
+    };
+    for (auto& quad : quads)
+    {
+        rewrite(quad.arg1);
+        rewrite(quad.arg2);
+    }
+    for (auto* p_phi : all_phis)
+    {
+        std::ranges::for_each(p_phi->args, rewrite);
+    }
+    return {changes, ANALYSIS_CFG | ANALYSIS_DOMINATORS};
+}
+
+auto ToSsaPass::run(Function& func, AnalysisManager& am) -> PassResult
+{
+    if (func.inSsa())
+    {
+        return {};
+    }
+    am.dominators();  // 构造时删去不可达块需要支配树
+    func.toSsa();
+    return {1, ANALYSIS_CFG | ANALYSIS_DOMINATORS};
+}
+
+auto OutOfSsaPass::run(Function& func, AnalysisManager& am) -> PassResult
+{
+    if (!func.inSsa())
+    {
+        return {};
+    }
+    am.cfg();
+    func.fromSsa();
+    return {1, ANALYSIS_CFG | ANALYSIS_DOMINATORS};
+}
+
+}  // namespace ir
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace ir
+{
+
+// 简化控制流 (非 SSA 形式)：穿过只含 goto 的块改写跳转目标，求值两个操作数都是立即数的
+// 条件跳转，删去不可达的块、跳到下一条四元式的跳转以及没有被引用的标号
+class SimplifyCfgPass : public FunctionPass
+{
+   public:
+    [[nodiscard]] auto name() const -> std::string_view override { return "simplify-cfg"; }
+    auto run(Function& func, AnalysisManager& am) -> PassResult override;
+};
+
+// 删去死代码：非 SSA 形式下依据活跃性删去结果不再使用的无副作用四元式及没有使用的变量声明；
+// SSA 形式下从有副作用的四元式出发标记有用的定值，删去其余的四元式与 φ 函数
+class DeadCodePass : public FunctionPass
+{
+   public:
+    [[nodiscard]] auto name() const -> std::string_view override { return "dce"; }
+    auto run(Function& func, AnalysisManager& am) -> PassResult override;
+
+   private:
+    static auto runOnSsa(Function& func) -> PassResult;
+};
+
+// 稀疏的常量与复制传播 (SSA 形式)：沿定值-使用链求各临时变量的常量值，
+// 把常量与复制的使用替换为立即数与源操作数。溢出与除以零的运算不折叠
+class ConstPropPass : public FunctionPass
+{
+   public:
+    [[nodiscard]] auto name() const -> std::string_view override { return "const-prop"; }
+    auto run(Function& func, AnalysisManager& am) -> PassResult override;
+};
+
+// 构造 SSA 形式
+class ToSsaPass : public FunctionPass
+{
+   public:
+    [[nodiscard]] auto name() const -> std::string_view override { return "to-ssa"; }
+    auto run(Function& func, AnalysisManager& am) -> PassResult override;
+};
+
+// 消去 SSA 形式
+class OutOfSsaPass : public FunctionPass
+{
+   public:
+    [[nodiscard]] auto name() const -> std::string_view override { return "out-of-ssa"; }
+    auto run(Function& func, AnalysisManager& am) -> PassResult override;
+};
+
+}  // namespace ir
@@ -0,0 +1,148 @@
+#include "quad.hpp"
+
+namespace ir
+{
+
+/**
+ * @brief  取变量操作数
+ * @param  name     变量在使用处的作用域全名
+ * @param  local_id 变量在所属函数中的编号
+ * @return 变量操作数，文本与编号都相同的变量共用一个操作数
+ */
+auto NameTable::var(std::string_view name, std::uint32_t local_id) -> Operand
+{
+    auto key = std::uint64_t{strs.intern(name)} << 32 | local_id;
+    auto [it, inserted] = var_index.try_emplace(key, static_cast<std::uint32_t>(vars.size()));
+    if (inserted)
+    {
+        vars.push_back(VarRef{static_cast<util::StringInterner::Id>(key >> 32), local_id});
+    }
+    return Operand::var(it->second);
+}
+
+auto NameTable::label(std::string_view name) -> Operand
+{
+    return Operand::label(strs.intern(name));
+}
+
+/**
+ * @brief  取变量、标号或函数名操作数的文本
+ * @param  opnd 变量或标号操作数
+ * @return 文本
+ */
+auto NameTable::text(Operand opnd) const -> std::string_view
+{
+    return opnd.kind == Operand::Kind::Var ? strs.str(vars[opnd.value].name) : strs.str(opnd.value);
+}
+
+/**
+ * @brief 清空名字表，之前分配的操作数全部失效
+ */
+void NameTable::clear()
+{
+    strs.clear();
+    vars.clear();
+    var_index.clear();
+}
+
+static auto opCode2Str(OpCode op) -> std::string_view
+{
+    switch (op)
+    {
+        case OpCode::Add:
+            return "+";
+        case OpCode::Sub:
+            return "-";
+        case OpCode::Mul:
+            return "*";
+        case OpCode::Div:
+            return "/";
+
+        case OpCode::Jeq:
+            return "j=";
+        case OpCode::Jne:
+            return "j!=";
+        case OpCode::Jge:
+            return "j>=";
+        case OpCode::Jgt:
+            return "j>";
+        case OpCode::Jle:
+            return "j<=";
+        case OpCode::Jlt:
+            return "j<";
+
+        case OpCode::Eq:
+            return "==";
+        case OpCode::Neq:
+            return "!=";
+        case OpCode::Geq:
+            return ">=";
+        case OpCode::Gne:
+            return ">";
+        case OpCode::Leq:
+            return "<=";
+        case OpCode::Lne:
+            return "<";
+
+        case OpCode::Decl:
+            return "decl";
+        case OpCode::Assign:
+            return "=";
+
+        case OpCode::Label:
+            return "label";
+        case OpCode::Goto:
+            return "goto";
+
+        case OpCode::Push:
+            return "push";
+        case OpCode::Pop:
+            return "pop";
+        case OpCode::Call:
+            return "call";
+        case OpCode::Return:
+            return "return";
+    }
+}
+
+static void printOperand(util::BufferedWriter& sink, const NameTable& names, Operand opnd)
+{
+    switch (opnd.kind)
+    {
+        case Operand::Kind::None:
+            sink << '-';
+            break;
+        case Operand::Kind::Temp:
+            sink << 't' << opnd.value;
+            break;
+        case Operand::Kind::Imm:
+            sink << opnd.immValue();
+            break;
+        case Operand::Kind::Var:
+        case Operand::Kind::Label:
+            sink << names.text(opnd);
+            break;
+        case Operand::Kind::Type:
+            sink << "i32";
+            break;
+    }
+}
+
+/**
+ * @brief 以 (op, arg1, arg2, res) 的格式输出一条四元式
+ * @param sink  输出缓冲
+ * @param names 操作数所在的名字表
+ * @param quad  四元式
+ */
+void printQuad(util::BufferedWriter& sink, const NameTable& names, const Quad& quad)
+{
+    sink << '(' << opCode2Str(quad.op) << ", ";
+    printOperand(sink, names, quad.arg1);
+    sink << ", ";
+    printOperand(sink, names, quad.arg2);
+    sink << ", ";
+    printOperand(sink, names, quad.res);
+    sink << ")\n";
+}
+
+}  // namespace ir
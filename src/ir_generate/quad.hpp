@@ -0,0 +1,147 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "util/buffered_writer.hpp"
+#include "util/string_interner.hpp"
+
+namespace ir
+{
+
+enum class OpCode : std::int8_t
+{
+    Add,
+    Sub,
+    Mul,
+    Div,
+
+    Jeq,
+    Jne,
+    Jge,
+    Jgt,
+    Jle,
+    Jlt,
+
+    Eq,
+    Neq,
+    Geq,
+    Gne,
+    Leq,
+    Lne,
+
+    Decl,
+    Assign,
+
+    Label,
+    Goto,
+
+    Push,
+    Pop,
+    Call,
+    Return
+};
+
+constexpr auto isCondJump(OpCode op) -> bool
+{
+    return op >= OpCode::Jeq && op <= OpCode::Jlt;
+}
+
+// 四元式的操作数
+// 编码为 (种类, 32 位值)：临时变量与立即数直接存值，变量、标号与函数名存 NameTable
+// 中的编号。操作数可以直接按整数比较，文本只在输出时生成
+struct Operand
+{
+    enum class Kind : std::uint8_t
+    {
+        None,   // 空操作数
+        Temp,   // 临时变量，value 为编号
+        Var,    // 变量，value 为 NameTable 中变量引用的编号
+        Imm,    // i32 立即数，value 为其位模式
+        Label,  // 标号或函数名，value 为名字的编号
+        Type    // 声明的类型，目前只有 i32
+    };
+
+    Kind kind = Kind::None;
+    std::uint32_t value = 0;
+
+    static constexpr auto temp(std::uint32_t id) -> Operand { return {Kind::Temp, id}; }
+    static constexpr auto var(std::uint32_t id) -> Operand { return {Kind::Var, id}; }
+    static constexpr auto label(std::uint32_t id) -> Operand { return {Kind::Label, id}; }
+    static constexpr auto imm(std::int32_t v) -> Operand
+    {
+        return {Kind::Imm, std::bit_cast<std::uint32_t>(v)};
+    }
+
+    [[nodiscard]] constexpr auto immValue() const -> std::int32_t
+    {
+        return std::bit_cast<std::int32_t>(value);
+    }
+
+    constexpr auto operator==(const Operand&) const -> bool = default;
+};
+
+struct Quad
+{
+    OpCode op;
+    Operand arg1;
+    Operand arg2;
+    Operand res;
+};
+
+static_assert(sizeof(Operand) == 8);
+static_assert(std::is_trivially_copyable_v<Quad>);
+
+// 名字类操作数的文本及变量的身份
+// 变量的文本是它在使用处的作用域全名，同一个变量在不同作用域中使用时文本不同，
+// 同名的变量也可能不是同一个 (遮蔽)。因此变量操作数记录 (文本, 函数内编号) 二元组，
+// 函数内编号即语义检查分配的 symbol::Variable::local_id，供数据流分析与 SSA 构造使用
+class NameTable
+{
+   public:
+    NameTable() = default;
+    NameTable(const NameTable&) = delete;
+    auto operator=(const NameTable&) -> NameTable& = delete;
+
+   public:
+    auto var(std::string_view name, std::uint32_t local_id) -> Operand;
+    auto label(std::string_view name) -> Operand;
+
+    // 判断名字是否为程序中的函数名，优化遍生成新标号时据此避开函数的标号
+    using FuncNameFilter = std::function<bool(std::string_view)>;
+    void setFuncNames(FuncNameFilter is_func) { is_func_name = std::move(is_func); }
+    [[nodiscard]] auto isFuncName(std::string_view name) const -> bool
+    {
+        return is_func_name && is_func_name(name);
+    }
+
+    [[nodiscard]] auto localId(Operand var) const -> std::uint32_t
+    {
+        return vars[var.value].local_id;
+    }
+
+    [[nodiscard]] auto text(Operand opnd) const -> std::string_view;
+
+    void clear();
+
+   private:
+    struct VarRef
+    {
+        util::StringInterner::Id name;
+        std::uint32_t local_id;
+    };
+
+    util::StringInterner strs;  // 变量全名、标号与函数名
+    std::vector<VarRef> vars;
+    std::unordered_map<std::uint64_t, std::uint32_t> var_index;  // (文本, 函数内编号) -> 编号
+    FuncNameFilter is_func_name;  // 不随 clear 清空
+};
+
+void printQuad(util::BufferedWriter& sink, const NameTable& names, const Quad& quad);
+
+}  // namespace ir
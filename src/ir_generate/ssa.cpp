@@ -0,0 +1,495 @@
+#include "function.hpp"
+
+#include <algorithm>
+#include <format>
+#include <unordered_map>
+
+#include "semantic_check/symbol_table.hpp"
+
+// SSA 的构造与消去
+// 构造：按 Cytron 等人的方法在迭代支配边界上放置 φ 函数，再沿支配树重命名。
+// 只为跨块活跃的变量 (在某块中先使用后定值) 放置 φ 函数 (semi-pruned SSA)。
+// 变量的每次定值改写为一个新的临时变量，使用改写为到达该处的临时变量，因此 SSA 形式下
+// 四元式中不再出现变量操作数，变量声明也随之删去。
+// 消去：把 φ 函数变为前驱末尾的并行复制，再按 Boissinot 等人的方法展开为顺序的赋值，
+// 复制成环时借助一个新的临时变量。以条件跳转结束的前驱在跳转之后插入新块，
+// 避免复制影响另一条出边
+
+namespace ir
+{
+
+static constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+
+auto Function::phisOf(BlockId b) const -> std::span<const Phi>
+{
+    if (phis.empty())
+    {
+        return {};
+    }
+    return phis[b];
+}
+
+auto Function::phisOf(BlockId b) -> std::span<Phi>
+{
+    if (phis.empty())
+    {
+        return {};
+    }
+    return phis[b];
+}
+
+auto Function::newTemp() -> Operand
+{
+    return Operand::temp(next_temp++);
+}
+
+/**
+ * @brief  取前驱在块的前驱表中的位置，即 φ 函数中对应实参的下标
+ * @param  b    块号
+ * @param  pred b 的前驱
+ * @return 下标
+ */
+auto Function::predIndex(BlockId b, BlockId pred) const -> std::size_t
+{
+    auto ps = preds(b);
+    return static_cast<std::size_t>(std::ranges::find(ps, pred) - ps.begin());
+}
+
+/**
+ * @brief 删去不可达的块与变量声明，之后重建控制流图
+ */
+void Function::compact()
+{
+    std::vector<Quad> out;
+    out.reserve(code.size());
+    for (BlockId b = 0; b < blocks.size(); ++b)
+    {
+        if (!reachable(b))
+        {
+            continue;
+        }
+        for (const auto& quad : quadsOf(b))
+        {
+            if (quad.op != OpCode::Decl)
+            {
+                out.push_back(quad);
+            }
+        }
+    }
+    code = std::move(out);
+    analyze();
+}
+
+/**
+ * @brief   求各块的支配边界
+ * @details 对每个汇合块，从其各前驱沿支配树上溯到它的直接支配者为止，
+ *          途经的块的支配边界都包含该汇合块 (Cooper 等人的方法)
+ * @return  下标为块号，不可达的块为空
+ */
+auto Function::dominanceFrontiers() const -> std::vector<std::vector<BlockId>>
+{
+    std::vector<std::vector<BlockId>> df(numBlocks());
+    for (BlockId b = 0; b < numBlocks(); ++b)
+    {
+        if (!reachable(b) || preds(b).size() < 2)
+        {
+            continue;
+        }
+        for (auto p : preds(b))
+        {
+            for (auto runner = p; reachable(p) && runner != idoms[b]; runner = idoms[runner])
+            {
+                // 按块号顺序处理汇合块，重复的只会出现在末尾
+                if (df[runner].empty() || df[runner].back() != b)
+                {
+                    df[runner].push_back(b);
+                }
+                if (runner == 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return df;
+}
+
+/**
+ * @brief 把函数转换为 SSA 形式
+ */
+void Function::toSsa()
+{
+    if (ssa)
+    {
+        return;
+    }
+    compact();
+    auto n = numBlocks();
+
+    // Step1. 统计变量的定值块与跨块活跃的变量，并确定新临时变量的起始编号
+    std::uint32_t nvars = 0;
+    for (const auto& quad : code)
+    {
+        for (auto opnd : {quad.arg1, quad.arg2, quad.res})
+        {
+            if (opnd.kind == Operand::Kind::Var)
+            {
+                nvars = std::max(nvars, p_names->localId(opnd) + 1);
+            }
+            else if (opnd.kind == Operand::Kind::Temp)
+            {
+                next_temp = std::max(next_temp, opnd.value + 1);
+            }
+        }
+    }
+
+    std::vector<std::vector<BlockId>> def_blocks(nvars);
+    std::vector<bool> live_across(nvars, false);
+    std::vector<BlockId> def_in(nvars, NO_BLOCK);  // 最近一次定值所在的块
+    for (BlockId b = 0; b < n; ++b)
+    {
+        for (const auto& quad : quadsOf(b))
+        {
+            for (auto opnd : {quad.arg1, quad.arg2})
+            {
+                if (opnd.kind == Operand::Kind::Var && def_in[p_names->localId(opnd)] != b)
+                {
+                    live_across[p_names->localId(opnd)] = true;
+                }
+            }
+            if (quad.res.kind == Operand::Kind::Var)
+            {
+                auto v = p_names->localId(quad.res);
+                if (def_in[v] != b)
+                {
+                    def_in[v] = b;
+                    def_blocks[v].push_back(b);
+                }
+            }
+        }
+    }
+
+    // Step2. 在迭代支配边界上放置 φ 函数
+    auto df = dominanceFrontiers();
+    phis.assign(n, {});
+    std::vector<std::uint32_t> has_phi(n, NONE);  // 已为哪个变量放置了 φ 函数
+    std::vector<std::uint32_t> queued(n, NONE);   // 已为哪个变量加入工作表
+    std::vector<BlockId> work;
+    for (std::uint32_t v = 0; v < nvars; ++v)
+    {
+        if (!live_across[v])
+        {
+            continue;
+        }
+        work = def_blocks[v];
+        for (auto b : work)
+        {
+            queued[b] = v;
+        }
+        while (!work.empty())
+        {
+            auto x = work.back();
+            work.pop_back();
+            for (auto y : df[x])
+            {
+                if (has_phi[y] == v)
+                {
+                    continue;
+                }
+                has_phi[y] = v;
+                phis[y].push_back(Phi{Operand{}, v, std::vector<Operand>(preds(y).size())});
+                if (queued[y] != v)
+                {
+                    queued[y] = v;
+                    work.push_back(y);
+                }
+            }
+        }
+    }
+
+    // Step3. 沿支配树先序遍历重命名，退出子树时恢复各变量的当前值
+    std::vector<std::vector<Operand>> current(nvars);
+    std::vector<std::uint32_t> pushed;  // 依次定值的变量
+
+    auto top = [&](std::uint32_t v) -> Operand
+    { return current[v].empty() ? Operand{} : current[v].back(); };
+
+    auto define = [&](std::uint32_t v) -> Operand
+    {
+        auto t = newTemp();
+        current[v].push_back(t);
+        pushed.push_back(v);
+        return t;
+    };
+
+    auto rename = [&](BlockId b)
+    {
+        for (auto& phi : phis[b])
+        {
+            phi.res = define(phi.var);
+        }
+        for (auto i = blocks[b].begin; i < blocks[b].end; ++i)
+        {
+            auto& quad = code[i];
+            for (auto* p_opnd : {&quad.arg1, &quad.arg2})
+            {
+                if (p_opnd->kind == Operand::Kind::Var &&
+                    !current[p_names->localId(*p_opnd)].empty())
+                {
+                    *p_opnd = top(p_names->localId(*p_opnd));
+                }
+            }
+            if (quad.res.kind == Operand::Kind::Var)
+            {
+                quad.res = define(p_names->localId(quad.res));
+            }
+        }
+        for (auto s : succs(b))
+        {
+            auto j = predIndex(s, b);
+            for (auto& phi : phis[s])
+            {
+                phi.args[j] = top(phi.var);
+            }
+        }
+    };
+
+    struct Frame
+    {
+        BlockId b;
+        std::uint32_t child;  // 下一个待访问的孩子
+        std::size_t mark;     // 进入该块时 pushed 的长度
+    };
+    std::vector<Frame> frames;
+    rename(0);
+    frames.push_back(Frame{0, 0, 0});
+    while (!frames.empty())
+    {
+        auto& frame = frames.back();
+        auto children = domChildren(frame.b);
+        if (frame.child < children.size())
+        {
+            auto c = children[frame.child++];
+            auto mark = pushed.size();
+            rename(c);
+            frames.push_back(Frame{c, 0, mark});
+            continue;
+        }
+        while (pushed.size() > frame.mark)
+        {
+            current[pushed.back()].pop_back();
+            pushed.pop_back();
+        }
+        frames.pop_back();
+    }
+
+    ssa = true;
+}
+
+/**
+ * @brief 取边 from -> to 上由 φ 函数产生的并行复制
+ * @param from   前驱
+ * @param to     后继
+ * @param copies 输出的 (目标, 源) 对，省去源为空与自身到自身的复制
+ */
+void Function::edgeCopies(BlockId from, BlockId to, CopyList& copies) const
+{
+    copies.clear();
+    auto j = predIndex(to, from);
+    for (const auto& phi : phis[to])
+    {
+        auto src = phi.args[j];
+        if (src.kind != Operand::Kind::None && src != phi.res)
+        {
+            copies.emplace_back(phi.res, src);
+        }
+    }
+}
+
+/**
+ * @brief   把并行复制展开为顺序的赋值四元式
+ * @details 先发出目标不再作为源的复制；只剩下环时，把环上一个目标的原值移到新的临时变量中，
+ *          从而打断环。loc[a] 为 a 的原值当前所在的位置，pred[b] 为 b 应取的值，
+ *          同一个源可以复制到多个目标
+ * @param   copies 目标两两不同的并行复制
+ * @param   out    输出的四元式
+ */
+void Function::sequentialize(const CopyList& copies, std::vector<Quad>& out)
+{
+    std::unordered_map<std::uint64_t, std::uint32_t> index;
+    std::vector<Operand> node;
+    auto id = [&](Operand opnd) -> std::uint32_t
+    {
+        auto key = std::uint64_t{static_cast<std::uint8_t>(opnd.kind)} << 32 | opnd.value;
+        auto [it, inserted] = index.try_emplace(key, static_cast<std::uint32_t>(node.size()));
+        if (inserted)
+        {
+            node.push_back(opnd);
+        }
+        return it->second;
+    };
+    for (const auto& [dst, src] : copies)
+    {
+        id(dst);
+        id(src);
+    }
+
+    std::vector<std::uint32_t> loc(node.size(), NONE);
+    std::vector<std::uint32_t> pred(node.size(), NONE);
+    std::vector<bool> assigned(node.size(), false);
+    std::vector<std::uint32_t> ready;
+    std::vector<std::uint32_t> todo;
+    for (const auto& [dst, src] : copies)
+    {
+        loc[id(src)] = id(src);
+        pred[id(dst)] = id(src);
+        todo.push_back(id(dst));
+    }
+    for (const auto& [dst, src] : copies)
+    {
+        if (loc[id(dst)] == NONE)
+        {
+            ready.push_back(id(dst));
+        }
+    }
+
+    auto emit = [&](Operand dst, Operand src)
+    { out.push_back(Quad{OpCode::Assign, src, Operand{}, dst}); };
+
+    while (!todo.empty())
+    {
+        while (!ready.empty())
+        {
+            auto b = ready.back();
+            ready.pop_back();
+            auto a = pred[b];
+            auto c = loc[a];
+            emit(node[b], node[c]);
+            assigned[b] = true;
+            loc[a] = b;
+            if (a == c && pred[a] != NONE)
+            {
+                ready.push_back(a);
+            }
+        }
+        auto b = todo.back();
+        todo.pop_back();
+        if (!assigned[b])
+        {
+            auto saved = static_cast<std::uint32_t>(node.size());
+            node.push_back(newTemp());
+            loc.push_back(NONE);
+            pred.push_back(NONE);
+            assigned.push_back(false);
+            emit(node[saved], node[b]);
+            loc[b] = saved;
+            ready.push_back(b);
+        }
+    }
+}
+
+/**
+ * @brief 消去 φ 函数，把函数转换回普通的四元式
+ */
+void Function::fromSsa()
+{
+    if (!ssa)
+    {
+        return;
+    }
+
+    std::vector<Quad> out;
+    std::vector<Quad> tail;  // 拆分出的跳转目标块，放在函数末尾
+    out.reserve(code.size());
+    CopyList copies;
+    // 与生成器的其他标号一样以函数作用域的标号 (global_<函数名>) 为前缀，
+    // 跳过与程序中某个函数同名的编号
+    auto prefix = symbol::SymbolTable::makeScopeLabel(symbol::SymbolTable::GLOBAL_SCOPE,
+                                                      p_names->text(code[0].arg1));
+    prefix.append("_split");
+    auto newLabel = [&]() -> Operand
+    {
+        auto name = std::format("{}{}", prefix, split_cnt++);
+        while (p_names->isFuncName(name))
+        {
+            name = std::format("{}{}", prefix, split_cnt++);
+        }
+        return p_names->label(name);
+    };
+
+    for (BlockId b = 0; b < numBlocks(); ++b)
+    {
+        // 删去死代码后块可能为空，空块只会顺序执行到下一块
+        auto qs = quadsOf(b);
+        auto last = qs.empty() ? Quad{} : qs.back();
+        BlockId next = b + 1 < numBlocks() ? b + 1 : NO_BLOCK;
+
+        if (!qs.empty() && isCondJump(last.op))
+        {
+            auto jump = last;
+            auto taken = succs(b)[0];
+            out.insert(out.end(), qs.begin(), qs.end() - 1);
+            if (taken == next)
+            {
+                // 跳转与顺序执行到达同一块：在跳转之后插入新块，两条边都经过它
+                edgeCopies(b, taken, copies);
+                if (copies.empty())
+                {
+                    out.push_back(jump);
+                    continue;
+                }
+                auto label = newLabel();
+                jump.res = label;
+                out.push_back(jump);
+                out.push_back(Quad{OpCode::Label, label, Operand{}, Operand{}});
+                sequentialize(copies, out);
+                continue;
+            }
+
+            edgeCopies(b, taken, copies);
+            if (!copies.empty())
+            {
+                auto label = newLabel();
+                jump.res = label;
+                tail.push_back(Quad{OpCode::Label, label, Operand{}, Operand{}});
+                sequentialize(copies, tail);
+                tail.push_back(
+                    Quad{OpCode::Goto, code[blocks[taken].begin].arg1, Operand{}, Operand{}});
+            }
+            out.push_back(jump);
+            if (next != NO_BLOCK)
+            {
+                edgeCopies(b, next, copies);
+                sequentialize(copies, out);
+            }
+            continue;
+        }
+
+        if (succs(b).size() != 1)
+        {
+            out.insert(out.end(), qs.begin(), qs.end());
+            continue;
+        }
+        edgeCopies(b, succs(b)[0], copies);
+        if (!qs.empty() && last.op == OpCode::Goto)
+        {
+            out.insert(out.end(), qs.begin(), qs.end() - 1);
+            sequentialize(copies, out);
+            out.push_back(last);
+        }
+        else
+        {
+            out.insert(out.end(), qs.begin(), qs.end());
+            sequentialize(copies, out);
+        }
+    }
+
+    // 最后一个可达块以 return 或 goto 结束，末尾追加的块不会被顺序执行到达
+    out.insert(out.end(), tail.begin(), tail.end());
+    code = std::move(out);
+    phis.clear();
+    ssa = false;
+    analyze();
+}
+
+}  // namespace ir
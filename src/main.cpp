@@ -1,28 +1,37 @@
 #include <getopt.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
-#include <tuple>
+#include <string_view>
 
 #include "err_report/error_reporter.hpp"
+#include "ir_generate/function.hpp"
 #include "ir_generate/ir_generator.hpp"
+#include "ir_generate/pass_manager.hpp"
 #include "lexer/toy_lexer.hpp"
 #include "parser/ast.hpp"
 #include "parser/parser.hpp"
 #include "preproc/preproc.hpp"
 #include "semantic_check/semantic_checker.hpp"
+#include "semantic_check/symbol_interface.hpp"
 #include "semantic_check/symbol_table.hpp"
+#include "util/parallel.hpp"
 #include "util/print.hpp"
 
 std::unique_ptr<lexer::base::Lexer> lex{};              // 词法分析器
 std::unique_ptr<parser::base::Parser> pars{};           // 语法分析器
 std::shared_ptr<symbol::SymbolTable> stable{};          // 符号表
 std::unique_ptr<semantic::SemanticChecker> schecker{};  // 语义检查器
-std::unique_ptr<ir::IrGenerator> generator{};           // 中间代码生成器
 std::shared_ptr<error::ErrorReporter> reporter{};       // 错误报告器
+std::string source{};                                   // 输入文件原始文本
 
 /**
  * @brief 检查文件流是否正常打开
@@ -49,11 +58,12 @@ void initialize(std::ifstream& in)
 {
     std::ostringstream oss;
     oss << in.rdbuf();
+    source = oss.str();
 
     // 初始化错误报告器
-    reporter = std::make_shared<error::ErrorReporter>(oss.str());  // 保留原始文本信息
+    reporter = std::make_shared<error::ErrorReporter>(source);  // 保留原始文本信息
 
-    std::istringstream iss{preproc::removeAnnotations(oss.str())};  // 删除注释
+    std::istringstream iss{preproc::removeAnnotations(source)};  // 删除注释
 
     std::vector<std::string> text{};
     std::string line{};
@@ -76,25 +86,81 @@ void initialize(std::ifstream& in)
     // 初始化符号表
     stable = std::make_shared<symbol::SymbolTable>();
 
-    // 初始化中间代码生成器
-    generator = std::make_unique<ir::IrGenerator>();
-
     // 设置错误报告器
     lex->setErrReporter(reporter);
     schecker->setErrorReporter(reporter);
 
     // 设置符号表
     schecker->setSymbolTable(stable);
-    generator->setSymbolTable(stable);
+}
+
+// 命令行选项
+struct Options
+{
+    bool flag_token{false};        // 输出 token
+    bool flag_parse{false};        // 输出 AST
+    bool flag_semantic{false};     // 语义检查
+    bool flag_generate{false};     // 生成中间代码
+    bool flag_hash_cons{false};    // 解析时共享结构相同的纯表达式结点
+    bool flag_emit_json{false};    // 以 JSON 格式导出 AST
+    bool flag_stream{false};       // 逐个函数地检查、生成并输出，输出后释放其作用域
+    bool flag_emit_symi{false};    // 输出符号接口文件
+    bool flag_time_passes{false};  // 输出各优化遍的耗时
+
+    std::size_t opt_level{0};  // 优化级别 (-O0/-O1/-O2)
+
+    std::size_t jobs{util::defaultJobs()};  // 工作线程数
+
+    std::optional<std::string> dot_func{};       // 只输出该函数的 AST
+    std::optional<std::size_t> dot_max_depth{};  // AST 的最大展开深度
+
+    std::vector<std::string> imports{};  // 导入的符号接口文件
+
+    error::DiagFormat diag_format{error::DiagFormat::Human};  // 诊断信息的输出格式
+
+    std::string in_file{};   // 输入文件名
+    std::string out_file{};  // 输出文件名
+};
+
+// 仅有长选项形式的参数
+enum LongOnlyOption : int
+{
+    OPT_HASH_CONS = 256,
+    OPT_DOT_FUNC,
+    OPT_DOT_MAX_DEPTH,
+    OPT_EMIT_AST,
+    OPT_STREAM,
+    OPT_EMIT_SYMI,
+    OPT_IMPORT,
+    OPT_DIAG_FORMAT,
+    OPT_TIME_PASSES,
+};
+
+/**
+ * @brief  解析非负整数参数
+ * @param  arg  命令行参数值
+ * @param  what 参数含义，用于错误信息
+ * @return 解析得到的整数
+ */
+auto parseCount(const char* arg, const char* what) -> std::size_t
+{
+    std::size_t value{0};
+    auto [ptr, ec] = std::from_chars(arg, arg + std::strlen(arg), value);
+    if (ec != std::errc{} || *ptr != '\0')
+    {
+        std::cerr << "无效的" << what << ": " << arg << std::endl;
+        exit(1);
+    }
+    return value;
 }
 
 /**
  * @brief  参数解析
  * @param  argc argument counter
  * @param  argv argument vector
- * @return tuple: flag_default, flag_parse, flag_token, in_file, out_file
+ * @return Options 解析得到的命令行选项
  */
-auto argumentParsing(int argc, char* argv[])
+auto argumentParsing(int argc, char* argv[]) -> Options
 {
     // 定义长选项
     static const struct option long_options[] = {
@@ -106,22 +172,32 @@ auto argumentParsing(int argc, char* argv[])
         {.name = "parse", .has_arg = no_argument, .flag = nullptr, .val = 'p'},
         {.name = "semantic", .has_arg = no_argument, .flag = nullptr, .val = 's'},
         {.name = "generate", .has_arg = no_argument, .flag = nullptr, .val = 'g'},
+        {.name = "jobs", .has_arg = required_argument, .flag = nullptr, .val = 'j'},
+        {.name = "hash-cons", .has_arg = no_argument, .flag = nullptr, .val = OPT_HASH_CONS},
+        {.name = "dot-func", .has_arg = required_argument, .flag = nullptr, .val = OPT_DOT_FUNC},
+        {.name = "dot-max-depth",
+         .has_arg = required_argument,
+         .flag = nullptr,
+         .val = OPT_DOT_MAX_DEPTH},
+        {.name = "emit-ast", .has_arg = required_argument, .flag = nullptr, .val = OPT_EMIT_AST},
+        {.name = "stream", .has_arg = no_argument, .flag = nullptr, .val = OPT_STREAM},
+        {.name = "emit-symi", .has_arg = no_argument, .flag = nullptr, .val = OPT_EMIT_SYMI},
+        {.name = "import", .has_arg = required_argument, .flag = nullptr, .val = OPT_IMPORT},
+        {.name = "diagnostics-format",
+         .has_arg = required_argument,
+         .flag = nullptr,
+         .val = OPT_DIAG_FORMAT},
+        {.name = "time-passes", .has_arg = no_argument, .flag = nullptr, .val = OPT_TIME_PASSES},
         {.name = nullptr, .has_arg = 0, .flag = nullptr, .val = 0}  // 结束标志
     };
 
     int opt{};  // option
     int option_index{0};
 
-    bool flag_token{false};  // 输出 token
-    bool flag_parse{false};  // 输出 AST
-    bool flag_semantic{false};
-    bool flag_generate{false};
-
-    std::string in_file{};   // 输入文件名
-    std::string out_file{};  // 输出文件名
+    Options opts{};
 
     // 参数解析
-    while ((opt = getopt_long(argc, argv, "hvVi:o:tpsg", long_options, &option_index)) != -1)
+    while ((opt = getopt_long(argc, argv, "hvVi:o:tpsgj:O:", long_options, &option_index)) != -1)
     {
         switch (opt)
         {
@@ -133,22 +209,89 @@ auto argumentParsing(int argc, char* argv[])
                 util::printVersion();
                 exit(0);
             case 'i':  // input
-                in_file = std::string{optarg};
+                opts.in_file = std::string{optarg};
                 break;
             case 'o':  // output
-                out_file = std::string{optarg};
+                opts.out_file = std::string{optarg};
                 break;
             case 't':  // token
-                flag_token = true;
+                opts.flag_token = true;
                 break;
             case 'p':  // parse
-                flag_parse = true;
+                opts.flag_parse = true;
                 break;
             case 's':  // semantic check
-                flag_semantic = true;
+                opts.flag_semantic = true;
                 break;
             case 'g':  // ir generate
-                flag_generate = true;
+                opts.flag_generate = true;
+                break;
+            case 'j':  // jobs
+                opts.jobs = parseCount(optarg, "线程数");
+                if (opts.jobs == 0)
+                {
+                    std::cerr << "线程数至少为 1" << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'O':  // 优化级别
+                opts.opt_level = parseCount(optarg, "优化级别");
+                if (opts.opt_level > 2)
+                {
+                    std::cerr << "不支持的优化级别: -O" << optarg << std::endl;
+                    exit(1);
+                }
+                break;
+            case OPT_HASH_CONS:  // hash-consing
+                opts.flag_hash_cons = true;
+                break;
+            case OPT_DOT_FUNC:  // 只输出指定函数的 AST
+                opts.dot_func = std::string{optarg};
+                break;
+            case OPT_DOT_MAX_DEPTH:  // AST 最大展开深度
+                opts.dot_max_depth = parseCount(optarg, "深度");
+                break;
+            case OPT_EMIT_AST:  // 导出 AST
+                if (std::string_view{optarg} != "json")
+                {
+                    std::cerr << "不支持的 AST 导出格式: " << optarg << std::endl;
+                    exit(1);
+                }
+                opts.flag_emit_json = true;
+                break;
+            case OPT_STREAM:  // 流式检查与生成
+                opts.flag_stream = true;
+                break;
+            case OPT_EMIT_SYMI:  // 输出符号接口文件
+                opts.flag_emit_symi = true;
+                break;
+            case OPT_IMPORT:  // 导入符号接口文件
+                opts.imports.emplace_back(optarg);
+                break;
+            case OPT_DIAG_FORMAT:  // 诊断信息的输出格式
+            {
+                std::string_view format{optarg};
+                if (format == "human")
+                {
+                    opts.diag_format = error::DiagFormat::Human;
+                }
+                else if (format == "json")
+                {
+                    opts.diag_format = error::DiagFormat::Json;
+                }
+                else if (format == "sarif")
+                {
+                    opts.diag_format = error::DiagFormat::Sarif;
+                }
+                else
+                {
+                    std::cerr << "不支持的诊断信息格式: " << optarg << std::endl;
+                    exit(1);
+                }
+                break;
+            }
+            case OPT_TIME_PASSES:  // 输出各优化遍的耗时
+                opts.flag_time_passes = true;
                 break;
             case '?':  // 无效选项
                 std::cerr << "解析到未知参数" << std::endl
@@ -157,13 +300,13 @@ auto argumentParsing(int argc, char* argv[])
         }  // end switch
     }  // end while
 
-    if (in_file.empty())
+    if (opts.in_file.empty())
     {
         std::cerr << "缺失命令行参数: -i/--input" << std::endl;
         exit(1);
     }
 
-    return std::make_tuple(flag_token, flag_parse, flag_semantic, flag_generate, in_file, out_file);
+    return opts;
 }
 
 /**
@@ -199,74 +342,299 @@ auto printToken(std::ofstream& out) -> bool
 }
 
 /**
- * @brief 以 dot 格式打印 AST
- * @param out 输出文件流
+ * @brief  构造语法分析器
+ * @param  opts 命令行选项
+ * @return 语法分析器
  */
-auto printAST(std::ofstream& out) -> bool
-{  // 初始化 parser
+auto createParser(const Options& opts) -> std::unique_ptr<parser::base::Parser>
+{
     auto nextTokenFunc = []()
     {
         return lex->nextToken();  // 封装 nextToken() 方法
     };
-    pars = std::make_unique<parser::base::Parser>(nextTokenFunc);
+    auto p = std::make_unique<parser::base::Parser>(nextTokenFunc, reporter);
+    if (opts.flag_hash_cons)
+    {
+        p->enableHashConsing();
+    }
+    return p;
+}
+
+/**
+ * @brief  解析输入文件
+ * @param  opts 命令行选项
+ * @return AST 根结点；有词法或语法错误时输出错误并返回 nullptr
+ */
+auto parseSource(const Options& opts) -> parser::ast::ProgPtr
+{
+    pars = createParser(opts);
 
     auto p_prog = pars->parseProgram();
+    if (reporter->hasLexErr())
+    {  // 解析在词法错误处终止，之后的语法错误没有意义
+        reporter->displayLexErrs();
+        return nullptr;
+    }
+    if (reporter->hasParseErr())
+    {
+        reporter->displayParseErrs();
+        return nullptr;
+    }
+
+    return p_prog;
+}
+
+/**
+ * @brief 以 dot 格式打印 AST
+ * @param out  输出文件流
+ * @param opts 命令行选项
+ */
+auto printAST(std::ofstream& out, const Options& opts) -> bool
+{  // 初始化 parser
+    auto p_prog = parseSource(opts);
+    if (!p_prog)
+    {
+        return false;
+    }
     std::cout << "Parsing success" << std::endl;
 
-    parser::ast::ast2Dot(out, p_prog);
+    if (opts.dot_func.has_value() &&
+        std::ranges::none_of(p_prog->decls,
+                             [&opts](const parser::ast::DeclPtr& decl)
+                             {
+                                 auto fd = std::dynamic_pointer_cast<parser::ast::FuncDecl>(decl);
+                                 return fd && fd->header->name == opts.dot_func.value();
+                             }))
+    {
+        std::cerr << "未找到函数: " << opts.dot_func.value() << std::endl;
+        return false;
+    }
+
+    parser::ast::ast2Dot(out, p_prog,
+                         {.jobs = opts.jobs, .func = opts.dot_func, .max_depth = opts.dot_max_depth});
 
     return true;
 }
 
 /**
- * @brief 检查语义
- * @param out 输出文件流
+ * @brief 以 JSON 格式导出 AST
+ * @param out  输出文件流
+ * @param opts 命令行选项
  */
-auto checkSemantic(std::ofstream& out) -> bool
+auto emitAstJson(std::ofstream& out, const Options& opts) -> bool
 {
-    auto nextTokenFunc = []()
+    auto p_prog = parseSource(opts);
+    if (!p_prog)
     {
-        return lex->nextToken();  // 封装 nextToken() 方法
-    };
-    pars = std::make_unique<parser::base::Parser>(nextTokenFunc);
+        return false;
+    }
 
-    auto p_prog = pars->parseProgram();
-    schecker->checkProg(p_prog);
+    parser::ast::ast2Json(out, p_prog);
 
-    if (reporter->hasSemanticErr())
+    return true;
+}
+
+/**
+ * @brief 导入命令行指定的符号接口文件，其中的函数可以在本文件中调用
+ * @param opts 命令行选项
+ */
+void importInterfaces(const Options& opts)
+{
+    for (const auto& path : opts.imports)
     {
-        reporter->displaySemanticErrs();
-        return false;
+        std::ifstream in{path, std::ios::binary};
+        checkFileStream(in, "Failed to open symbol interface file: " + path);
+        try
+        {
+            symbol::importInterface(*stable, symbol::readInterface(in));
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << "无法导入符号接口文件 " << path << ": " << e.what() << std::endl;
+            exit(1);
+        }
     }
+}
 
-    stable->printSymbol(out);
+/**
+ * @brief   构造本文件的符号接口
+ * @details 函数的源码范围为从其所在行到下一个函数所在行之前，函数哈希即该范围文本的哈希
+ * @param   p_prog 程序根节点指针
+ * @return  符号接口
+ */
+auto buildInterface(const parser::ast::ProgPtr& p_prog) -> symbol::Interface
+{
+    std::vector<std::size_t> line_begin{0};  // 各行在源文本中的起始位置
+    for (std::size_t i = 0; i < source.size(); ++i)
+    {
+        if (source[i] == '\n')
+        {
+            line_begin.push_back(i + 1);
+        }
+    }
+    auto offset = [&](std::size_t row)
+    {
+        return row < line_begin.size() ? line_begin[row] : source.size();
+    };
 
-    return true;
+    symbol::Interface iface{.source_hash = symbol::contentHash(source), .funcs = {}};
+    const auto& decls = p_prog->decls;
+    for (std::size_t i = 0; i < decls.size(); ++i)
+    {
+        auto p_fdecl = std::dynamic_pointer_cast<parser::ast::FuncDecl>(decls[i]);
+        auto row = p_fdecl->pos.row;
+        auto end_row = row + 1;
+        if (i + 1 < decls.size())
+        {
+            end_row = std::max(end_row, decls[i + 1]->pos.row);
+        }
+        auto begin = offset(row);
+        auto end = offset(end_row);
+
+        const auto* p_func = stable->lookupFunc(p_fdecl->header->name).value();
+        iface.funcs.push_back(symbol::FuncInterface{
+            .name = p_fdecl->header->name,
+            .argc = p_func->argc,
+            .retval_type = p_func->retval_type,
+            .hash = symbol::contentHash(std::string_view{source}.substr(begin, end - begin))});
+    }
+    return iface;
 }
 
 /**
- * @brief 生成中间代码
- * @param out 输出文件流
+ * @brief   检查语义并生成中间代码 (-s/-g)
+ * @details 程序只遍历一遍：每个函数体检查完成后，若尚未发现语义错误，检查它的工作线程随即用
+ *          独立的生成器为该函数生成中间代码 (-g)，指定 -O1/-O2 时再经过对应的优化遍，
+ *          各函数的翻译与优化因此同检查一样并行进行。各函数的四元式按源码顺序输出，
+ *          临时变量在函数内编号，输出与线程数无关。
+ *          出错的函数及其后的函数不再输出中间代码，输出文件最终会被删除。
+ *          指定 --stream 时，函数的变量符号也随即输出 (-s)，随后释放该函数的作用域子树，
+ *          因此符号表占用的内存只与最大的函数有关，而与整个程序的规模无关；
+ *          否则作用域子树并入符号表，检查完成后整体输出
+ * @param   out_symbol 符号表输出文件流
+ * @param   out_ir     中间代码输出文件流
+ * @param   out_symi   符号接口输出文件流
+ * @param   opts       命令行选项
+ * @return  是否没有语义错误
  */
-auto generateIr(std::ofstream& out) -> bool
+auto compile(std::ofstream& out_symbol, std::ofstream& out_ir, std::ofstream& out_symi,
+             const Options& opts) -> bool
 {
-    auto nextTokenFunc = []()
+    importInterfaces(opts);
+
+    auto p_prog = parseSource(opts);
+    if (!p_prog)
     {
-        return lex->nextToken();  // 封装 nextToken() 方法
+        return false;
+    }
+
+    // 函数符号在第一遍检查后即已齐全，在输出第一个函数的变量符号前输出
+    bool header_written{false};
+    auto writeHeader = [&]()
+    {
+        if (opts.flag_semantic && opts.flag_stream && !header_written)
+        {
+            stable->printFuncSymbols(out_symbol);
+            header_written = true;
+        }
     };
-    pars = std::make_unique<parser::base::Parser>(nextTokenFunc);
 
-    auto p_prog = pars->parseProgram();
-    schecker->checkProg(p_prog);
+    // 从 main 不可达的函数不生成 IR；没有 main 时 (如库文件) 保留所有函数
+    // 在工作线程上首次用到时计算
+    std::vector<bool> live;
+    std::once_flag live_once;
+    auto isLive = [&](const parser::ast::FuncDeclPtr& p_fdecl) -> bool
+    {
+        const auto& graph = schecker->getCallGraph();
+        std::call_once(live_once,
+                       [&]()
+                       {
+                           auto entry = graph.find("main");
+                           live = entry.has_value() ? graph.reachableFrom(entry.value())
+                                                    : std::vector<bool>(graph.size(), true);
+                       });
+        return live[graph.find(p_fdecl->header->name).value()];
+    };
+
+    // 在工作线程上生成并优化的函数，等待按源码顺序输出。
+    // 每个函数使用各自的流水线副本，统计最终并入 passes；-O0 时没有优化遍
+    struct LoweredFunc
+    {
+        std::unique_ptr<ir::IrGenerator> p_gen;
+        ir::PassManager passes;
+    };
+    std::vector<LoweredFunc> lowered(p_prog->decls.size());
+    auto passes = ir::PassManager::forLevel(opts.opt_level);
+
+    schecker->setJobs(opts.jobs);
+    schecker->checkProg(
+        p_prog,
+        [&](std::size_t i, const parser::ast::FuncDeclPtr& /*p_fdecl*/,
+            const std::shared_ptr<symbol::SymbolTable>& p_sub)
+        {
+            auto slot = std::move(lowered[i]);  // 输出后即释放该函数的四元式
+            if (schecker->errorCount() > 0)
+            {  // 出错后不再输出，输出文件最终会被删除
+                return;
+            }
+
+            writeHeader();
+            if (opts.flag_semantic && opts.flag_stream)
+            {
+                p_sub->printVarSymbols(out_symbol);
+            }
+            if (slot.p_gen)
+            {
+                slot.p_gen->printQuads(out_ir);
+                passes.mergeStats(slot.passes);
+            }
+            if (!opts.flag_stream)
+            {
+                stable->mergeSubtable(std::move(*p_sub));
+            }
+        },
+        [&](std::size_t i, const parser::ast::FuncDeclPtr& p_fdecl)
+        {
+            if (!opts.flag_generate || schecker->errorCount() > 0 || !isLive(p_fdecl))
+            {
+                return;
+            }
+            auto& slot = lowered[i];
+            slot.p_gen = std::make_unique<ir::IrGenerator>();
+            slot.p_gen->setFuncNames([](std::string_view name)
+                                     { return schecker->getCallGraph().find(name).has_value(); });
+            if (opts.flag_hash_cons)
+            {
+                slot.p_gen->enableExprReuse();
+            }
+            slot.p_gen->generateFuncDecl(p_fdecl);
+            slot.passes = ir::PassManager::forLevel(opts.opt_level);
+            if (!slot.passes.empty())
+            {
+                slot.p_gen->optimize(slot.passes);
+            }
+        });
+
+    if (opts.flag_time_passes)
+    {
+        passes.report(std::cerr);
+    }
+
     if (reporter->hasSemanticErr())
     {
         reporter->displaySemanticErrs();
         return false;
     }
 
-    generator->generateProg(p_prog);
-
-    generator->printQuads(out);
+    writeHeader();
+    if (opts.flag_semantic && !opts.flag_stream)
+    {
+        stable->printSymbol(out_symbol);
+    }
+    if (opts.flag_emit_symi)
+    {
+        symbol::writeInterface(out_symi, buildInterface(p_prog));
+    }
 
     return true;
 }
@@ -277,54 +645,62 @@ auto generateIr(std::ofstream& out) -> bool
  */
 auto main(int argc, char* argv[]) -> int
 {
-    auto [flag_token, flag_parse, flag_semantic, flag_generate, in_file, out_file] =
-        argumentParsing(argc, argv);
+    auto opts = argumentParsing(argc, argv);
 
     std::ifstream in{};
     std::ofstream out_token{};
     std::ofstream out_parse{};
     std::ofstream out_semantic{};
     std::ofstream out_generate{};
+    std::ofstream out_json{};
+    std::ofstream out_symi{};
 
-    in.open(in_file);
+    in.open(opts.in_file);
     checkFileStream(in, std::string{"Failed to open input file."});
 
-    std::string base = out_file.empty() ? "output" : out_file;
+    std::string base = opts.out_file.empty() ? "output" : opts.out_file;
     out_token.open(base + std::string{".token"});
     out_parse.open(base + std::string{".dot"});
     out_semantic.open(base + std::string{".symbol"});
     out_generate.open(base + std::string{".ir"});
+    out_json.open(base + std::string{".json"});
+    out_symi.open(base + std::string{".symi"}, std::ios::binary);
 
     checkFileStream(out_token, std::string{"Failed to open output file (token)"});
     checkFileStream(out_parse, std::string{"Failed to open output file (parse)"});
     checkFileStream(out_semantic, std::string{"Failed to open output file (semantic)"});
     checkFileStream(out_generate, std::string{"Failed to open output file (ir generate)"});
+    checkFileStream(out_json, std::string{"Failed to open output file (json)"});
+    checkFileStream(out_symi, std::string{"Failed to open output file (symi)"});
 
     initialize(in);
+    reporter->setFormat(opts.diag_format, opts.in_file);
 
     bool token_ok{false};
     bool parse_ok{false};
     bool semantic_ok{false};
     bool generate_ok{false};
+    bool json_ok{false};
+    bool symi_ok{false};
 
-    if (flag_token)
+    if (opts.flag_token)
     {
         token_ok = printToken(out_token);
     }
-    if (flag_parse)
+    if (opts.flag_parse)
     {
         lex->reset(util::Position(0, 0));
-        parse_ok = printAST(out_parse);
+        parse_ok = printAST(out_parse, opts);
     }
-    if (flag_semantic)
+    if (opts.flag_emit_json)
     {
         lex->reset(util::Position(0, 0));
-        semantic_ok = checkSemantic(out_semantic);
+        json_ok = emitAstJson(out_json, opts);
     }
-    if (flag_generate)
+    if (opts.flag_semantic || opts.flag_generate || opts.flag_emit_symi)
     {
         lex->reset(util::Position(0, 0));
-        generate_ok = generateIr(out_generate);
+        semantic_ok = generate_ok = symi_ok = compile(out_semantic, out_generate, out_symi, opts);
     }
 
     in.close();
@@ -332,23 +708,33 @@ auto main(int argc, char* argv[]) -> int
     out_parse.close();
     out_semantic.close();
     out_generate.close();
+    out_json.close();
+    out_symi.close();
 
-    if (!flag_token || !token_ok)
+    if (!opts.flag_token || !token_ok)
     {
         std::filesystem::remove(base + ".token");
     }
-    if (!flag_parse || !parse_ok)
+    if (!opts.flag_parse || !parse_ok)
     {
         std::filesystem::remove(base + ".dot");
     }
-    if (!flag_semantic || !semantic_ok)
+    if (!opts.flag_semantic || !semantic_ok)
     {
         std::filesystem::remove(base + ".symbol");
     }
-    if (!flag_generate || !generate_ok)
+    if (!opts.flag_generate || !generate_ok)
     {
         std::filesystem::remove(base + ".ir");
     }
+    if (!opts.flag_emit_json || !json_ok)
+    {
+        std::filesystem::remove(base + ".json");
+    }
+    if (!opts.flag_emit_symi || !symi_ok)
+    {
+        std::filesystem::remove(base + ".symi");
+    }
 
     return 0;
 }
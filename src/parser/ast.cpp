@@ -1,58 +1,159 @@
 #include "ast.hpp"
 
 #include <cassert>
-#include <sstream>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "lexer/token_type.hpp"
+#include "util/buffered_writer.hpp"
+#include "util/parallel.hpp"
 
 namespace parser::ast
 {
 
-static int cnt = 0;
+/**
+ * @brief 以十进制形式追加一个无符号整数
+ * @param buf   缓冲区
+ * @param value 整数值
+ */
+static void appendNum(std::string& buf, std::size_t value)
+{
+    char tmp[24];
+    auto [end, ec] = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    buf.append(tmp, end);
+}
 
-// dot 结点声明
-struct DotNodeDecl
+// DOT 输出器：每个函数一个实例，边遍历 AST 边把结点和边的声明写入自己的缓冲区。
+// 结点名由函数下标和函数内的局部计数器组成 (f<函数下标>_n<局部编号>)，
+// 不依赖任何全局状态，因此不同函数可以在不同线程上同时输出，且结果与线程数无关。
+class DotWriter
 {
-    std::string name;   // 结点名 - 唯一，用于区分不同结点
-    std::string label;  // 标签 - 不唯一，用于图片显示
+   public:
+    using NodeId = std::size_t;
 
-    DotNodeDecl() = default;
-    explicit DotNodeDecl(const std::string& n, const std::string& l) : name(n), label(l) {}
-    explicit DotNodeDecl(std::string&& n, std::string&& l) : name(std::move(n)), label(std::move(l))
+    // 进入下一层嵌套，离开作用域时自动返回
+    class Level
+    {
+       public:
+        explicit Level(DotWriter& w) : w(w) { ++w.depth; }
+        Level(const Level&) = delete;
+        auto operator=(const Level&) -> Level& = delete;
+        ~Level() { --w.depth; }
+
+       private:
+        DotWriter& w;
+    };
+
+    DotWriter() = delete;
+    DotWriter(std::size_t func_idx, std::optional<std::size_t> max_depth)
+        : func_idx(func_idx), max_depth(max_depth)
     {
     }
 
-    ~DotNodeDecl() = default;
+   public:
+    /**
+     * @brief  当前嵌套层次是否已达到深度限制
+     * @return 达到限制时为 true，此时不应再展开子树
+     */
+    [[nodiscard]] auto atDepthLimit() const -> bool
+    {
+        return max_depth.has_value() && depth >= max_depth.value();
+    }
 
-    [[nodiscard]] auto initialized() const -> bool { return !name.empty() && !label.empty(); }
-    [[nodiscard]] auto toString() const -> std::string { return name + label; }
-};
+    /**
+     * @brief  声明一个折叠结点，代替未展开的子树
+     * @param  label 被折叠子树的类别
+     * @return 结点编号
+     */
+    auto summary(std::string_view label) -> NodeId
+    {
+        NodeId id = cnt++;
+        buf.append("        ");
+        appendName(id);
+        buf.append(" [label = \"").append(label).append(" ...\", shape=box, style=dashed]\n");
+        return id;
+    }
 
-/**
- * @brief  通过名称构造带编号的 DOT 节点声明
- * @param  s std::string 节点名称
- * @return DotNodeDecl
- */
-static auto str2NodeDecl(const std::string& s) -> DotNodeDecl
-{
-    std::ostringstream oss;
-    oss << s << cnt++;  // 确保唯一性
-    std::string name{oss.str()};
-    std::string label{"[label = \"" + s + "\"]"};
+    /**
+     * @brief  声明一个新结点
+     * @param  label 结点标签 - 不唯一，用于图片显示
+     * @return 结点编号 - 函数内唯一，用于区分不同结点
+     */
+    auto node(std::string_view label) -> NodeId
+    {
+        NodeId id = cnt++;
+        buf.append("        ");
+        appendName(id);
+        buf.append(" [label = \"").append(label).append("\"]\n");
+        return id;
+    }
 
-    return DotNodeDecl{name, label};
-}
+    /**
+     * @brief 声明一条边
+     * @param from 起始结点
+     * @param to   终止结点
+     */
+    void edge(NodeId from, NodeId to)
+    {
+        buf.append("        ");
+        appendName(from);
+        buf.append(" -> ");
+        appendName(to);
+        buf.push_back('\n');
+    }
+
+    /**
+     * @brief  声明一个结点并连接到父结点
+     * @param  parent 父结点
+     * @param  label  结点标签
+     * @return 结点编号
+     */
+    auto child(NodeId parent, std::string_view label) -> NodeId
+    {
+        NodeId id = node(label);
+        edge(parent, id);
+        return id;
+    }
+
+    /**
+     * @brief  取出已输出的内容
+     * @return 结点和边的声明串
+     */
+    auto take() -> std::string { return std::move(buf); }
+
+   private:
+    void appendName(NodeId id)
+    {
+        buf.push_back('f');
+        appendNum(buf, func_idx);
+        buf.append("_n");
+        appendNum(buf, id);
+    }
+
+   private:
+    std::size_t func_idx;                    // 函数下标
+    std::optional<std::size_t> max_depth{};  // 最大展开深度，为空时不限制
+    std::size_t depth = 0;                   // 当前嵌套层次
+    NodeId cnt = 0;                          // 函数内的结点计数器，确保结点名唯一
+    std::string buf;                         // 输出缓冲区
+};
+
+using NodeId = DotWriter::NodeId;
 
 /**
- * @brief  通过 token type 构造 DOT 结点声明
+ * @brief  取 token type 对应的 DOT 结点标签
  * @param  t token type
- * @return DotNodeDecl
+ * @return 结点标签
  */
-static auto tokenType2NodeDecl(lexer::token::Type t) -> DotNodeDecl
+static auto tokenTypeLabel(lexer::token::Type t) -> std::string_view
 {
     using TokenType = lexer::token::Type;
-    static const std::unordered_map<TokenType, std::string> map{
+    static const std::unordered_map<TokenType, std::string_view> map{
         {TokenType::REF, "&"},      {TokenType::LPAREN, "("},    {TokenType::RPAREN, ")"},
         {TokenType::LBRACE, "{"},   {TokenType::RBRACE, "}"},    {TokenType::LBRACK, "["},
         {TokenType::RBRACK, "]"},   {TokenType::SEMICOLON, ";"}, {TokenType::COLON, ":"},
@@ -63,17 +164,12 @@ static auto tokenType2NodeDecl(lexer::token::Type t) -> DotNodeDecl
         {TokenType::OP_EQ, "=="},   {TokenType::OP_NEQ, "!="},   {TokenType::OP_LT, "<"},
         {TokenType::OP_LE, "<="},   {TokenType::OP_GT, ">"},     {TokenType::OP_GE, ">="}};
 
-    if (!map.contains(t))
+    auto res = map.find(t);
+    if (res == map.end())
     {
-        throw std::runtime_error{"tokenType2NodeDecl(): Unknown Token Type."};
+        throw std::runtime_error{"tokenTypeLabel(): Unknown Token Type."};
     }
-
-    std::ostringstream oss;
-    oss << lexer::token::tokenType2str(t) << cnt++;
-    std::string name{oss.str()};
-    std::string label = "[label = \"" + map.find(t)->second + "\"]";
-
-    return DotNodeDecl{name, label};
+    return res->second;
 }
 
 /**
@@ -121,116 +217,34 @@ static auto arithOper2TokenType(ast::ArithOperator op) -> lexer::token::Type
 }
 
 /**
- * @brief  通过 comparison operator 构造 DOT 结点声明
- * @param  op comparison operator
- * @return DotNodeDecl
- */
-static inline auto comparOper2NodeDecl(ast::ComparOperator op) -> DotNodeDecl
-{  // 先将 comparison operator 转换为 token type 再转 dot node decl
-    return tokenType2NodeDecl(comparOper2TokenType(op));
-}
-
-/**
- * @brief  通过 arithmetic operator 构造 DOT 结点声明
- * @param  op arithmetic operator
- * @return DotNodeDecl
- */
-static inline auto arithOper2NodeDecl(ast::ArithOperator op) -> DotNodeDecl
-{  // 先将 arithmetic operator 转换为 token type 再转 dot node decl
-    return tokenType2NodeDecl(arithOper2TokenType(op));
-}
-
-/**
- * @brief  将一系列 DOT 结点声明转换为字符串
- * @param  nd 变长参数
- * @return std::string
- */
-template <typename... T>  // 变长参数模板
-static auto nodeDecls2Str(const T&... nd) -> std::string
-{
-    static_assert((std::is_same_v<T, DotNodeDecl> && ...),
-                  "All arguments must be DotNodeDecl");  // 编译期检查，未通过则编译出错
-
-    std::ostringstream oss;
-    ((oss << std::string(4, ' ') << nd.toString() << std::endl), ...);  // 左折叠展开
-
-    return oss.str();
-}
-
-/**
- * @brief  将一条 DOT 边转换为相应 DOT 声明字符串
- * @param  a 起始节点
- * @param  b 终止结点
- * @return std::string DOT 边声明字符串
- */
-static inline auto edge2Str(const DotNodeDecl& a, const DotNodeDecl& b) -> std::string
-{
-    std::ostringstream oss;
-    oss << std::string(4, ' ') << a.name << " -> " << b.name << std::endl;
-    return oss.str();
-}
-
-/**
- * @brief  将边列表转换为 DOT 格式字符串
- * @param  edges 边的起点和终点节点对列表
- * @return 表示所有边的字符串，每行一条 DOT 边语句
- */
-static auto edges2Str(std::initializer_list<std::pair<DotNodeDecl, DotNodeDecl>> edges)
-    -> std::string
-{
-    std::ostringstream oss;
-
-    for (const auto& edge : edges)
-    {
-        oss << std::string(4, ' ') << edge.first.name << " -> " << edge.second.name << std::endl;
-    }
-
-    return oss.str();
-}
-
-/**
- * @brief  将变量声明体 VarDeclBody 转换为 DOT 图表示
+ * @brief  输出变量声明体 VarDeclBody
+ * @param  w   DOT 输出器
  * @param  vdb 变量声明体指针
- * @return [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return 根结点编号
  */
-static auto varDeclBody2Dot(const VarDeclBodyPtr& vdb)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto varDeclBody2Dot(DotWriter& w, const VarDeclBodyPtr& vdb) -> NodeId
 {
-    DotNodeDecl n_vdb = str2NodeDecl("VarDeclBody");
-    DotNodeDecl n_id = str2NodeDecl("ID");
-    DotNodeDecl n_id_name = str2NodeDecl(vdb->name);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    NodeId n_vdb = w.node("VarDeclBody");
     if (vdb->mut)
     {
-        DotNodeDecl n_mut = str2NodeDecl("mut");
-        oss_nd << nodeDecls2Str(n_vdb, n_mut, n_id, n_id_name);
-        oss_ed << edge2Str(n_vdb, n_mut);
+        w.child(n_vdb, "mut");
     }
-    else
-    {
-        oss_nd << nodeDecls2Str(n_vdb, n_id, n_id_name);
-    }
-
-    oss_ed << edges2Str({{n_vdb, n_id}, {n_id, n_id_name}});
+    NodeId n_id = w.child(n_vdb, "ID");
+    w.child(n_id, vdb->name);
 
-    return std::make_tuple(n_vdb, oss_nd.str(), oss_ed.str());
+    return n_vdb;
 }
 
 /**
- * @brief   ast::Integer 转 dot 格式
+ * @brief   输出 ast::Integer
+ * @param   w       DOT 输出器
  * @param   integer AST Integer 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto integer2Dot(const IntegerPtr& integer)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto integer2Dot(DotWriter& w, const IntegerPtr& integer) -> NodeId
 {
-    DotNodeDecl n_int = str2NodeDecl("Integer");
-    DotNodeDecl n_i32 = str2NodeDecl("i32");
+    NodeId n_int = w.node("Integer");
 
-    DotNodeDecl n_ref{};
-    DotNodeDecl n_mut{};
     switch (integer->ref_type)
     {
         default:
@@ -238,229 +252,162 @@ static auto integer2Dot(const IntegerPtr& integer)
         case RefType::Normal:
             break;
         case RefType::Immutable:
-            n_ref = tokenType2NodeDecl(lexer::token::Type::REF);
+            w.child(n_int, tokenTypeLabel(lexer::token::Type::REF));
             break;
         case RefType::Mutable:
-            n_ref = tokenType2NodeDecl(lexer::token::Type::REF);
-            n_mut = str2NodeDecl("mut");
+            w.child(n_int, tokenTypeLabel(lexer::token::Type::REF));
+            w.child(n_int, "mut");
             break;
     }
+    w.child(n_int, "i32");
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-
-    oss_nd << nodeDecls2Str(n_int);
-    if (n_ref.initialized())
-    {
-        oss_nd << nodeDecls2Str(n_ref);
-        if (n_mut.initialized())
-        {
-            oss_nd << nodeDecls2Str(n_mut, n_i32);
-            oss_ed << edge2Str(n_int, n_mut);
-        }
-        oss_ed << edge2Str(n_int, n_ref);
-    }
-    oss_nd << nodeDecls2Str(n_i32);
-    oss_ed << edge2Str(n_int, n_i32);
-
-    return std::make_tuple(n_int, oss_nd.str(), oss_ed.str());
+    return n_int;
 }
 
 /**
- * @brief   ast::VarType 转 dot 格式
+ * @brief   输出 ast::VarType
+ * @param   w  DOT 输出器
  * @param   vt AST Variable Type 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto varType2Dot(const VarTypePtr& vt) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto varType2Dot(DotWriter& w, const VarTypePtr& vt) -> NodeId
 {
-    auto n_vt = str2NodeDecl("VarType");
+    NodeId n_vt = w.node("VarType");
 
-    DotNodeDecl rt{};
-    std::string nd{};
-    std::string ed{};
     switch (vt->type())
     {
         default:
             throw std::runtime_error{"varType2Dot(): Incorrect NodeType"};
             break;
         case NodeType::Integer:
-            std::tie(rt, nd, ed) = integer2Dot(std::dynamic_pointer_cast<Integer>(vt));
+            w.edge(n_vt, integer2Dot(w, std::dynamic_pointer_cast<Integer>(vt)));
             break;
         case NodeType::Array:
-            // std::tie(rt, nd, ed) = array2Dot(std::dynamic_pointer_cast<Array>(vt));
-            break;
         case NodeType::Tuple:
-            // std::tie(rt, nd, ed) = tuple2Dot(std::dynamic_pointer_cast<Tuple>(vt));
             break;
     }
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_vt) << nd;
-    oss_ed << edge2Str(n_vt, rt) << ed;
-
-    return std::make_tuple(n_vt, oss_nd.str(), oss_ed.str());
+    return n_vt;
 }
 
 /**
- * @brief   将参数 Arg 转 dot 格式
+ * @brief   输出参数 Arg
+ * @param   w   DOT 输出器
  * @param   arg AST Arg 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto arg2Dot(const ArgPtr& arg) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto arg2Dot(DotWriter& w, const ArgPtr& arg) -> NodeId
 {
-    DotNodeDecl n_arg = str2NodeDecl("Arg");
-
-    auto [n_vdb, nd_vdb, ed_vdb] = varDeclBody2Dot(arg->variable);
-    auto [n_vt, nd_vt, ed_vt] = varType2Dot(arg->var_type);
+    NodeId n_arg = w.node("Arg");
+    w.edge(n_arg, varDeclBody2Dot(w, arg->variable));
+    w.edge(n_arg, varType2Dot(w, arg->var_type));
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_arg, n_vdb, n_vt) << nd_vdb << nd_vt;
-    oss_ed << edge2Str(n_arg, n_vdb) << edge2Str(n_arg, n_vt) << ed_vdb << ed_vt;
-
-    return std::make_tuple(n_arg, oss_nd.str(), oss_ed.str());
+    return n_arg;
 }
 
 /**
- * @brief   将赋值元素 AssignElement 转 dot 格式
+ * @brief   输出赋值元素 AssignElement
+ * @param   w  DOT 输出器
  * @param   ae AST AssignElement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto assignElement2Dot(const AssignElementPtr& ae)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto assignElement2Dot(DotWriter& w, const AssignElementPtr& ae) -> NodeId
 {
-    DotNodeDecl n_assign_elem = str2NodeDecl("AssignElement");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_assign_elem);
+    NodeId n_assign_elem = w.node("AssignElement");
 
     switch (ae->kind)
     {
         case AssignElement::Kind::Variable:
         {
             auto var = std::dynamic_pointer_cast<ast::Variable>(ae);
-            DotNodeDecl n_var = str2NodeDecl(var->name);
-            oss_nd << nodeDecls2Str(n_var);
-            oss_ed << edge2Str(n_assign_elem, n_var);
+            w.child(n_assign_elem, var->name);
             break;
         }
         default:
             break;
     }
 
-    return std::make_tuple(n_assign_elem, oss_nd.str(), oss_ed.str());
+    return n_assign_elem;
 }
 
 /**
- * @brief   将函数头声明 FuncHeaderDecl 转 dot 格式
+ * @brief   输出函数头声明 FuncHeaderDecl
+ * @param   w   DOT 输出器
  * @param   fhd AST FuncHeaderDecl 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto funcHeaderDecl2Dot(const FuncHeaderDeclPtr& fhd)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto funcHeaderDecl2Dot(DotWriter& w, const FuncHeaderDeclPtr& fhd) -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_fhd = str2NodeDecl("FuncHeaderDecl");
-    DotNodeDecl n_fn = str2NodeDecl("fn");
-    DotNodeDecl n_id = str2NodeDecl("ID");
-    DotNodeDecl n_id_name = str2NodeDecl(fhd->name);
-
-    DotNodeDecl n_lparen = tokenType2NodeDecl(TokenType::LPAREN);
-    DotNodeDecl n_rparen = tokenType2NodeDecl(TokenType::RPAREN);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_fhd, n_fn, n_id, n_id_name, n_lparen);
-    oss_ed << edges2Str({{n_fhd, n_fn}, {n_fhd, n_id}, {n_id, n_id_name}, {n_fhd, n_lparen}});
+    NodeId n_fhd = w.node("FuncHeaderDecl");
+    w.child(n_fhd, "fn");
+    NodeId n_id = w.child(n_fhd, "ID");
+    w.child(n_id, fhd->name);
+    w.child(n_fhd, tokenTypeLabel(TokenType::LPAREN));
 
     for (auto it = fhd->argv.begin(); it != fhd->argv.end(); ++it)
     {
-        auto [rt, nd, ed] = arg2Dot(*it);
-        oss_nd << nd;
-        oss_ed << ed << edge2Str(n_fhd, rt);
+        w.edge(n_fhd, arg2Dot(w, *it));
         if (std::next(it) != fhd->argv.end())
         {
-            DotNodeDecl n_comma = tokenType2NodeDecl(TokenType::COMMA);
-            oss_nd << nodeDecls2Str(n_comma);
-            oss_ed << edge2Str(n_fhd, n_comma);
+            w.child(n_fhd, tokenTypeLabel(TokenType::COMMA));
         }
     }
 
-    oss_nd << nodeDecls2Str(n_rparen);
-    oss_ed << edge2Str(n_fhd, n_rparen);
+    w.child(n_fhd, tokenTypeLabel(TokenType::RPAREN));
 
     if (fhd->retval_type.has_value())
     {
-        DotNodeDecl n_arrow = tokenType2NodeDecl(TokenType::ARROW);
-
-        oss_nd << nodeDecls2Str(n_arrow);
-        oss_ed << edge2Str(n_fhd, n_arrow);
-
-        auto [n_vt, nd_vt, ed_vt] = varType2Dot(fhd->retval_type.value());
-
-        oss_nd << nd_vt;
-        oss_ed << edge2Str(n_fhd, n_vt) << ed_vt;
+        w.child(n_fhd, tokenTypeLabel(TokenType::ARROW));
+        w.edge(n_fhd, varType2Dot(w, fhd->retval_type.value()));
     }
 
-    return std::make_tuple(n_fhd, oss_nd.str(), oss_ed.str());
+    return n_fhd;
 }
 
 /**
- * @brief   将数字表达式 Number 转 dot 格式
+ * @brief   输出数字表达式 Number
+ * @param   w DOT 输出器
  * @param   n AST Number 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto numberExpr2Dot(const std::shared_ptr<ast::Number>& n)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto numberExpr2Dot(DotWriter& w, const std::shared_ptr<ast::Number>& n) -> NodeId
 {
-    DotNodeDecl n_num = str2NodeDecl("Number");
-    DotNodeDecl n_val = str2NodeDecl(std::to_string(n->value));
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    char tmp[16];
+    auto [end, ec] = std::to_chars(tmp, tmp + sizeof(tmp), n->value);
 
-    oss_nd << nodeDecls2Str(n_num, n_val);
-    oss_ed << edge2Str(n_num, n_val);
+    NodeId n_num = w.node("Number");
+    w.child(n_num, std::string_view{tmp, static_cast<std::size_t>(end - tmp)});
 
-    return std::make_tuple(n_num, oss_nd.str(), oss_ed.str());
+    return n_num;
 }
 
 /**
- * @brief   将变量表达式 Variable 转 dot 格式
+ * @brief   输出变量表达式 Variable
+ * @param   w DOT 输出器
  * @param   v AST Variable 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto variableExpr2Dot(const std::shared_ptr<ast::Variable>& v)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto variableExpr2Dot(DotWriter& w, const std::shared_ptr<ast::Variable>& v) -> NodeId
 {
-    DotNodeDecl v_id = str2NodeDecl("ID");
-    DotNodeDecl v_name = str2NodeDecl(v->name);
+    NodeId v_id = w.node("ID");
+    w.child(v_id, v->name);
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(v_id, v_name);
-    oss_ed << edge2Str(v_id, v_name);
-
-    return std::make_tuple(v_id, oss_nd.str(), oss_ed.str());
+    return v_id;
 }
 
-static auto expr2Dot(const ExprPtr& expr) -> std::tuple<DotNodeDecl, std::string, std::string>;
+static auto expr2Dot(DotWriter& w, const ExprPtr& expr) -> NodeId;
 
 /**
- * @brief   将因子表达式 Factor 转 dot 格式
+ * @brief   输出因子表达式 Factor
+ * @param   w DOT 输出器
  * @param   f AST Factor 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto factorExpr2Dot(const FactorPtr& f) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto factorExpr2Dot(DotWriter& w, const FactorPtr& f) -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_factor = str2NodeDecl("Factor");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_factor);
+    NodeId n_factor = w.node("Factor");
 
     // DEBUG 打印错误 - 涉及扩展规则，暂不解决
     if (f->ref_type != RefType::Normal)
@@ -478,50 +425,39 @@ static auto factorExpr2Dot(const FactorPtr& f) -> std::tuple<DotNodeDecl, std::s
                 ref_str = "?";
                 break;
         }
-
-        DotNodeDecl n_ref = str2NodeDecl(ref_str);
-        oss_nd << nodeDecls2Str(n_ref);
-        oss_ed << edge2Str(n_factor, n_ref);
+        w.child(n_factor, ref_str);
     }
 
-    auto [n_inner, inner_nd, inner_ed] = expr2Dot(f->element);
-    oss_nd << inner_nd;
-    oss_ed << inner_ed << edge2Str(n_factor, n_inner);
+    w.edge(n_factor, expr2Dot(w, f->element));
 
-    return std::make_tuple(n_factor, oss_nd.str(), oss_ed.str());
+    return n_factor;
 }
 
 /**
- * @brief   将比较表达式 ComparExpr 转 dot 格式
+ * @brief   输出比较表达式 ComparExpr
+ * @param   w  DOT 输出器
  * @param   ce AST ComparExpr 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto comparExpr2Dot(const ComparExprPtr& ce)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto comparExpr2Dot(DotWriter& w, const ComparExprPtr& ce) -> NodeId
 {
-    DotNodeDecl n_expr = str2NodeDecl("CmpExpr");
-
-    auto [n_lhs, lhs_nd, lhs_ed] = expr2Dot(ce->lhs);
-    DotNodeDecl n_op = comparOper2NodeDecl(ce->op);
-    auto [n_rhs, rhs_nd, rhs_ed] = expr2Dot(ce->rhs);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << lhs_nd << nodeDecls2Str(n_expr, n_op) << rhs_nd;
-    oss_ed << lhs_ed << edges2Str({{n_expr, n_lhs}, {n_expr, n_op}, {n_expr, n_rhs}}) << rhs_ed;
+    NodeId n_expr = w.node("CmpExpr");
+    w.edge(n_expr, expr2Dot(w, ce->lhs));
+    w.child(n_expr, tokenTypeLabel(comparOper2TokenType(ce->op)));
+    w.edge(n_expr, expr2Dot(w, ce->rhs));
 
-    return std::make_tuple(n_expr, oss_nd.str(), oss_ed.str());
+    return n_expr;
 }
 
 /**
- * @brief   将算术表达式 ArithExpr 转 dot 格式
+ * @brief   输出算术表达式 ArithExpr
+ * @param   w  DOT 输出器
  * @param   ae AST ArithExpr 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto arithExpr2Dot(const ArithExprPtr& ae)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto arithExpr2Dot(DotWriter& w, const ArithExprPtr& ae) -> NodeId
 {
-    std::string expr_type;
+    std::string_view expr_type;
 
     switch (ae->op)
     {
@@ -535,147 +471,111 @@ static auto arithExpr2Dot(const ArithExprPtr& ae)
             break;
     }
 
-    DotNodeDecl n_expr = str2NodeDecl(expr_type);
-    auto [n_lhs, lhs_nd, lhs_ed] = expr2Dot(ae->lhs);
-    DotNodeDecl n_op = arithOper2NodeDecl(ae->op);
-    auto [n_rhs, rhs_nd, rhs_ed] = expr2Dot(ae->rhs);
+    NodeId n_expr = w.node(expr_type);
+    w.edge(n_expr, expr2Dot(w, ae->lhs));
+    w.child(n_expr, tokenTypeLabel(arithOper2TokenType(ae->op)));
+    w.edge(n_expr, expr2Dot(w, ae->rhs));
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << lhs_nd << nodeDecls2Str(n_expr, n_op) << rhs_nd;
-    oss_ed << lhs_ed << edges2Str({{n_expr, n_lhs}, {n_expr, n_op}, {n_expr, n_rhs}}) << rhs_ed;
-
-    return std::make_tuple(n_expr, oss_nd.str(), oss_ed.str());
+    return n_expr;
 }
 
 /**
- * @brief   将函数调用表达式 CallExpr 转 dot 格式
+ * @brief   输出函数调用表达式 CallExpr
+ * @param   w  DOT 输出器
  * @param   ce AST CallExpr 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto callExpr2Dot(const std::shared_ptr<ast::CallExpr>& ce)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto callExpr2Dot(DotWriter& w, const std::shared_ptr<ast::CallExpr>& ce) -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_call = str2NodeDecl("CallExpr");
-    DotNodeDecl n_id = str2NodeDecl("ID");
-    DotNodeDecl n_fn = str2NodeDecl(ce->callee);
-
-    DotNodeDecl n_lparen = tokenType2NodeDecl(TokenType::LPAREN);
-    DotNodeDecl n_rparen = tokenType2NodeDecl(TokenType::RPAREN);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_call, n_id, n_fn, n_lparen);
-    oss_ed << edges2Str({{n_call, n_id}, {n_id, n_fn}, {n_call, n_lparen}});
+    NodeId n_call = w.node("CallExpr");
+    NodeId n_id = w.child(n_call, "ID");
+    w.child(n_id, ce->callee);
+    w.child(n_call, tokenTypeLabel(TokenType::LPAREN));
 
     if (!ce->argv.empty())
     {
-        DotNodeDecl n_arglist = str2NodeDecl("ArgList");
-        oss_nd << nodeDecls2Str(n_arglist, n_rparen);
-        oss_ed << edges2Str({{n_call, n_arglist}, {n_call, n_rparen}});
-
+        NodeId n_arglist = w.child(n_call, "ArgList");
         for (const auto& arg : ce->argv)
         {
-            auto [n_arg, arg_nd, arg_ed] = expr2Dot(arg);
-            oss_nd << arg_nd;
-            oss_ed << arg_ed << edge2Str(n_arglist, n_arg);
+            w.edge(n_arglist, expr2Dot(w, arg));
         }
     }
-    else
-    {
-        oss_nd << nodeDecls2Str(n_rparen);
-        oss_ed << edge2Str(n_call, n_rparen);
-    }
 
-    return std::make_tuple(n_call, oss_nd.str(), oss_ed.str());
+    w.child(n_call, tokenTypeLabel(TokenType::RPAREN));
+
+    return n_call;
 }
 
 /**
- * @brief   将括号表达式 ParenthesisExpr 转 dot 格式
+ * @brief   输出括号表达式 ParenthesisExpr
+ * @param   w  DOT 输出器
  * @param   pe AST ParenthesisExpr 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto parenthesisExpr2Dot(const std::shared_ptr<ast::ParenthesisExpr>& pe)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto parenthesisExpr2Dot(DotWriter& w, const std::shared_ptr<ast::ParenthesisExpr>& pe)
+    -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_paren = str2NodeDecl("ParenthesisExpr");
-
-    DotNodeDecl n_lparen = tokenType2NodeDecl(TokenType::LPAREN);
-    DotNodeDecl n_rparen = tokenType2NodeDecl(TokenType::RPAREN);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    NodeId n_paren = w.node("ParenthesisExpr");
+    w.child(n_paren, tokenTypeLabel(TokenType::LPAREN));
+    w.edge(n_paren, expr2Dot(w, pe->expr));
+    w.child(n_paren, tokenTypeLabel(TokenType::RPAREN));
 
-    auto [n_inner, inner_nd, inner_ed] = expr2Dot(pe->expr);
-    oss_nd << nodeDecls2Str(n_lparen, n_paren) << inner_nd << nodeDecls2Str(n_paren, n_rparen);
-    oss_ed << edges2Str({{n_paren, n_lparen}, {n_paren, n_inner}, {n_paren, n_rparen}}) << inner_ed;
-
-    return std::make_tuple(n_paren, oss_nd.str(), oss_ed.str());
+    return n_paren;
 }
 
 /**
- * @brief   将表达式 Element 转 dot 格式，根据type来进行分发
+ * @brief   输出表达式 Element，根据 type 来进行分发
+ * @param   w DOT 输出器
  * @param   e AST Expression 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto element2Dot(const ExprPtr& e) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto element2Dot(DotWriter& w, const ExprPtr& e) -> NodeId
 {
     using enum ast::NodeType;
 
-    DotNodeDecl n_element = str2NodeDecl("Element");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_element);
-
-    DotNodeDecl n_inner;
-    std::string inner_nd;
-    std::string inner_ed;
+    NodeId n_element = w.node("Element");
 
+    NodeId n_inner{};
     switch (e->type())
     {
         case Number:
-            std::tie(n_inner, inner_nd, inner_ed) =
-                numberExpr2Dot(std::dynamic_pointer_cast<ast::Number>(e));
+            n_inner = numberExpr2Dot(w, std::dynamic_pointer_cast<ast::Number>(e));
             break;
         case Variable:
-            std::tie(n_inner, inner_nd, inner_ed) =
-                variableExpr2Dot(std::dynamic_pointer_cast<ast::Variable>(e));
+            n_inner = variableExpr2Dot(w, std::dynamic_pointer_cast<ast::Variable>(e));
             break;
         case CallExpr:
-            std::tie(n_inner, inner_nd, inner_ed) =
-                callExpr2Dot(std::dynamic_pointer_cast<ast::CallExpr>(e));
+            n_inner = callExpr2Dot(w, std::dynamic_pointer_cast<ast::CallExpr>(e));
             break;
         case ParenthesisExpr:
-            std::tie(n_inner, inner_nd, inner_ed) =
-                parenthesisExpr2Dot(std::dynamic_pointer_cast<ast::ParenthesisExpr>(e));
+            n_inner = parenthesisExpr2Dot(w, std::dynamic_pointer_cast<ast::ParenthesisExpr>(e));
             break;
         default:
-            n_inner = str2NodeDecl("UnknownElement");
-            inner_nd = nodeDecls2Str(n_inner);
+            n_inner = w.node("UnknownElement");
             break;
     }
+    w.edge(n_element, n_inner);
 
-    oss_nd << inner_nd;
-    oss_ed << inner_ed << edge2Str(n_element, n_inner);
-
-    return std::make_tuple(n_element, oss_nd.str(), oss_ed.str());
+    return n_element;
 }
 
 /**
- * @brief   将表达式 Expr 转 dot 格式，根据type来进行分发
+ * @brief   输出表达式 Expr，根据 type 来进行分发
+ * @param   w    DOT 输出器
  * @param   expr AST Expression 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto expr2Dot(const ExprPtr& expr) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto expr2Dot(DotWriter& w, const ExprPtr& expr) -> NodeId
 {
     using enum ast::NodeType;
 
-    DotNodeDecl rt{};
-    std::string nd{};
-    std::string ed{};
+    if (w.atDepthLimit())
+    {  // 不再展开，直接跳过整棵子树
+        return w.summary("Expr");
+    }
+    DotWriter::Level level{w};
 
     switch (expr->type())
     {
@@ -683,409 +583,315 @@ static auto expr2Dot(const ExprPtr& expr) -> std::tuple<DotNodeDecl, std::string
         case Variable:
         case CallExpr:
         case ParenthesisExpr:
-            std::tie(rt, nd, ed) = element2Dot(expr);
-            break;
+            return element2Dot(w, expr);
         case Factor:
-            std::tie(rt, nd, ed) = factorExpr2Dot(std::dynamic_pointer_cast<ast::Factor>(expr));
-            break;
+            return factorExpr2Dot(w, std::dynamic_pointer_cast<ast::Factor>(expr));
         case ComparExpr:
-            std::tie(rt, nd, ed) = comparExpr2Dot(std::dynamic_pointer_cast<ast::ComparExpr>(expr));
-            break;
+            return comparExpr2Dot(w, std::dynamic_pointer_cast<ast::ComparExpr>(expr));
         case ArithExpr:
-            std::tie(rt, nd, ed) = arithExpr2Dot(std::dynamic_pointer_cast<ast::ArithExpr>(expr));
-            break;
+            return arithExpr2Dot(w, std::dynamic_pointer_cast<ast::ArithExpr>(expr));
         default:
-            rt = str2NodeDecl("UnknownExpr");
-            nd = nodeDecls2Str(rt);
-            ed = "";
-            break;
+            return w.node("UnknownExpr");
     }
-
-    return std::make_tuple(rt, nd, ed);
 }
 
 /**
- * @brief   将表达式语句 ExprStmt 转 dot 格式
+ * @brief   输出表达式语句 ExprStmt
+ * @param   w  DOT 输出器
  * @param   es AST Expression Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto exprStmt2Dot(const std::shared_ptr<ast::ExprStmt>& es)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto exprStmt2Dot(DotWriter& w, const std::shared_ptr<ast::ExprStmt>& es) -> NodeId
 {
-    DotNodeDecl n_es = str2NodeDecl("ExprStmt");
-    auto [n_expr, expr_nd, expr_ed] = expr2Dot(es->expr);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_es) << expr_nd;
-    oss_ed << edge2Str(n_es, n_expr) << expr_ed;
+    NodeId n_es = w.node("ExprStmt");
+    w.edge(n_es, expr2Dot(w, es->expr));
 
-    return std::make_tuple(n_es, oss_nd.str(), oss_ed.str());
+    return n_es;
 }
 
 /**
- * @brief   将返回语句 ReturnStmt 转 dot 格式
+ * @brief   输出返回语句 ReturnStmt
+ * @param   w  DOT 输出器
  * @param   rs AST Return Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto returnStmt2Dot(const std::shared_ptr<ast::RetStmt>& rs)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto returnStmt2Dot(DotWriter& w, const std::shared_ptr<ast::RetStmt>& rs) -> NodeId
 {
-    DotNodeDecl n_rs = str2NodeDecl("RetStmt");
-    DotNodeDecl n_ret = str2NodeDecl("return");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_rs, n_ret);
-    oss_ed << edge2Str(n_rs, n_ret);
+    NodeId n_rs = w.node("RetStmt");
+    w.child(n_rs, "return");
 
     if (rs->ret_val)
     {
-        auto [n_expr, expr_nd, expr_ed] = expr2Dot(rs->ret_val.value());
-        oss_nd << expr_nd;
-        oss_ed << expr_ed << edge2Str(n_rs, n_expr);
+        w.edge(n_rs, expr2Dot(w, rs->ret_val.value()));
     }
 
-    return std::make_tuple(n_rs, oss_nd.str(), oss_ed.str());
+    return n_rs;
 }
 
 /**
- * @brief   将变量声明语句 VarDeclStmt 转 dot 格式
- * @param   vds AST Variable Declaration Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @brief   输出变量声明语句 VarDeclStmt 的公共部分
+ * @param   w     DOT 输出器
+ * @param   n_vds 语句根结点
+ * @param   vds   AST Variable Declaration Statement 结点指针
  */
-static auto varDeclStmt2Dot(const VarDeclStmtPtr& vds)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static void varDeclCommon2Dot(DotWriter& w, NodeId n_vds, const VarDeclStmtPtr& vds)
 {
     using TokenType = lexer::token::Type;
 
-    DotNodeDecl n_vds = str2NodeDecl("VarDeclStmt");
-    DotNodeDecl n_let = str2NodeDecl("let");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-
-    oss_nd << nodeDecls2Str(n_vds, n_let);
-    oss_ed << edge2Str(n_vds, n_let);
-    auto [n_var, var_nd, var_ed] = varDeclBody2Dot(vds->variable);
-    oss_nd << var_nd;
-    oss_ed << var_ed << edge2Str(n_vds, n_var);
+    w.child(n_vds, "let");
+    w.edge(n_vds, varDeclBody2Dot(w, vds->variable));
 
     if (vds->var_type.has_value())
     {
-        DotNodeDecl n_colon = tokenType2NodeDecl(TokenType::COLON);
-        oss_nd << nodeDecls2Str(n_colon);
-        oss_ed << edge2Str(n_vds, n_colon);
-
-        auto [n_type, type_nd, type_ed] = varType2Dot(vds->var_type.value());
-        oss_nd << type_nd;
-        oss_ed << type_ed << edge2Str(n_vds, n_type);
+        w.child(n_vds, tokenTypeLabel(TokenType::COLON));
+        w.edge(n_vds, varType2Dot(w, vds->var_type.value()));
     }
+}
+
+/**
+ * @brief   输出变量声明语句 VarDeclStmt
+ * @param   w   DOT 输出器
+ * @param   vds AST Variable Declaration Statement 结点指针
+ * @return  根结点编号
+ */
+static auto varDeclStmt2Dot(DotWriter& w, const VarDeclStmtPtr& vds) -> NodeId
+{
+    NodeId n_vds = w.node("VarDeclStmt");
+    varDeclCommon2Dot(w, n_vds, vds);
 
-    return std::make_tuple(n_vds, oss_nd.str(), oss_ed.str());
+    return n_vds;
 }
 
 /**
- * @brief   将赋值语句 AssignStmt 转 dot 格式
+ * @brief   输出赋值语句 AssignStmt
+ * @param   w  DOT 输出器
  * @param   as AST Assign Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto assignStmt2Dot(const AssignStmtPtr& as)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto assignStmt2Dot(DotWriter& w, const AssignStmtPtr& as) -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_as = str2NodeDecl("AssignStmt");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_as);
-
-    auto [n_lv, lv_nd, lv_ed] = assignElement2Dot(as->lvalue);
-    oss_nd << lv_nd;
-    oss_ed << lv_ed << edge2Str(n_as, n_lv);
-
-    DotNodeDecl n_assign = tokenType2NodeDecl(TokenType::ASSIGN);
-    oss_nd << nodeDecls2Str(n_assign);
-    oss_ed << edge2Str(n_as, n_assign);
+    NodeId n_as = w.node("AssignStmt");
+    w.edge(n_as, assignElement2Dot(w, as->lvalue));
+    w.child(n_as, tokenTypeLabel(TokenType::ASSIGN));
+    w.edge(n_as, expr2Dot(w, as->expr));
 
-    auto [n_expr, expr_nd, expr_ed] = expr2Dot(as->expr);
-    oss_nd << expr_nd;
-    oss_ed << expr_ed << edge2Str(n_as, n_expr);
-
-    return std::make_tuple(n_as, oss_nd.str(), oss_ed.str());
+    return n_as;
 }
 
 /**
- * @brief   将变量声明并赋值语句 VarDeclAssignStmt 转 dot 格式
+ * @brief   输出变量声明并赋值语句 VarDeclAssignStmt
+ * @param   w    DOT 输出器
  * @param   vdas AST VarDeclAssign Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto varDeclAssignStmt2Dot(const VarDeclAssignStmtPtr& vdas)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto varDeclAssignStmt2Dot(DotWriter& w, const VarDeclAssignStmtPtr& vdas) -> NodeId
 {
     using TokenType = lexer::token::Type;
-    DotNodeDecl n_vdas = str2NodeDecl("VarDeclAssignStmt");
-    DotNodeDecl n_let = str2NodeDecl("let");
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_vdas, n_let);
-    oss_ed << edge2Str(n_vdas, n_let);
-
-    auto [n_var, var_nd, var_ed] = varDeclBody2Dot(vdas->variable);
-    oss_nd << var_nd;
-    oss_ed << var_ed << edge2Str(n_vdas, n_var);
+    NodeId n_vdas = w.node("VarDeclAssignStmt");
+    varDeclCommon2Dot(w, n_vdas, vdas);
+    w.child(n_vdas, tokenTypeLabel(TokenType::ASSIGN));
+    w.edge(n_vdas, expr2Dot(w, vdas->expr));
 
-    if (vdas->var_type.has_value())
-    {
-        DotNodeDecl n_colon = tokenType2NodeDecl(TokenType::COLON);
-        oss_nd << nodeDecls2Str(n_colon);
-        oss_ed << edge2Str(n_vdas, n_colon);
-        auto [n_type, type_nd, type_ed] = varType2Dot(vdas->var_type.value());
-        oss_nd << type_nd;
-        oss_ed << type_ed << edge2Str(n_vdas, n_type);
-    }
-
-    DotNodeDecl n_assign = tokenType2NodeDecl(TokenType::ASSIGN);
-    oss_nd << nodeDecls2Str(n_assign);
-    oss_ed << edge2Str(n_vdas, n_assign);
-
-    auto [n_expr, expr_nd, expr_ed] = expr2Dot(vdas->expr);
-    oss_nd << expr_nd;
-    oss_ed << expr_ed << edge2Str(n_vdas, n_expr);
-
-    return std::make_tuple(n_vdas, oss_nd.str(), oss_ed.str());
+    return n_vdas;
 }
 
-static auto stmt2Dot(const StmtPtr& stmt) -> std::tuple<DotNodeDecl, std::string, std::string>;
+static auto stmt2Dot(DotWriter& w, const StmtPtr& stmt) -> NodeId;
 
 /**
- * @brief   将代码块语句 BlockStmt 转 dot 格式
+ * @brief   输出代码块语句 BlockStmt
+ * @param   w  DOT 输出器
  * @param   bs AST Block Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto blockStmt2Dot(const BlockStmtPtr& bs)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto blockStmt2Dot(DotWriter& w, const BlockStmtPtr& bs) -> NodeId
 {
     using TokenType = lexer::token::Type;
 
-    DotNodeDecl n_bs = str2NodeDecl("BlockStmt");
-    DotNodeDecl n_lbrace = tokenType2NodeDecl(TokenType::LBRACE);
-    DotNodeDecl n_rbrace = tokenType2NodeDecl(TokenType::RBRACE);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    if (w.atDepthLimit())
+    {  // 不再展开，直接跳过整个代码块
+        return w.summary("BlockStmt");
+    }
+    DotWriter::Level level{w};
 
-    oss_nd << nodeDecls2Str(n_bs);
-    oss_nd << nodeDecls2Str(n_lbrace);
-    oss_ed << edge2Str(n_bs, n_lbrace);
+    NodeId n_bs = w.node("BlockStmt");
+    w.child(n_bs, tokenTypeLabel(TokenType::LBRACE));
 
     for (const auto& stmt : bs->stmts)
     {
-        auto [n_stmt, stmt_nd, stmt_ed] = stmt2Dot(stmt);
-        oss_nd << stmt_nd;
-        oss_ed << stmt_ed << edge2Str(n_bs, n_stmt);
+        w.edge(n_bs, stmt2Dot(w, stmt));
     }
 
-    oss_nd << nodeDecls2Str(n_rbrace);
-    oss_ed << edge2Str(n_bs, n_rbrace);
+    w.child(n_bs, tokenTypeLabel(TokenType::RBRACE));
 
-    return std::make_tuple(n_bs, oss_nd.str(), oss_ed.str());
+    return n_bs;
 }
 
 /**
- * @brief   将 if 语句 IfStmt 转 dot 格式
+ * @brief   输出 if 语句 IfStmt
+ * @param   w     DOT 输出器
  * @param   istmt AST If Statement 结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto ifStmt2Dot(const IfStmtPtr& istmt) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto ifStmt2Dot(DotWriter& w, const IfStmtPtr& istmt) -> NodeId
 {
     using TokenType = lexer::token::Type;
 
-    DotNodeDecl n_if_stmt = str2NodeDecl("IfStmt");
-    DotNodeDecl n_if_token = tokenType2NodeDecl(TokenType::IF);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_if_stmt, n_if_token);
-    oss_ed << edge2Str(n_if_stmt, n_if_token);
-
-    auto [n_cond, cond_nd, cond_ed] = expr2Dot(istmt->expr);
-    oss_nd << cond_nd;
-    oss_ed << cond_ed << edge2Str(n_if_stmt, n_cond);
-
-    auto [n_if_blk, blk_nd, blk_ed] = blockStmt2Dot(istmt->if_branch);
-    oss_nd << blk_nd;
-    oss_ed << blk_ed << edge2Str(n_if_stmt, n_if_blk);
+    NodeId n_if_stmt = w.node("IfStmt");
+    w.child(n_if_stmt, tokenTypeLabel(TokenType::IF));
+    w.edge(n_if_stmt, expr2Dot(w, istmt->expr));
+    w.edge(n_if_stmt, blockStmt2Dot(w, istmt->if_branch));
 
     for (const auto& clause : istmt->else_clauses)
     {
         if (clause->expr.has_value())
         {
-            DotNodeDecl n_else_if = str2NodeDecl("else_if");
-            oss_nd << nodeDecls2Str(n_else_if);
-            oss_ed << edge2Str(n_if_stmt, n_else_if);
-
-            auto [n_expr, e_nd, e_ed] = expr2Dot(clause->expr.value());
-            oss_nd << e_nd;
-            oss_ed << e_ed << edge2Str(n_if_stmt, n_expr);
-
-            auto [n_blk, blk_nd, blk_ed] = blockStmt2Dot(clause->block);
-            oss_nd << blk_nd;
-            oss_ed << blk_ed << edge2Str(n_if_stmt, n_blk);
+            w.child(n_if_stmt, "else_if");
+            w.edge(n_if_stmt, expr2Dot(w, clause->expr.value()));
         }
         else
-        {
-            // 纯 else
-            DotNodeDecl n_else = tokenType2NodeDecl(TokenType::ELSE);
-            oss_nd << nodeDecls2Str(n_else);
-            oss_ed << edge2Str(n_if_stmt, n_else);
-
-            auto [n_blk, blk_nd, blk_ed] = blockStmt2Dot(clause->block);
-            oss_nd << blk_nd;
-            oss_ed << blk_ed << edge2Str(n_if_stmt, n_blk);
+        {  // 纯 else
+            w.child(n_if_stmt, tokenTypeLabel(TokenType::ELSE));
         }
+        w.edge(n_if_stmt, blockStmt2Dot(w, clause->block));
     }
 
-    return std::make_tuple(n_if_stmt, oss_nd.str(), oss_ed.str());
+    return n_if_stmt;
 }
 
 /**
- * @brief   将 while 语句转为 dot 格式
+ * @brief   输出 while 语句
+ * @param   w  DOT 输出器
  * @param   ws WhileStmt 语句结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto whileStmt2Dot(const WhileStmtPtr& ws)
-    -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto whileStmt2Dot(DotWriter& w, const WhileStmtPtr& ws) -> NodeId
 {
     using TokenType = lexer::token::Type;
 
-    DotNodeDecl n_while_stmt = str2NodeDecl("WhileStmt");
-    DotNodeDecl n_while_kw = tokenType2NodeDecl(TokenType::WHILE);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nodeDecls2Str(n_while_stmt, n_while_kw);
-    oss_ed << edge2Str(n_while_stmt, n_while_kw);
-
-    auto [n_expr, expr_nd, expr_ed] = expr2Dot(ws->expr);
-    oss_nd << expr_nd;
-    oss_ed << expr_ed << edge2Str(n_while_stmt, n_expr);
-
-    auto [n_block, block_nd, block_ed] = blockStmt2Dot(ws->block);
-    oss_nd << block_nd;
-    oss_ed << block_ed << edge2Str(n_while_stmt, n_block);
+    NodeId n_while_stmt = w.node("WhileStmt");
+    w.child(n_while_stmt, tokenTypeLabel(TokenType::WHILE));
+    w.edge(n_while_stmt, expr2Dot(w, ws->expr));
+    w.edge(n_while_stmt, blockStmt2Dot(w, ws->block));
 
-    return std::make_tuple(n_while_stmt, oss_nd.str(), oss_ed.str());
+    return n_while_stmt;
 }
 
 /**
- * @brief   将语句 Stmt 转 dot 格式，根据type来进行分发
+ * @brief   输出语句 Stmt，根据 type 来进行分发
+ * @param   w    DOT 输出器
  * @param   stmt AST 语句结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto stmt2Dot(const StmtPtr& stmt) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto stmt2Dot(DotWriter& w, const StmtPtr& stmt) -> NodeId
 {
     using enum ast::NodeType;
     using TokenType = lexer::token::Type;
 
-    DotNodeDecl rt{};
-    std::string nd{};
-    std::string ed{};
+    if (w.atDepthLimit())
+    {  // 不再展开，直接跳过整条语句
+        return w.summary("Stmt");
+    }
+    DotWriter::Level level{w};
 
+    NodeId rt{};
     switch (stmt->type())
     {
         case ExprStmt:
-            std::tie(rt, nd, ed) = exprStmt2Dot(std::dynamic_pointer_cast<ast::ExprStmt>(stmt));
+            rt = exprStmt2Dot(w, std::dynamic_pointer_cast<ast::ExprStmt>(stmt));
             break;
         case RetStmt:
-            std::tie(rt, nd, ed) = returnStmt2Dot(std::dynamic_pointer_cast<ast::RetStmt>(stmt));
+            rt = returnStmt2Dot(w, std::dynamic_pointer_cast<ast::RetStmt>(stmt));
             break;
         case VarDeclStmt:
-            std::tie(rt, nd, ed) =
-                varDeclStmt2Dot(std::dynamic_pointer_cast<ast::VarDeclStmt>(stmt));
+            rt = varDeclStmt2Dot(w, std::dynamic_pointer_cast<ast::VarDeclStmt>(stmt));
             break;
         case AssignStmt:
-            std::tie(rt, nd, ed) = assignStmt2Dot(std::dynamic_pointer_cast<ast::AssignStmt>(stmt));
+            rt = assignStmt2Dot(w, std::dynamic_pointer_cast<ast::AssignStmt>(stmt));
             break;
         case VarDeclAssignStmt:
-            std::tie(rt, nd, ed) =
-                varDeclAssignStmt2Dot(std::dynamic_pointer_cast<ast::VarDeclAssignStmt>(stmt));
+            rt = varDeclAssignStmt2Dot(w, std::dynamic_pointer_cast<ast::VarDeclAssignStmt>(stmt));
             break;
-        case IfStmt:
-            std::tie(rt, nd, ed) = ifStmt2Dot(std::dynamic_pointer_cast<ast::IfStmt>(stmt));
-            return std::make_tuple(rt, nd, ed);  // 不加分号
-        case WhileStmt:
-            std::tie(rt, nd, ed) = whileStmt2Dot(std::dynamic_pointer_cast<ast::WhileStmt>(stmt));
-            return std::make_tuple(rt, nd, ed);  // 不加分号
+        case IfStmt:  // 不加分号
+            return ifStmt2Dot(w, std::dynamic_pointer_cast<ast::IfStmt>(stmt));
+        case WhileStmt:  // 不加分号
+            return whileStmt2Dot(w, std::dynamic_pointer_cast<ast::WhileStmt>(stmt));
         default:
-            rt = str2NodeDecl("NullStmt");
-            nd = nodeDecls2Str(rt);
-            ed = "";
+            rt = w.node("NullStmt");
             break;
     }
     // 为普通语句添加分号
-    DotNodeDecl n_semi = tokenType2NodeDecl(TokenType::SEMICOLON);
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
-    oss_nd << nd << nodeDecls2Str(n_semi);
-    oss_ed << ed << edge2Str(rt, n_semi);
+    w.child(rt, tokenTypeLabel(TokenType::SEMICOLON));
 
-    return std::make_tuple(rt, oss_nd.str(), oss_ed.str());
+    return rt;
 }
 
 /**
- * @brief   将函数声明转为 dot 格式
+ * @brief   输出函数声明
+ * @param   w  DOT 输出器
  * @param   fd FuncDecl 语句结点指针
- * @return  [根节点的 DotNodeDecl, 结点声明串, 边声明串]
+ * @return  根结点编号
  */
-static auto funcDecl2Dot(const FuncDeclPtr& fd) -> std::tuple<DotNodeDecl, std::string, std::string>
+static auto funcDecl2Dot(DotWriter& w, const FuncDeclPtr& fd) -> NodeId
 {
-    DotNodeDecl n_fd = str2NodeDecl("FuncDecl");
-
-    auto [n_fhd, fhd_nd, fhd_ed] = funcHeaderDecl2Dot(fd->header);
-    auto [n_bs, bs_nd, bs_ed] = blockStmt2Dot(fd->body);
-
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    NodeId n_fd = w.node("FuncDecl");
+    w.edge(n_fd, funcHeaderDecl2Dot(w, fd->header));
+    w.edge(n_fd, blockStmt2Dot(w, fd->body));
 
-    oss_nd << nodeDecls2Str(n_fd) << fhd_nd << bs_nd;
-    oss_ed << edges2Str({{n_fd, n_fhd}, {n_fd, n_bs}}) << fhd_ed << bs_ed;
-
-    return std::make_tuple(n_fd, oss_nd.str(), oss_ed.str());
+    return n_fd;
 }
 
 /**
  * @brief   将抽象语法树转换为 dot 格式，并输出到文件
- * @param   out 输出流对象
+ * @details 每个函数声明在工作线程上输出到各自的缓冲区 (一个 cluster)，
+ *          再按源码顺序依次写入文件，输出内容与线程数无关。
+ *          被过滤的函数和超过深度限制的子树不会被遍历。
+ * @param   out  输出流对象
  * @param   prog 程序的抽象语法树指针
+ * @param   opts 可视化选项
  * @return  void
  */
-void ast2Dot(std::ofstream& out, const ProgPtr& prog)
+void ast2Dot(std::ofstream& out, const ProgPtr& prog, const DotOptions& opts)
 {
-    out << "digraph AST {" << std::endl
-        << "    node [shape=ellipse, fontname=\"Courier\"]" << std::endl
-        << std::endl
-        << "    // define nodes" << std::endl;
-
-    DotNodeDecl n_prog = str2NodeDecl("Prog");
+    util::BufferedWriter sink{out};
 
-    std::ostringstream oss_nd;
-    std::ostringstream oss_ed;
+    sink << "digraph AST {\n"
+         << "    node [shape=ellipse, fontname=\"Courier\"]\n"
+         << "\n"
+         << "    prog [label = \"Prog\"]\n";
 
-    oss_nd << nodeDecls2Str(n_prog);
-    for (const auto& decl : prog->decls)
+    // 需要输出的函数，结点名仍使用其在整个程序中的下标
+    std::vector<std::pair<std::size_t, FuncDeclPtr>> funcs;
+    for (std::size_t i = 0; i < prog->decls.size(); ++i)
     {
-        assert(std::dynamic_pointer_cast<FuncDecl>(decl));
-        auto [n_fd, fd_nd, fd_ed] = funcDecl2Dot(std::dynamic_pointer_cast<FuncDecl>(decl));
-        oss_nd << fd_nd;
-        oss_ed << edge2Str(n_prog, n_fd) << fd_ed;
+        auto fd = std::dynamic_pointer_cast<FuncDecl>(prog->decls[i]);
+        assert(fd);
+        if (!opts.func.has_value() || fd->header->name == opts.func.value())
+        {
+            funcs.emplace_back(i, std::move(fd));
+        }
     }
 
-    out << oss_nd.str() << std::endl
-        << "    // define edges" << std::endl
-        << oss_ed.str() << std::endl
-        << "}" << std::endl;
+    util::orderedParallel(
+        funcs.size(), opts.jobs,
+        [&funcs, &opts](std::size_t k)
+        {
+            const auto& [idx, fd] = funcs[k];
+            DotWriter w{idx, opts.max_depth};
+            funcDecl2Dot(w, fd);
+            return w.take();
+        },
+        [&sink, &funcs](std::size_t k, std::string&& body)
+        {
+            const auto& [idx, fd] = funcs[k];
+            sink << "\n"
+                 << "    subgraph cluster_" << fd->header->name << " {\n"
+                 << "        label = \"fn " << fd->header->name << "\"\n"
+                 << body << "    }\n"
+                 << "    prog -> f" << idx << "_n0\n";
+        });
+
+    sink << "}\n";
 }
 
 }  // namespace parser::ast
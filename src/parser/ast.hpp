@@ -1,16 +1,29 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "util/position.hpp"
 
+namespace symbol
+{
+enum class VarType : std::uint8_t;
+struct Variable;
+struct Function;
+}  // namespace symbol
+
 namespace parser::ast
 {
 
+// 部分结点带有语义检查阶段填写的标注 (作用域名、类型、解析到的符号)，
+// 中间代码生成直接读取这些标注，无需再查符号表。符号指针的生命周期与所属符号表相同
+
 // 如果基类析构函数没有被声明为虚函数，则 C++ 只会调用基类的析构函数，
 // 而不会调用派生类的析构函数
 
@@ -81,6 +94,9 @@ struct Node
 };
 using NodePtr = std::shared_ptr<Node>;
 
+// 共享结点 (--hash-cons) 除第一次外各次出现的位置，按源码顺序排列
+using OccurrenceTable = std::unordered_map<const Node*, std::vector<util::Position>>;
+
 // Declaration
 struct Decl : virtual Node
 {
@@ -108,6 +124,8 @@ struct VarDeclBody : virtual Node
     bool mut = true;   // mutable or not
     std::string name;  // variable name
 
+    symbol::Variable* p_symbol{nullptr};  // 声明的变量符号 (语义检查时标注)
+
     VarDeclBody() = default;
     explicit VarDeclBody(bool mut, const std::string& n) : mut(mut), name(n) {}
     explicit VarDeclBody(bool mut, std::string&& n) : mut(mut), name(n) {}
@@ -217,6 +235,7 @@ using StmtPtr = std::shared_ptr<Stmt>;
 struct BlockStmt : Stmt
 {
     std::vector<StmtPtr> stmts;  // statements
+    std::string scope;           // 语句块所在作用域的全名 (语义检查时标注)
 
     BlockStmt() = default;
     explicit BlockStmt(const std::vector<StmtPtr>& s) : stmts(s) {}
@@ -250,8 +269,9 @@ using FuncHeaderDeclPtr = std::shared_ptr<FuncHeaderDecl>;
 // Function Declaration
 struct FuncDecl : Decl
 {
-    FuncHeaderDeclPtr header;  // function header
-    BlockStmtPtr body;         // function body
+    FuncHeaderDeclPtr header;     // function header
+    BlockStmtPtr body;            // function body
+    OccurrenceTable occurrences;  // 函数体中共享变量结点的其余出现位置，供语义检查报错
 
     FuncDecl() = default;
     explicit FuncDecl(const FuncHeaderDeclPtr& h, const BlockStmtPtr& b) : header(h), body(b) {}
@@ -267,6 +287,9 @@ using FuncDeclPtr = std::shared_ptr<FuncDecl>;
 // Expression
 struct Expr : virtual Node
 {
+    symbol::VarType var_type{};             // 表达式的类型 (语义检查时标注)
+    std::optional<std::int32_t> const_val;  // 编译期求得的值 (语义检查时标注)
+
     ~Expr() override = default;
     [[nodiscard]] auto type() const -> NodeType override { return NodeType::Expr; }
 };
@@ -324,7 +347,8 @@ using AssignElementPtr = std::shared_ptr<AssignElement>;
 
 struct Variable : AssignElement
 {
-    std::string name;  // 变量名
+    std::string name;                     // 变量名
+    symbol::Variable* p_symbol{nullptr};  // 解析到的变量符号 (语义检查时标注)
 
     Variable() = default;
     explicit Variable(const std::string& n) : AssignElement(Kind::Variable), name(n) {}
@@ -564,8 +588,9 @@ using ArithExprPtr = std::shared_ptr<ArithExpr>;
 // Call Expression
 struct CallExpr : Expr
 {
-    std::string callee;         // 被调用函数名
-    std::vector<ExprPtr> argv;  // argument vector
+    std::string callee;                 // 被调用函数名
+    std::vector<ExprPtr> argv;          // argument vector
+    symbol::Function* p_func{nullptr};  // 解析到的函数符号 (语义检查时标注)
 
     CallExpr() = default;
     explicit CallExpr(const std::string& ce, const std::vector<ExprPtr>& av) : callee(ce), argv(av)
@@ -601,6 +626,7 @@ struct IfStmt : Stmt
     ExprPtr expr;
     BlockStmtPtr if_branch;
     std::vector<ElseClausePtr> else_clauses;  // else clauses
+    std::string label;                        // 跳转标签前缀 (语义检查时标注)
 
     template <typename T1, typename T2, typename T3>
     IfStmt(T1&& e, T2&& ib, T3&& clauses)
@@ -619,6 +645,7 @@ struct WhileStmt : Stmt
 {
     ExprPtr expr;
     BlockStmtPtr block;
+    std::string label;  // 跳转标签前缀 (语义检查时标注)
 
     template <typename T1, typename T2>
     WhileStmt(T1&& expr, T2&& block) : expr(std::forward<T1>(expr)), block(std::forward<T2>(block))
@@ -726,6 +753,15 @@ struct IfExpr : Expr
 };
 using IfExprPtr = std::shared_ptr<IfExpr>;
 
-void ast2Dot(std::ofstream& out, const ProgPtr& prog);
+// AST 可视化选项
+struct DotOptions
+{
+    std::size_t jobs{1};                     // 工作线程数
+    std::optional<std::string> func{};       // 只输出该函数，为空时输出全部函数
+    std::optional<std::size_t> max_depth{};  // 语句/表达式的最大展开深度，为空时不限制
+};
+
+void ast2Dot(std::ofstream& out, const ProgPtr& prog, const DotOptions& opts = {});
+void ast2Json(std::ofstream& out, const ProgPtr& prog);
 
 }  // namespace parser::ast
@@ -0,0 +1,571 @@
+#include <string_view>
+
+#include "ast.hpp"
+#include "util/buffered_writer.hpp"
+#include "util/json_writer.hpp"
+
+namespace parser::ast
+{
+
+using util::JsonWriter;
+
+/**
+ * @brief  取结点类型名
+ * @param  type 结点类型
+ * @return 结点类型名
+ */
+static auto nodeTypeName(NodeType type) -> std::string_view
+{
+    switch (type)
+    {
+        case NodeType::Prog:
+            return "Prog";
+        case NodeType::Arg:
+            return "Arg";
+        case NodeType::Decl:
+            return "Decl";
+        case NodeType::Stmt:
+            return "Stmt";
+        case NodeType::Expr:
+            return "Expr";
+        case NodeType::VarType:
+            return "VarType";
+        case NodeType::VarDeclBody:
+            return "VarDeclBody";
+        case NodeType::AssignElement:
+            return "AssignElement";
+        case NodeType::FuncDecl:
+            return "FuncDecl";
+        case NodeType::FuncHeaderDecl:
+            return "FuncHeaderDecl";
+        case NodeType::BlockStmt:
+            return "BlockStmt";
+        case NodeType::ExprStmt:
+            return "ExprStmt";
+        case NodeType::RetStmt:
+            return "RetStmt";
+        case NodeType::VarDeclStmt:
+            return "VarDeclStmt";
+        case NodeType::AssignStmt:
+            return "AssignStmt";
+        case NodeType::VarDeclAssignStmt:
+            return "VarDeclAssignStmt";
+        case NodeType::ElseClause:
+            return "ElseClause";
+        case NodeType::IfStmt:
+            return "IfStmt";
+        case NodeType::WhileStmt:
+            return "WhileStmt";
+        case NodeType::ForStmt:
+            return "ForStmt";
+        case NodeType::LoopStmt:
+            return "LoopStmt";
+        case NodeType::BreakStmt:
+            return "BreakStmt";
+        case NodeType::ContinueStmt:
+            return "ContinueStmt";
+        case NodeType::NullStmt:
+            return "NullStmt";
+        case NodeType::Number:
+            return "Number";
+        case NodeType::Factor:
+            return "Factor";
+        case NodeType::ComparExpr:
+            return "ComparExpr";
+        case NodeType::ArithExpr:
+            return "ArithExpr";
+        case NodeType::CallExpr:
+            return "CallExpr";
+        case NodeType::ParenthesisExpr:
+            return "ParenthesisExpr";
+        case NodeType::FuncExprBlockStmt:
+            return "FuncExprBlockStmt";
+        case NodeType::IfExpr:
+            return "IfExpr";
+        case NodeType::ArrayElements:
+            return "ArrayElements";
+        case NodeType::TupleElements:
+            return "TupleElements";
+        case NodeType::Integer:
+            return "Integer";
+        case NodeType::Array:
+            return "Array";
+        case NodeType::Tuple:
+            return "Tuple";
+        case NodeType::Variable:
+            return "Variable";
+        case NodeType::Dereference:
+            return "Dereference";
+        case NodeType::ArrayAccess:
+            return "ArrayAccess";
+        case NodeType::TupleAccess:
+            return "TupleAccess";
+    }
+    return "Unknown";
+}
+
+static auto refTypeName(RefType rt) -> std::string_view
+{
+    switch (rt)
+    {
+        case RefType::Normal:
+            return "Normal";
+        case RefType::Immutable:
+            return "Immutable";
+        case RefType::Mutable:
+            return "Mutable";
+    }
+    return "Unknown";
+}
+
+static auto comparOperName(ComparOperator op) -> std::string_view
+{
+    switch (op)
+    {
+        case ComparOperator::Equal:
+            return "Equal";
+        case ComparOperator::Nequal:
+            return "Nequal";
+        case ComparOperator::Gequal:
+            return "Gequal";
+        case ComparOperator::Lequal:
+            return "Lequal";
+        case ComparOperator::Great:
+            return "Great";
+        case ComparOperator::Less:
+            return "Less";
+    }
+    return "Unknown";
+}
+
+static auto arithOperName(ArithOperator op) -> std::string_view
+{
+    switch (op)
+    {
+        case ArithOperator::Add:
+            return "Add";
+        case ArithOperator::Sub:
+            return "Sub";
+        case ArithOperator::Mul:
+            return "Mul";
+        case ArithOperator::Div:
+            return "Div";
+    }
+    return "Unknown";
+}
+
+/**
+ * @brief 开始输出一个结点对象，写入公共字段 kind 和 pos
+ * @param w    JSON 输出器
+ * @param node AST 结点
+ */
+static void beginNode(JsonWriter& w, const Node& node)
+{
+    w.beginObject();
+    w.key("kind").string(nodeTypeName(node.type()));
+    w.key("pos").beginObject();
+    w.key("row").number(node.pos.row);
+    w.key("col").number(node.pos.col);
+    w.endObject();
+}
+
+static void expr2Json(JsonWriter& w, const ExprPtr& expr);
+static void stmt2Json(JsonWriter& w, const StmtPtr& stmt);
+
+/**
+ * @brief 输出可选的表达式，为空时输出 null
+ * @param w    JSON 输出器
+ * @param expr 表达式
+ */
+static void optExpr2Json(JsonWriter& w, const std::optional<ExprPtr>& expr)
+{
+    if (expr.has_value())
+    {
+        expr2Json(w, expr.value());
+    }
+    else
+    {
+        w.null();
+    }
+}
+
+/**
+ * @brief 输出表达式数组
+ * @param w     JSON 输出器
+ * @param exprs 表达式列表
+ */
+static void exprs2Json(JsonWriter& w, const std::vector<ExprPtr>& exprs)
+{
+    w.beginArray();
+    for (const auto& e : exprs)
+    {
+        expr2Json(w, e);
+    }
+    w.endArray();
+}
+
+/**
+ * @brief 输出变量类型 VarType
+ * @param w  JSON 输出器
+ * @param vt 变量类型
+ */
+static void varType2Json(JsonWriter& w, const VarTypePtr& vt)
+{
+    beginNode(w, *vt);
+    w.key("ref").string(refTypeName(vt->ref_type));
+    switch (vt->type())
+    {
+        case NodeType::Array:
+        {
+            auto arr = std::dynamic_pointer_cast<Array>(vt);
+            w.key("count").number(arr->cnt);
+            w.key("elem_type");
+            varType2Json(w, arr->elem_type);
+            break;
+        }
+        case NodeType::Tuple:
+        {
+            auto tup = std::dynamic_pointer_cast<Tuple>(vt);
+            w.key("elem_types").beginArray();
+            for (const auto& et : tup->elem_types)
+            {
+                varType2Json(w, et);
+            }
+            w.endArray();
+            break;
+        }
+        default:
+            break;
+    }
+    w.endObject();
+}
+
+/**
+ * @brief 输出可选的变量类型，为空时输出 null
+ * @param w  JSON 输出器
+ * @param vt 变量类型
+ */
+static void optVarType2Json(JsonWriter& w, const std::optional<VarTypePtr>& vt)
+{
+    if (vt.has_value())
+    {
+        varType2Json(w, vt.value());
+    }
+    else
+    {
+        w.null();
+    }
+}
+
+/**
+ * @brief 输出变量声明体 VarDeclBody
+ * @param w   JSON 输出器
+ * @param vdb 变量声明体
+ */
+static void varDeclBody2Json(JsonWriter& w, const VarDeclBodyPtr& vdb)
+{
+    beginNode(w, *vdb);
+    w.key("mut").boolean(vdb->mut);
+    w.key("name").string(vdb->name);
+    w.endObject();
+}
+
+/**
+ * @brief 输出代码块 BlockStmt / FuncExprBlockStmt
+ * @param w  JSON 输出器
+ * @param bs 代码块
+ */
+static void blockStmt2Json(JsonWriter& w, const BlockStmtPtr& bs)
+{
+    beginNode(w, *bs);
+    w.key("stmts").beginArray();
+    for (const auto& stmt : bs->stmts)
+    {
+        stmt2Json(w, stmt);
+    }
+    w.endArray();
+    if (bs->type() == NodeType::FuncExprBlockStmt)
+    {
+        w.key("expr");
+        expr2Json(w, std::dynamic_pointer_cast<FuncExprBlockStmt>(bs)->expr);
+    }
+    w.endObject();
+}
+
+/**
+ * @brief 输出表达式 Expr，根据 type 来进行分发
+ * @param w    JSON 输出器
+ * @param expr 表达式
+ */
+static void expr2Json(JsonWriter& w, const ExprPtr& expr)
+{
+    if (!expr)
+    {
+        w.null();
+        return;
+    }
+
+    switch (expr->type())
+    {
+        case NodeType::FuncExprBlockStmt:
+            blockStmt2Json(w, std::dynamic_pointer_cast<FuncExprBlockStmt>(expr));
+            return;
+        case NodeType::LoopStmt:
+            stmt2Json(w, std::dynamic_pointer_cast<LoopStmt>(expr));
+            return;
+        default:
+            break;
+    }
+
+    beginNode(w, *expr);
+    switch (expr->type())
+    {
+        case NodeType::Number:
+            w.key("value").number(std::dynamic_pointer_cast<Number>(expr)->value);
+            break;
+        case NodeType::Variable:
+            w.key("name").string(std::dynamic_pointer_cast<Variable>(expr)->name);
+            break;
+        case NodeType::Dereference:
+            w.key("target").string(std::dynamic_pointer_cast<Dereference>(expr)->target);
+            break;
+        case NodeType::ArrayAccess:
+        {
+            auto aa = std::dynamic_pointer_cast<ArrayAccess>(expr);
+            w.key("array").string(aa->array);
+            w.key("index");
+            expr2Json(w, aa->index);
+            break;
+        }
+        case NodeType::TupleAccess:
+        {
+            auto ta = std::dynamic_pointer_cast<TupleAccess>(expr);
+            w.key("tuple").string(ta->tuple);
+            w.key("index").number(ta->index);
+            break;
+        }
+        case NodeType::Factor:
+        {
+            auto f = std::dynamic_pointer_cast<Factor>(expr);
+            w.key("ref").string(refTypeName(f->ref_type));
+            w.key("element");
+            expr2Json(w, f->element);
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto ce = std::dynamic_pointer_cast<ComparExpr>(expr);
+            w.key("op").string(comparOperName(ce->op));
+            w.key("lhs");
+            expr2Json(w, ce->lhs);
+            w.key("rhs");
+            expr2Json(w, ce->rhs);
+            break;
+        }
+        case NodeType::ArithExpr:
+        {
+            auto ae = std::dynamic_pointer_cast<ArithExpr>(expr);
+            w.key("op").string(arithOperName(ae->op));
+            w.key("lhs");
+            expr2Json(w, ae->lhs);
+            w.key("rhs");
+            expr2Json(w, ae->rhs);
+            break;
+        }
+        case NodeType::CallExpr:
+        {
+            auto ce = std::dynamic_pointer_cast<CallExpr>(expr);
+            w.key("callee").string(ce->callee);
+            w.key("args");
+            exprs2Json(w, ce->argv);
+            break;
+        }
+        case NodeType::ParenthesisExpr:
+            w.key("expr");
+            expr2Json(w, std::dynamic_pointer_cast<ParenthesisExpr>(expr)->expr);
+            break;
+        case NodeType::IfExpr:
+        {
+            auto ie = std::dynamic_pointer_cast<IfExpr>(expr);
+            w.key("condition");
+            expr2Json(w, ie->condition);
+            w.key("if_branch");
+            blockStmt2Json(w, ie->if_branch);
+            w.key("else_branch");
+            blockStmt2Json(w, ie->else_branch);
+            break;
+        }
+        case NodeType::ArrayElements:
+            w.key("elements");
+            exprs2Json(w, std::dynamic_pointer_cast<ArrayElements>(expr)->elements);
+            break;
+        case NodeType::TupleElements:
+            w.key("elements");
+            exprs2Json(w, std::dynamic_pointer_cast<TupleElements>(expr)->elements);
+            break;
+        default:
+            break;
+    }
+    w.endObject();
+}
+
+/**
+ * @brief 输出语句 Stmt，根据 type 来进行分发
+ * @param w    JSON 输出器
+ * @param stmt 语句
+ */
+static void stmt2Json(JsonWriter& w, const StmtPtr& stmt)
+{
+    switch (stmt->type())
+    {
+        case NodeType::BlockStmt:
+        case NodeType::FuncExprBlockStmt:
+            blockStmt2Json(w, std::dynamic_pointer_cast<BlockStmt>(stmt));
+            return;
+        default:
+            break;
+    }
+
+    beginNode(w, *stmt);
+    switch (stmt->type())
+    {
+        case NodeType::ExprStmt:
+            w.key("expr");
+            expr2Json(w, std::dynamic_pointer_cast<ExprStmt>(stmt)->expr);
+            break;
+        case NodeType::RetStmt:
+            w.key("value");
+            optExpr2Json(w, std::dynamic_pointer_cast<RetStmt>(stmt)->ret_val);
+            break;
+        case NodeType::VarDeclStmt:
+        case NodeType::VarDeclAssignStmt:
+        {
+            auto vds = std::dynamic_pointer_cast<VarDeclStmt>(stmt);
+            w.key("variable");
+            varDeclBody2Json(w, vds->variable);
+            w.key("var_type");
+            optVarType2Json(w, vds->var_type);
+            if (stmt->type() == NodeType::VarDeclAssignStmt)
+            {
+                w.key("expr");
+                expr2Json(w, std::dynamic_pointer_cast<VarDeclAssignStmt>(stmt)->expr);
+            }
+            break;
+        }
+        case NodeType::AssignStmt:
+        {
+            auto as = std::dynamic_pointer_cast<AssignStmt>(stmt);
+            w.key("lvalue");
+            expr2Json(w, as->lvalue);
+            w.key("expr");
+            expr2Json(w, as->expr);
+            break;
+        }
+        case NodeType::IfStmt:
+        {
+            auto is = std::dynamic_pointer_cast<IfStmt>(stmt);
+            w.key("condition");
+            expr2Json(w, is->expr);
+            w.key("if_branch");
+            blockStmt2Json(w, is->if_branch);
+            w.key("else_clauses").beginArray();
+            for (const auto& clause : is->else_clauses)
+            {
+                beginNode(w, *clause);
+                w.key("condition");
+                optExpr2Json(w, clause->expr);
+                w.key("block");
+                blockStmt2Json(w, clause->block);
+                w.endObject();
+            }
+            w.endArray();
+            break;
+        }
+        case NodeType::WhileStmt:
+        {
+            auto ws = std::dynamic_pointer_cast<WhileStmt>(stmt);
+            w.key("condition");
+            expr2Json(w, ws->expr);
+            w.key("block");
+            blockStmt2Json(w, ws->block);
+            break;
+        }
+        case NodeType::ForStmt:
+        {
+            auto fs = std::dynamic_pointer_cast<ForStmt>(stmt);
+            w.key("variable");
+            varDeclBody2Json(w, fs->var);
+            w.key("from");
+            expr2Json(w, fs->lexpr);
+            w.key("to");
+            expr2Json(w, fs->rexpr);
+            w.key("block");
+            blockStmt2Json(w, fs->block);
+            break;
+        }
+        case NodeType::LoopStmt:
+            w.key("block");
+            blockStmt2Json(w, std::dynamic_pointer_cast<LoopStmt>(stmt)->block);
+            break;
+        case NodeType::BreakStmt:
+            w.key("value");
+            optExpr2Json(w, std::dynamic_pointer_cast<BreakStmt>(stmt)->expr);
+            break;
+        default:  // ContinueStmt, NullStmt
+            break;
+    }
+    w.endObject();
+}
+
+/**
+ * @brief 输出函数声明 FuncDecl
+ * @param w  JSON 输出器
+ * @param fd 函数声明
+ */
+static void funcDecl2Json(JsonWriter& w, const FuncDeclPtr& fd)
+{
+    const auto& header = fd->header;
+
+    beginNode(w, *fd);
+    w.key("name").string(header->name);
+    w.key("args").beginArray();
+    for (const auto& arg : header->argv)
+    {
+        beginNode(w, *arg);
+        w.key("variable");
+        varDeclBody2Json(w, arg->variable);
+        w.key("var_type");
+        varType2Json(w, arg->var_type);
+        w.endObject();
+    }
+    w.endArray();
+    w.key("ret_type");
+    optVarType2Json(w, header->retval_type);
+    w.key("body");
+    blockStmt2Json(w, fd->body);
+    w.endObject();
+}
+
+/**
+ * @brief   将抽象语法树以 JSON 格式输出到文件
+ * @details 边遍历边写入缓冲输出，除递归栈外不需要与 AST 规模相关的额外内存
+ * @param   out  输出流对象
+ * @param   prog 程序的抽象语法树指针
+ */
+void ast2Json(std::ofstream& out, const ProgPtr& prog)
+{
+    util::BufferedWriter sink{out};
+    JsonWriter w{sink};
+
+    beginNode(w, *prog);
+    w.key("decls").beginArray();
+    for (const auto& decl : prog->decls)
+    {
+        funcDecl2Json(w, std::dynamic_pointer_cast<FuncDecl>(decl));
+    }
+    w.endArray();
+    w.endObject();
+    sink << '\n';
+}
+
+}  // namespace parser::ast
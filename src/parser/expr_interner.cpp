@@ -0,0 +1,181 @@
+#include "expr_interner.hpp"
+
+#include <functional>
+#include <utility>
+
+namespace parser::base
+{
+
+/**
+ * @brief  计算结构键的哈希值
+ * @param  key 结构键
+ * @return 哈希值
+ */
+auto ExprInterner::KeyHash::operator()(const Key& key) const -> std::size_t
+{
+    std::size_t seed = std::hash<std::uint8_t>{}(static_cast<std::uint8_t>(key.type));
+    auto combine = [&seed](std::size_t h)
+    {
+        seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    };
+
+    combine(std::hash<std::uint8_t>{}(key.op));
+    combine(std::hash<int>{}(key.value));
+    combine(std::hash<std::string>{}(key.name));
+    combine(std::hash<const ast::Expr*>{}(key.lhs));
+    combine(std::hash<const ast::Expr*>{}(key.rhs));
+
+    return seed;
+}
+
+/**
+ * @brief 进入新的作用域（语句块）
+ */
+void ExprInterner::enterScope()
+{
+    tables.emplace_back();
+}
+
+/**
+ * @brief 退出当前作用域，丢弃该作用域内的共享结点
+ */
+void ExprInterner::exitScope()
+{
+    if (!tables.empty())
+    {
+        tables.pop_back();
+    }
+}
+
+/**
+ * @brief 当前作用域中声明了新变量，此后同名变量可能指向不同符号，需清空共享表
+ */
+void ExprInterner::invalidate()
+{
+    if (!tables.empty())
+    {
+        tables.back() = Table{};
+    }
+}
+
+/**
+ * @brief  判断表达式是否为当前作用域内的共享（纯）结点
+ * @param  expr 表达式结点
+ * @return 是否为共享结点
+ */
+auto ExprInterner::isShared(const ast::ExprPtr& expr) const -> bool
+{
+    return expr && tables.back().pure.contains(expr.get());
+}
+
+/**
+ * @brief  构造表达式的结构键
+ * @param  expr 表达式结点
+ * @return 结构键；若表达式不纯则返回 std::nullopt
+ */
+auto ExprInterner::makeKey(const ast::ExprPtr& expr) const -> std::optional<Key>
+{
+    using ast::NodeType;
+
+    Key key{.type = expr->type()};
+    switch (expr->type())
+    {
+        default:
+            return std::nullopt;
+        case NodeType::Number:
+            key.value = std::dynamic_pointer_cast<ast::Number>(expr)->value;
+            break;
+        case NodeType::Variable:
+            key.name = std::dynamic_pointer_cast<ast::Variable>(expr)->name;
+            break;
+        case NodeType::Factor:
+        {
+            auto p_factor = std::dynamic_pointer_cast<ast::Factor>(expr);
+            if (p_factor->ref_type != ast::RefType::Normal || !isShared(p_factor->element))
+            {
+                return std::nullopt;
+            }
+            key.lhs = p_factor->element.get();
+            break;
+        }
+        case NodeType::ParenthesisExpr:
+        {
+            auto p_paren = std::dynamic_pointer_cast<ast::ParenthesisExpr>(expr);
+            if (!isShared(p_paren->expr))
+            {
+                return std::nullopt;
+            }
+            key.lhs = p_paren->expr.get();
+            break;
+        }
+        case NodeType::ArithExpr:
+        {
+            auto p_aexpr = std::dynamic_pointer_cast<ast::ArithExpr>(expr);
+            if (!isShared(p_aexpr->lhs) || !isShared(p_aexpr->rhs))
+            {
+                return std::nullopt;
+            }
+            key.op = static_cast<std::uint8_t>(p_aexpr->op);
+            key.lhs = p_aexpr->lhs.get();
+            key.rhs = p_aexpr->rhs.get();
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto p_coexpr = std::dynamic_pointer_cast<ast::ComparExpr>(expr);
+            if (!isShared(p_coexpr->lhs) || !isShared(p_coexpr->rhs))
+            {
+                return std::nullopt;
+            }
+            key.op = static_cast<std::uint8_t>(p_coexpr->op);
+            key.lhs = p_coexpr->lhs.get();
+            key.rhs = p_coexpr->rhs.get();
+            break;
+        }
+    }
+
+    return key;
+}
+
+/**
+ * @brief  查找结构相同的共享结点，若不存在则将当前结点登记为共享结点
+ * @param  expr 新构造的表达式结点（其子结点应已经过 intern）
+ * @return 共享结点；不纯的表达式原样返回
+ */
+auto ExprInterner::intern(ast::ExprPtr expr) -> ast::ExprPtr
+{
+    if (tables.empty() || !expr)
+    {
+        return expr;
+    }
+
+    auto key = makeKey(expr);
+    if (!key.has_value())
+    {
+        return expr;
+    }
+
+    auto& table = tables.back();
+    auto [it, inserted] = table.nodes.try_emplace(std::move(key.value()), expr);
+    if (inserted)
+    {
+        table.pure.insert(expr.get());
+    }
+    else if (expr->type() == ast::NodeType::Variable)
+    {  // 复合结点的各次出现已在其中的变量处记录
+        occurrences[it->second.get()].push_back(expr->pos);
+    }
+
+    return it->second;
+}
+
+/**
+ * @brief  取出已解析函数中共享变量结点的其余出现位置，并清空记录
+ * @return 共享结点 -> 除第一次外各次出现的位置
+ */
+auto ExprInterner::takeOccurrences() -> ast::OccurrenceTable
+{
+    return std::exchange(occurrences, {});
+}
+
+}  // namespace parser::base
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace parser::base
+{
+
+// 表达式结点共享表 (hash-consing)
+// 同一作用域内结构相同的纯表达式子树只保留一个结点，解析时直接复用。
+// 纯表达式指仅由 Number、Variable、ArithExpr、ComparExpr 以及包裹它们的
+// Factor (无引用修饰)、ParenthesisExpr 构成的子树，不含函数调用等副作用。
+// 共享结点的位置信息为其第一次出现的位置；Variable 结点其余各次出现的位置另记在
+// 出现位置表中，随函数声明交给语义检查，使未声明、未初始化等错误仍指向每次出现处。
+class ExprInterner
+{
+   public:
+    ExprInterner() = default;
+    ~ExprInterner() = default;
+
+   public:
+    void enterScope();
+    void exitScope();
+    void invalidate();
+
+    auto intern(ast::ExprPtr expr) -> ast::ExprPtr;
+    auto takeOccurrences() -> ast::OccurrenceTable;
+
+   private:
+    // 结点的结构键：子结点已是共享结点，因此直接比较子结点指针即可
+    struct Key
+    {
+        ast::NodeType type;
+        std::uint8_t op = 0;  // 运算符 / 引用类型
+        int value = 0;        // Number 的值
+        std::string name{};   // Variable 的变量名
+        const ast::Expr* lhs = nullptr;
+        const ast::Expr* rhs = nullptr;
+
+        auto operator==(const Key& other) const -> bool = default;
+    };
+
+    struct KeyHash
+    {
+        auto operator()(const Key& key) const -> std::size_t;
+    };
+
+    struct Table
+    {
+        std::unordered_map<Key, ast::ExprPtr, KeyHash> nodes;  // 结构键 -> 共享结点
+        std::unordered_set<const ast::Expr*> pure;             // 当前作用域内的共享结点
+    };
+
+    [[nodiscard]] auto isShared(const ast::ExprPtr& expr) const -> bool;
+    [[nodiscard]] auto makeKey(const ast::ExprPtr& expr) const -> std::optional<Key>;
+
+   private:
+    std::vector<Table> tables;          // 作用域栈，只在栈顶查找
+    ast::OccurrenceTable occurrences;  // 当前函数中共享变量结点的其余出现位置
+};
+
+}  // namespace parser::base
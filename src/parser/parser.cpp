@@ -1,6 +1,7 @@
 #include "parser.hpp"
 
 #include <cassert>
+#include <stdexcept>
 
 #include "err_report/error_reporter.hpp"
 
@@ -9,8 +10,9 @@ namespace parser::base
 
 /* constructor */
 
-Parser::Parser(std::function<std::expected<lexer::token::Token, error::LexError>()> nextTokenFunc)
-    : nextTokenFunc(std::move(nextTokenFunc))
+Parser::Parser(std::function<std::expected<lexer::token::Token, error::LexError>()> nextTokenFunc,
+               std::shared_ptr<error::ErrorReporter> reporter)
+    : reporter(std::move(reporter)), nextTokenFunc(std::move(nextTokenFunc))
 {
     advance();  // 初始化，使 current 指向第一个 token
 }
@@ -38,6 +40,7 @@ void Parser::advance()
         else
         {  // 如果识别到未知 token，则发生了词法分析错误，且需要立即终止
             reporter->report(token.error(), true);
+            throw std::runtime_error{token.error().msg};
         }
     }
 }
@@ -83,6 +86,7 @@ auto Parser::checkAhead(lexer::token::Type type) -> bool
         else
         {  // 如果识别到未知 token，则发生了词法分析错误，且需要立即终止
             reporter->report(token.error(), true);
+            throw std::runtime_error{token.error().msg};
         }
     }
     return lookahead.has_value() && lookahead->getType() == type;
@@ -99,21 +103,53 @@ void Parser::expect(lexer::token::Type type, const std::string& msg)
     {
         reporter->report(error::ParseErrorType::UnexpectToken, msg, current.getPos().row,
                          current.getPos().col, current.getValue());
+        throw std::runtime_error{msg};
     }
 }
 
 /**
- * @brief  对指定程序进行语法解析
- * @return ast::ProgPtr - AST Program 结点指针 (AST 根结点)
+ * @brief 开启表达式结点共享 (hash-consing)
+ *        开启后，同一语句块内结构相同的纯表达式子树共享同一个 AST 结点
+ */
+void Parser::enableHashConsing()
+{
+    interner = std::make_unique<ExprInterner>();
+}
+
+/**
+ * @brief  若开启了表达式结点共享，则返回结构相同的共享结点
+ * @param  expr 新构造的表达式结点
+ * @return 共享结点或原结点
+ */
+auto Parser::share(ast::ExprPtr expr) -> ast::ExprPtr
+{
+    return interner ? interner->intern(std::move(expr)) : expr;
+}
+
+/**
+ * @brief   对指定程序进行语法解析
+ * @details 遇到第一个词法或语法错误即停止解析，错误记入错误报告器，返回已解析出的函数
+ * @return  ast::ProgPtr - AST Program 结点指针 (AST 根结点)
  */
 auto Parser::parseProgram() -> ast::ProgPtr
 {
     std::vector<ast::DeclPtr> decls;  // declarations;
 
     // Prog -> (FuncDecl)*
-    while (check(lexer::token::Type::FN))
+    try
     {
-        decls.push_back(parseFuncDecl());
+        while (check(lexer::token::Type::FN))
+        {
+            decls.push_back(parseFuncDecl());
+        }
+    }
+    catch (const std::runtime_error& e)
+    {
+        if (!reporter->hasLexErr() && !reporter->hasParseErr())
+        {  // 解析函数中直接抛出的错误，同样以当前 token 为位置报告
+            reporter->report(error::ParseErrorType::UnexpectToken, e.what(), current.getPos().row,
+                             current.getPos().col, current.getValue());
+        }
     }
 
     return std::make_shared<ast::Prog>(std::move(decls));
@@ -133,6 +169,10 @@ auto Parser::parseFuncDecl() -> ast::FuncDeclPtr
 
     auto p_fdecl = std::make_shared<ast::FuncDecl>(std::move(header), std::move(body));
     p_fdecl->setPos(pos);
+    if (interner)
+    {
+        p_fdecl->occurrences = interner->takeOccurrences();
+    }
     return p_fdecl;
 }
 
@@ -166,16 +206,15 @@ auto Parser::parseFuncHeaderDecl() -> ast::FuncHeaderDeclPtr
 
     expect(TokenType::RPAREN, "Expected ')'");
 
+    std::optional<ast::VarTypePtr> type;
     if (check(TokenType::ARROW))
     {
         expect(TokenType::ARROW, "Expected '->'");
-        auto type = parseVarType();
-        return std::make_shared<ast::FuncHeaderDecl>(std::move(name), std::move(argv),
-                                                     std::move(type));
+        type = parseVarType();
     }
 
     auto p_fhdecl =
-        std::make_shared<ast::FuncHeaderDecl>(std::move(name), std::move(argv), std::nullopt);
+        std::make_shared<ast::FuncHeaderDecl>(std::move(name), std::move(argv), std::move(type));
     p_fhdecl->setPos(pos);
     return p_fhdecl;
 }
@@ -190,12 +229,16 @@ auto Parser::parseBlockStmt() -> ast::BlockStmtPtr
 
     util::Position pos = current.getPos();
     expect(TokenType::LBRACE, "Expected '{' for block");
+    if (interner)
+    {
+        interner->enterScope();
+    }
 
     std::vector<ast::StmtPtr> stmts{};
     ast::ExprPtr expr;
     bool flag_func_expr = false;
-    while (!check(TokenType::RBRACE))
-    {
+    while (!check(TokenType::RBRACE) && !check(TokenType::END))
+    {  // 输入在语句块中结束时，由下面的 expect 报告缺少 '}'
         ast::NodePtr node = parseStmtOrExpr();
         if (auto stmt = std::dynamic_pointer_cast<ast::Stmt>(node))
         {
@@ -217,6 +260,10 @@ auto Parser::parseBlockStmt() -> ast::BlockStmtPtr
     }
 
     expect(TokenType::RBRACE, "Expected '}' for block");
+    if (interner)
+    {
+        interner->exitScope();
+    }
     if (flag_func_expr)
     {
         return std::make_shared<ast::FuncExprBlockStmt>(std::move(stmts), std::move(expr));
@@ -398,6 +445,11 @@ auto Parser::parseVarDeclStmt() -> ast::VarDeclStmtPtr
 
     expect(TokenType::SEMICOLON, "Expected ';'");
 
+    if (interner)
+    {  // 新声明的变量会遮蔽同名变量，此前的共享结点不能再复用
+        interner->invalidate();
+    }
+
     if (flag_assign)
     {
         return std::make_shared<ast::VarDeclAssignStmt>(
@@ -568,7 +620,7 @@ auto Parser::parseCmpExpr(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         auto p_cmp = std::make_shared<ast::ComparExpr>(std::move(left), tokenType2ComparOper(op),
                                                        std::move(right));
         p_cmp->setPos(pos);
-        left = p_cmp;
+        left = share(p_cmp);
     }  // end while
 
     return left;
@@ -595,7 +647,7 @@ auto Parser::parseAddExpr(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         auto p_ari = std::make_shared<ast::ArithExpr>(std::move(left), tokenType2ArithOper(op),
                                                       std::move(right));
         p_ari->setPos(pos);
-        left = p_ari;
+        left = share(p_ari);
     }  // end while
 
     return left;
@@ -622,7 +674,7 @@ auto Parser::parseMulExpr(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         auto p_ari = std::make_shared<ast::ArithExpr>(std::move(left), tokenType2ArithOper(op),
                                                       std::move(right));
         p_ari->setPos(pos);
-        left = p_ari;
+        left = share(p_ari);
     }  // end while
 
     return left;
@@ -685,7 +737,7 @@ auto Parser::parseFactor(std::optional<ast::AssignElementPtr> elem) -> ast::Expr
             // 单个表达式没有逗号不是元组，而是普通括号表达式
             auto p_par = std::make_shared<ast::ParenthesisExpr>(std::move(elems[0]));
             p_par->setPos(pos);
-            return p_par;
+            return share(p_par);
         }
         auto p_telem = std::make_shared<ast::TupleElements>(elems);
         p_telem->setPos(pos);
@@ -711,7 +763,7 @@ auto Parser::parseFactor(std::optional<ast::AssignElementPtr> elem) -> ast::Expr
 
     auto p_factor = std::make_shared<ast::Factor>(ref_type, std::move(element));
     p_factor->setPos(pos);
-    return p_factor;
+    return share(p_factor);
 }
 
 /**
@@ -725,7 +777,7 @@ auto Parser::parseElement(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
 
     if (elem.has_value())
     {
-        return elem.value();
+        return share(elem.value());
     }
 
     util::Position pos = current.getPos();
@@ -736,7 +788,7 @@ auto Parser::parseElement(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         expect(TokenType::RPAREN, "Expected ')'");
         auto p_par = std::make_shared<ast::ParenthesisExpr>(std::move(expr));
         p_par->setPos(pos);
-        return p_par;
+        return share(p_par);
     }
     if (check(TokenType::INT))
     {
@@ -744,7 +796,7 @@ auto Parser::parseElement(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         advance();
         auto p_num = std::make_shared<ast::Number>(value);
         p_num->setPos(pos);
-        return p_num;
+        return share(p_num);
     }
     if (check(TokenType::ID))
     {
@@ -760,7 +812,7 @@ auto Parser::parseElement(std::optional<ast::AssignElementPtr> elem) -> ast::Exp
         advance();
         auto p_var = std::make_shared<ast::Variable>(std::move(name));
         p_var->setPos(pos);
-        return p_var;
+        return share(p_var);
     }
     if (check(TokenType::OP_MUL) && checkAhead(TokenType::ID))
     {
@@ -1016,10 +1068,14 @@ auto Parser::parseFuncExprBlockStmt() -> ast::FuncExprBlockStmtPtr
 
     util::Position pos = current.getPos();
     expect(TokenType::LBRACE, "Expected '{' for function expression block statements");
+    if (interner)
+    {
+        interner->enterScope();
+    }
 
     std::vector<ast::StmtPtr> stmts{};
     ast::ExprPtr expr{};
-    while (!check(TokenType::RBRACE))
+    while (!check(TokenType::RBRACE) && !check(TokenType::END))
     {
         ast::NodePtr node = parseStmtOrExpr();
         if (auto stmt = std::dynamic_pointer_cast<ast::Stmt>(node))
@@ -1041,6 +1097,10 @@ auto Parser::parseFuncExprBlockStmt() -> ast::FuncExprBlockStmtPtr
     }
 
     expect(TokenType::RBRACE, "Expected '}' for block");
+    if (interner)
+    {
+        interner->exitScope();
+    }
 
     auto p_febstmt = std::make_shared<ast::FuncExprBlockStmt>(std::move(stmts), std::move(expr));
     p_febstmt->setPos(pos);
@@ -6,6 +6,7 @@
 #include <optional>
 
 #include "ast.hpp"
+#include "expr_interner.hpp"
 #include "lexer/token.hpp"
 
 namespace error
@@ -24,10 +25,13 @@ class Parser
    public:
     Parser() = delete;
     explicit Parser(
-        std::function<std::expected<lexer::token::Token, error::LexError>()> nextTokenFunc);
+        std::function<std::expected<lexer::token::Token, error::LexError>()> nextTokenFunc,
+        std::shared_ptr<error::ErrorReporter> reporter);
     ~Parser() = default;
 
    public:
+    void enableHashConsing();
+
     [[nodiscard]] auto parseProgram() -> ast::ProgPtr;
 
    private:
@@ -36,6 +40,7 @@ class Parser
     [[nodiscard]] auto check(lexer::token::Type type) const -> bool;
     auto checkAhead(lexer::token::Type type) -> bool;
     void expect(lexer::token::Type type, const std::string& error_msg);
+    auto share(ast::ExprPtr expr) -> ast::ExprPtr;
 
     [[nodiscard]] auto parseArg() -> ast::ArgPtr;
     [[nodiscard]] auto parseIfExpr() -> ast::IfExprPtr;
@@ -78,6 +83,8 @@ class Parser
 
     lexer::token::Token current;                   // 当前看到的 token
     std::optional<lexer::token::Token> lookahead;  // 往后看一个 token
+
+    std::unique_ptr<ExprInterner> interner;  // 表达式结点共享表，为空时不做共享
 };
 
 }  // namespace parser::base
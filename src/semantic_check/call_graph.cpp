@@ -0,0 +1,286 @@
+#include "call_graph.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace parser::ast;
+
+namespace semantic
+{
+
+/**
+ * @brief 由函数声明建立调用图，并求出强连通分量
+ * @param fdecls 程序中的所有函数声明，下标即函数编号
+ */
+CallGraph::CallGraph(const std::vector<FuncDeclPtr>& fdecls)
+{
+    for (std::size_t i = 0; i < fdecls.size(); ++i)
+    {
+        index.emplace(fdecls[i]->header->name, static_cast<FuncId>(i));
+    }
+
+    first.reserve(fdecls.size() + 1);
+    first.push_back(0);
+    external.resize(fdecls.size(), false);
+    std::vector<FuncId> calls;
+    for (std::size_t i = 0; i < fdecls.size(); ++i)
+    {
+        calls.clear();
+        bool calls_external = false;
+        collectCalls(fdecls[i]->body, calls, calls_external);
+        std::ranges::sort(calls);
+        auto dup = std::ranges::unique(calls);
+        calls.erase(dup.begin(), dup.end());
+
+        succs.insert(succs.end(), calls.begin(), calls.end());
+        first.push_back(static_cast<std::uint32_t>(succs.size()));
+        external[i] = calls_external;
+    }
+
+    computeSccs();
+}
+
+/**
+ * @brief  按名字查找函数
+ * @param  name 函数名
+ * @return 函数编号，本程序中没有该函数时为空
+ */
+auto CallGraph::find(std::string_view name) const -> std::optional<FuncId>
+{
+    auto it = index.find(name);
+    if (it == index.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+/**
+ * @brief  取函数调用的本程序中的函数
+ * @param  f 函数编号
+ * @return 被调函数编号，升序且不重复
+ */
+auto CallGraph::callees(FuncId f) const -> std::span<const FuncId>
+{
+    return std::span<const FuncId>{succs}.subspan(first[f], first[f + 1] - first[f]);
+}
+
+/**
+ * @brief  求从入口函数出发可能调用到的函数
+ * @param  entry 入口函数编号
+ * @return 下标为函数编号，可达的函数为 true
+ */
+auto CallGraph::reachableFrom(FuncId entry) const -> std::vector<bool>
+{
+    std::vector<bool> reached(size(), false);
+    std::vector<FuncId> worklist{entry};
+    reached[entry] = true;
+    while (!worklist.empty())
+    {
+        auto f = worklist.back();
+        worklist.pop_back();
+        for (auto g : callees(f))
+        {
+            if (!reached[g])
+            {
+                reached[g] = true;
+                worklist.push_back(g);
+            }
+        }
+    }
+    return reached;
+}
+
+/**
+ * @brief 收集语句块中的函数调用
+ * @param p_bstmt        语句块结点指针
+ * @param out            被调函数编号
+ * @param calls_external 是否调用了本程序中未定义的函数
+ */
+void CallGraph::collectCalls(const BlockStmtPtr& p_bstmt, std::vector<FuncId>& out,
+                             bool& calls_external) const
+{
+    for (const auto& p_stmt : p_bstmt->stmts)
+    {
+        switch (p_stmt->type())
+        {
+            default:
+                break;
+            case NodeType::RetStmt:
+            {
+                const auto& ret_val = std::dynamic_pointer_cast<RetStmt>(p_stmt)->ret_val;
+                if (ret_val.has_value())
+                {
+                    collectCalls(ret_val.value(), out, calls_external);
+                }
+                break;
+            }
+            case NodeType::ExprStmt:
+                collectCalls(std::dynamic_pointer_cast<ExprStmt>(p_stmt)->expr, out,
+                             calls_external);
+                break;
+            case NodeType::AssignStmt:
+                collectCalls(std::dynamic_pointer_cast<AssignStmt>(p_stmt)->expr, out,
+                             calls_external);
+                break;
+            case NodeType::IfStmt:
+            {
+                auto p_istmt = std::dynamic_pointer_cast<IfStmt>(p_stmt);
+                collectCalls(p_istmt->expr, out, calls_external);
+                collectCalls(p_istmt->if_branch, out, calls_external);
+                for (const auto& p_clause : p_istmt->else_clauses)
+                {
+                    if (p_clause->expr.has_value())
+                    {
+                        collectCalls(p_clause->expr.value(), out, calls_external);
+                    }
+                    collectCalls(p_clause->block, out, calls_external);
+                }
+                break;
+            }
+            case NodeType::WhileStmt:
+            {
+                auto p_wstmt = std::dynamic_pointer_cast<WhileStmt>(p_stmt);
+                collectCalls(p_wstmt->expr, out, calls_external);
+                collectCalls(p_wstmt->block, out, calls_external);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 收集表达式中的函数调用
+ * @param p_expr         表达式结点指针
+ * @param out            被调函数编号
+ * @param calls_external 是否调用了本程序中未定义的函数
+ */
+void CallGraph::collectCalls(const ExprPtr& p_expr, std::vector<FuncId>& out,
+                             bool& calls_external) const
+{
+    switch (p_expr->type())
+    {
+        default:
+            break;
+        case NodeType::Factor:
+            collectCalls(std::dynamic_pointer_cast<Factor>(p_expr)->element, out, calls_external);
+            break;
+        case NodeType::ParenthesisExpr:
+            collectCalls(std::dynamic_pointer_cast<ParenthesisExpr>(p_expr)->expr, out,
+                         calls_external);
+            break;
+        case NodeType::ArithExpr:
+        {
+            auto p_aexpr = std::dynamic_pointer_cast<ArithExpr>(p_expr);
+            collectCalls(p_aexpr->lhs, out, calls_external);
+            collectCalls(p_aexpr->rhs, out, calls_external);
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto p_coexpr = std::dynamic_pointer_cast<ComparExpr>(p_expr);
+            collectCalls(p_coexpr->lhs, out, calls_external);
+            collectCalls(p_coexpr->rhs, out, calls_external);
+            break;
+        }
+        case NodeType::CallExpr:
+        {
+            auto p_caexpr = std::dynamic_pointer_cast<CallExpr>(p_expr);
+            auto callee = find(p_caexpr->callee);
+            if (callee.has_value())
+            {
+                out.push_back(callee.value());
+            }
+            else
+            {
+                calls_external = true;
+            }
+            for (const auto& arg : p_caexpr->argv)
+            {
+                collectCalls(arg, out, calls_external);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief   用 Tarjan 算法求强连通分量
+ * @details 以显式栈代替递归，长调用链不会耗尽线程栈。Tarjan 算法在一个分量可达的
+ *          所有分量都完成后才完成该分量，因此分量的产出顺序即自底向上的顺序
+ */
+void CallGraph::computeSccs()
+{
+    constexpr auto UNVISITED = std::numeric_limits<std::uint32_t>::max();
+
+    struct Frame
+    {
+        FuncId f;
+        std::uint32_t edge;  // 下一条待访问的出边
+    };
+
+    std::vector<std::uint32_t> order(size(), UNVISITED);  // 访问序号
+    std::vector<std::uint32_t> low(size(), 0);            // 能回溯到的最小访问序号
+    std::vector<bool> on_stack(size(), false);
+    std::vector<FuncId> stack;
+    std::vector<Frame> frames;
+    std::uint32_t counter = 0;
+    comp_of.assign(size(), 0);
+
+    auto visit = [&](FuncId f)
+    {
+        order[f] = low[f] = counter++;
+        stack.push_back(f);
+        on_stack[f] = true;
+        frames.push_back(Frame{f, first[f]});
+    };
+
+    for (FuncId root = 0; root < size(); ++root)
+    {
+        if (order[root] != UNVISITED)
+        {
+            continue;
+        }
+
+        visit(root);
+        while (!frames.empty())
+        {
+            auto f = frames.back().f;
+            if (frames.back().edge < first[f + 1])
+            {
+                auto g = succs[frames.back().edge++];
+                if (order[g] == UNVISITED)
+                {
+                    visit(g);
+                }
+                else if (on_stack[g])
+                {
+                    low[f] = std::min(low[f], order[g]);
+                }
+                continue;
+            }
+
+            frames.pop_back();
+            if (!frames.empty())
+            {
+                auto caller = frames.back().f;
+                low[caller] = std::min(low[caller], low[f]);
+            }
+            if (low[f] == order[f])
+            {  // f 为分量的根，栈中 f 及其之上的函数构成一个分量
+                auto& comp = comps.emplace_back();
+                FuncId g = 0;
+                do
+                {
+                    g = stack.back();
+                    stack.pop_back();
+                    on_stack[g] = false;
+                    comp_of[g] = comps.size() - 1;
+                    comp.push_back(g);
+                } while (g != f);
+            }
+        }
+    }
+}
+
+}  // namespace semantic
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "parser/ast.hpp"
+
+namespace semantic
+{
+
+// 函数调用图
+// 结点为程序中定义的函数 (按源码顺序编号)，边为函数体中的 CallExpr。函数都在全局作用域，
+// 被调函数按名字解析；调用了本程序中未定义的函数 (导入的或未定义的) 时只记一个标志。
+// 强连通分量按自底向上的顺序排列：一个分量调用的其他分量都排在它之前，
+// 因此按此顺序处理时，被调函数的结果总在调用者之前求得
+class CallGraph
+{
+   public:
+    using FuncId = std::uint32_t;
+
+    explicit CallGraph(const std::vector<parser::ast::FuncDeclPtr>& fdecls);
+
+   public:
+    [[nodiscard]] auto size() const -> std::size_t { return external.size(); }
+    [[nodiscard]] auto find(std::string_view name) const -> std::optional<FuncId>;
+
+    [[nodiscard]] auto callees(FuncId f) const -> std::span<const FuncId>;
+    [[nodiscard]] auto callsExternal(FuncId f) const -> bool { return external[f]; }
+
+    [[nodiscard]] auto sccs() const -> const std::vector<std::vector<FuncId>>& { return comps; }
+    [[nodiscard]] auto sccOf(FuncId f) const -> std::size_t { return comp_of[f]; }
+
+    [[nodiscard]] auto reachableFrom(FuncId entry) const -> std::vector<bool>;
+
+   private:
+    void collectCalls(const parser::ast::BlockStmtPtr& p_bstmt, std::vector<FuncId>& out,
+                      bool& calls_external) const;
+    void collectCalls(const parser::ast::ExprPtr& p_expr, std::vector<FuncId>& out,
+                      bool& calls_external) const;
+    void computeSccs();
+
+   private:
+    std::unordered_map<std::string_view, FuncId> index;  // 函数名 -> 编号，重名时取第一个
+
+    // 后继表：succs[first[f], first[f + 1]) 为 f 调用的函数，已去重
+    std::vector<std::uint32_t> first;
+    std::vector<FuncId> succs;
+    std::vector<bool> external;  // 是否调用了本程序中未定义的函数
+
+    std::vector<std::vector<FuncId>> comps;  // 强连通分量，自底向上
+    std::vector<std::size_t> comp_of;        // 函数所属的分量下标
+};
+
+}  // namespace semantic
@@ -0,0 +1,527 @@
+#include "const_evaluator.hpp"
+
+#include <limits>
+
+using namespace parser::ast;
+
+namespace semantic
+{
+
+/**
+ * @brief  判断类型是否为非引用的 i32
+ * @param  p_type 类型结点指针
+ * @return 是否为 i32
+ */
+static auto isPlainI32(const VarTypePtr& p_type) -> bool
+{
+    return p_type && p_type->type() == NodeType::Integer && p_type->ref_type == RefType::Normal;
+}
+
+/**
+ * @brief  检查表达式是否只含可求值的结点
+ * @param  p_expr  表达式结点指针
+ * @return 是否可求值
+ */
+static auto scanExpr(const ExprPtr& p_expr) -> bool
+{
+    switch (p_expr->type())
+    {
+        default:
+            return false;
+        case NodeType::Number:
+        case NodeType::Variable:
+            return true;
+        case NodeType::Factor:
+        {
+            const auto& factor = dynamic_cast<const Factor&>(*p_expr);
+            return factor.ref_type == RefType::Normal && scanExpr(factor.element);
+        }
+        case NodeType::ParenthesisExpr:
+            return scanExpr(dynamic_cast<const ParenthesisExpr&>(*p_expr).expr);
+        case NodeType::ArithExpr:
+        {
+            const auto& aexpr = dynamic_cast<const ArithExpr&>(*p_expr);
+            return scanExpr(aexpr.lhs) && scanExpr(aexpr.rhs);
+        }
+        case NodeType::ComparExpr:
+        {
+            const auto& coexpr = dynamic_cast<const ComparExpr&>(*p_expr);
+            return scanExpr(coexpr.lhs) && scanExpr(coexpr.rhs);
+        }
+        case NodeType::CallExpr:
+        {
+            const auto& caexpr = dynamic_cast<const CallExpr&>(*p_expr);
+            for (const auto& arg : caexpr.argv)
+            {
+                if (!scanExpr(arg))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief  检查语句块是否只含可求值的语句
+ * @param  p_bstmt 语句块结点指针
+ * @return 是否可求值
+ */
+static auto scanBlock(const BlockStmtPtr& p_bstmt) -> bool
+{
+    for (const auto& p_stmt : p_bstmt->stmts)
+    {
+        bool ok = false;
+        switch (p_stmt->type())
+        {
+            default:
+                break;
+            case NodeType::VarDeclStmt:
+            {
+                const auto& vdstmt = dynamic_cast<const VarDeclStmt&>(*p_stmt);
+                ok = !vdstmt.var_type.has_value() || isPlainI32(vdstmt.var_type.value());
+                break;
+            }
+            case NodeType::RetStmt:
+            {
+                const auto& rstmt = dynamic_cast<const RetStmt&>(*p_stmt);
+                ok = !rstmt.ret_val.has_value() || scanExpr(rstmt.ret_val.value());
+                break;
+            }
+            case NodeType::ExprStmt:
+                ok = scanExpr(dynamic_cast<const ExprStmt&>(*p_stmt).expr);
+                break;
+            case NodeType::AssignStmt:
+            {
+                const auto& astmt = dynamic_cast<const AssignStmt&>(*p_stmt);
+                ok = astmt.lvalue->type() == NodeType::Variable && scanExpr(astmt.expr);
+                break;
+            }
+            case NodeType::IfStmt:
+            {
+                const auto& istmt = dynamic_cast<const IfStmt&>(*p_stmt);
+                ok = scanExpr(istmt.expr) && scanBlock(istmt.if_branch) &&
+                     istmt.else_clauses.size() <= 1;
+                if (ok && istmt.else_clauses.size() == 1)
+                {
+                    const auto& clause = *istmt.else_clauses[0];
+                    ok = !clause.expr.has_value() && scanBlock(clause.block);
+                }
+                break;
+            }
+            case NodeType::WhileStmt:
+            {
+                const auto& wstmt = dynamic_cast<const WhileStmt&>(*p_stmt);
+                ok = scanExpr(wstmt.expr) && scanBlock(wstmt.block);
+                break;
+            }
+            case NodeType::NullStmt:
+                ok = true;
+                break;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief   分析程序中的纯函数
+ * @details 先逐个函数检查签名与函数体，再按调用图自底向上处理强连通分量：
+ *          分量中的函数都满足要求、且分量调用的其他分量都是纯的，分量中的函数才是纯函数。
+ *          调用了本程序中未定义的函数 (如导入的函数) 的函数非纯；互相递归的纯函数
+ *          仍为纯函数，其求值由步数预算保证终止
+ * @param   fdecls 程序中的所有函数声明
+ * @param   graph  由 fdecls 建立的调用图
+ */
+ConstEvaluator::ConstEvaluator(const std::vector<FuncDeclPtr>& fdecls, const CallGraph& graph)
+{
+    std::vector<bool> pure(fdecls.size(), true);
+    for (std::size_t i = 0; i < fdecls.size(); ++i)
+    {
+        auto id = graph.find(fdecls[i]->header->name).value();
+        if (id != i)
+        {  // 重名的函数均不求值
+            pure[id] = false;
+            pure[i] = false;
+        }
+    }
+
+    for (std::size_t i = 0; i < fdecls.size(); ++i)
+    {
+        const auto& header = *fdecls[i]->header;
+        bool ok = pure[i] && !graph.callsExternal(i);
+        ok = ok && (!header.retval_type.has_value() || isPlainI32(header.retval_type.value()));
+        for (const auto& arg : header.argv)
+        {
+            ok = ok && isPlainI32(arg->var_type);
+        }
+        pure[i] = ok && scanBlock(fdecls[i]->body);
+    }
+
+    for (const auto& comp : graph.sccs())
+    {
+        bool ok = true;
+        for (auto f : comp)
+        {
+            ok = ok && pure[f];
+            for (auto g : graph.callees(f))
+            {  // 分量内的函数尚未确定，只看已处理过的分量
+                ok = ok && (graph.sccOf(g) == graph.sccOf(f) || pure[g]);
+            }
+        }
+        for (auto f : comp)
+        {
+            pure[f] = ok;
+        }
+    }
+
+    for (std::size_t i = 0; i < fdecls.size(); ++i)
+    {
+        if (pure[i])
+        {
+            pure_funcs.emplace(fdecls[i]->header->name, fdecls[i].get());
+        }
+    }
+}
+
+/**
+ * @brief  判断函数是否为纯函数
+ * @param  name 函数名
+ * @return 是否为纯函数
+ */
+auto ConstEvaluator::isPure(const std::string& name) const -> bool
+{
+    return pure_funcs.contains(name);
+}
+
+/**
+ * @brief  以常量实参调用纯函数，在预算内求出返回值
+ * @param  callee 函数名，须为纯函数
+ * @param  args   实参的值
+ * @return 返回值；无法在预算内求值或函数没有返回值时为空
+ */
+auto ConstEvaluator::evalCall(const std::string& callee, const std::vector<std::int32_t>& args)
+    const -> std::optional<std::int32_t>
+{
+    auto it = pure_funcs.find(callee);
+    if (it == pure_funcs.end() || it->second->header->argv.size() != args.size())
+    {
+        return std::nullopt;
+    }
+
+    State state{};
+    try
+    {
+        return call(state, *it->second, args);
+    }
+    catch (const Abort&)
+    {
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief 计一步，超出预算时放弃求值
+ * @param state 求值状态
+ */
+void ConstEvaluator::step(State& state)
+{
+    if (++state.steps > STEP_BUDGET)
+    {
+        throw Abort{};
+    }
+}
+
+/**
+ * @brief  执行一次函数调用
+ * @param  state 求值状态
+ * @param  fdecl 函数声明
+ * @param  args  实参的值
+ * @return 返回值，函数没有返回值时为空
+ */
+auto ConstEvaluator::call(State& state, const FuncDecl& fdecl,
+                          const std::vector<std::int32_t>& args) const
+    -> std::optional<std::int32_t>
+{
+    if (state.depth >= MAX_DEPTH)
+    {
+        throw Abort{};
+    }
+    ++state.depth;
+
+    Frame frame{};
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        frame.vars.emplace_back(fdecl.header->argv[i]->variable->name, args[i]);
+    }
+    execBlock(state, frame, fdecl.body);
+
+    if (fdecl.header->retval_type.has_value() && !frame.ret.has_value())
+    {  // 有返回类型却没有返回值
+        throw Abort{};
+    }
+
+    --state.depth;
+    return frame.ret;
+}
+
+/**
+ * @brief  执行语句块
+ * @param  state   求值状态
+ * @param  frame   当前调用的局部变量
+ * @param  p_bstmt 语句块结点指针
+ * @return 是否执行了 return 语句
+ */
+auto ConstEvaluator::execBlock(State& state, Frame& frame, const BlockStmtPtr& p_bstmt) const
+    -> bool
+{
+    auto lookup = [&frame](const std::string& name) -> std::optional<std::int32_t>&
+    {
+        for (auto it = frame.vars.rbegin(); it != frame.vars.rend(); ++it)
+        {
+            if (it->first == name)
+            {
+                return it->second;
+            }
+        }
+        throw Abort{};
+    };
+
+    auto scope_begin = frame.vars.size();
+    bool returned = false;
+    for (const auto& p_stmt : p_bstmt->stmts)
+    {
+        step(state);
+        switch (p_stmt->type())
+        {
+            default:
+                throw Abort{};
+            case NodeType::VarDeclStmt:
+                frame.vars.emplace_back(dynamic_cast<const VarDeclStmt&>(*p_stmt).variable->name,
+                                        std::nullopt);
+                break;
+            case NodeType::RetStmt:
+            {
+                const auto& rstmt = dynamic_cast<const RetStmt&>(*p_stmt);
+                if (rstmt.ret_val.has_value())
+                {
+                    frame.ret = eval(state, frame, rstmt.ret_val.value());
+                }
+                returned = true;
+                break;
+            }
+            case NodeType::ExprStmt:
+            {
+                const auto& expr = dynamic_cast<const ExprStmt&>(*p_stmt).expr;
+                if (expr->type() == NodeType::CallExpr)
+                {  // 调用可以没有返回值
+                    evalCallExpr(state, frame, dynamic_cast<const CallExpr&>(*expr));
+                }
+                else
+                {
+                    eval(state, frame, expr);
+                }
+                break;
+            }
+            case NodeType::AssignStmt:
+            {
+                const auto& astmt = dynamic_cast<const AssignStmt&>(*p_stmt);
+                auto value = eval(state, frame, astmt.expr);
+                lookup(dynamic_cast<const Variable&>(*astmt.lvalue).name) = value;
+                break;
+            }
+            case NodeType::IfStmt:
+            {
+                const auto& istmt = dynamic_cast<const IfStmt&>(*p_stmt);
+                if (eval(state, frame, istmt.expr) != 0)
+                {
+                    returned = execBlock(state, frame, istmt.if_branch);
+                }
+                else if (!istmt.else_clauses.empty())
+                {
+                    returned = execBlock(state, frame, istmt.else_clauses[0]->block);
+                }
+                break;
+            }
+            case NodeType::WhileStmt:
+            {
+                const auto& wstmt = dynamic_cast<const WhileStmt&>(*p_stmt);
+                while (!returned && eval(state, frame, wstmt.expr) != 0)
+                {
+                    returned = execBlock(state, frame, wstmt.block);
+                }
+                break;
+            }
+            case NodeType::NullStmt:
+                break;
+        }
+        if (returned)
+        {
+            break;
+        }
+    }
+
+    frame.vars.resize(scope_begin);
+    return returned;
+}
+
+/**
+ * @brief  求表达式的值
+ * @param  state  求值状态
+ * @param  frame  当前调用的局部变量
+ * @param  p_expr 表达式结点指针
+ * @return 表达式的值，比较表达式为 1 或 0
+ */
+auto ConstEvaluator::eval(State& state, Frame& frame, const ExprPtr& p_expr) const
+    -> std::int32_t
+{
+    step(state);
+    switch (p_expr->type())
+    {
+        default:
+            throw Abort{};
+        case NodeType::Number:
+            return dynamic_cast<const Number&>(*p_expr).value;
+        case NodeType::Variable:
+        {
+            const auto& name = dynamic_cast<const Variable&>(*p_expr).name;
+            for (auto it = frame.vars.rbegin(); it != frame.vars.rend(); ++it)
+            {
+                if (it->first == name)
+                {
+                    if (!it->second.has_value())
+                    {  // 读取未初始化的变量
+                        throw Abort{};
+                    }
+                    return it->second.value();
+                }
+            }
+            throw Abort{};
+        }
+        case NodeType::Factor:
+            return eval(state, frame, dynamic_cast<const Factor&>(*p_expr).element);
+        case NodeType::ParenthesisExpr:
+            return eval(state, frame, dynamic_cast<const ParenthesisExpr&>(*p_expr).expr);
+        case NodeType::ArithExpr:
+        {
+            const auto& aexpr = dynamic_cast<const ArithExpr&>(*p_expr);
+            auto lhs = eval(state, frame, aexpr.lhs);
+            auto rhs = eval(state, frame, aexpr.rhs);
+            auto result = arith(aexpr.op, lhs, rhs);
+            if (!result.has_value())
+            {
+                throw Abort{};
+            }
+            return result.value();
+        }
+        case NodeType::ComparExpr:
+        {
+            const auto& coexpr = dynamic_cast<const ComparExpr&>(*p_expr);
+            auto lhs = eval(state, frame, coexpr.lhs);
+            auto rhs = eval(state, frame, coexpr.rhs);
+            return compar(coexpr.op, lhs, rhs);
+        }
+        case NodeType::CallExpr:
+        {
+            auto value = evalCallExpr(state, frame, dynamic_cast<const CallExpr&>(*p_expr));
+            if (!value.has_value())
+            {  // 使用了没有返回值的调用
+                throw Abort{};
+            }
+            return value.value();
+        }
+    }
+}
+
+/**
+ * @brief  计算算术运算
+ * @param  op  算术运算符
+ * @param  lhs 左操作数
+ * @param  rhs 右操作数
+ * @return 运算结果；溢出或除零时为空，这些行为留给运行时
+ */
+auto ConstEvaluator::arith(ArithOperator op, std::int32_t lhs, std::int32_t rhs)
+    -> std::optional<std::int32_t>
+{
+    std::int32_t result{};
+    bool overflow = false;
+    switch (op)
+    {
+        case ArithOperator::Add:
+            overflow = __builtin_add_overflow(lhs, rhs, &result);
+            break;
+        case ArithOperator::Sub:
+            overflow = __builtin_sub_overflow(lhs, rhs, &result);
+            break;
+        case ArithOperator::Mul:
+            overflow = __builtin_mul_overflow(lhs, rhs, &result);
+            break;
+        case ArithOperator::Div:
+            overflow = rhs == 0 || (lhs == std::numeric_limits<std::int32_t>::min() && rhs == -1);
+            result = overflow ? 0 : lhs / rhs;
+            break;
+    }
+    if (overflow)
+    {
+        return std::nullopt;
+    }
+    return result;
+}
+
+/**
+ * @brief  计算比较运算
+ * @param  op  比较运算符
+ * @param  lhs 左操作数
+ * @param  rhs 右操作数
+ * @return 成立为 1，否则为 0
+ */
+auto ConstEvaluator::compar(ComparOperator op, std::int32_t lhs, std::int32_t rhs) -> std::int32_t
+{
+    switch (op)
+    {
+        case ComparOperator::Equal:
+            return lhs == rhs ? 1 : 0;
+        case ComparOperator::Nequal:
+            return lhs != rhs ? 1 : 0;
+        case ComparOperator::Gequal:
+            return lhs >= rhs ? 1 : 0;
+        case ComparOperator::Lequal:
+            return lhs <= rhs ? 1 : 0;
+        case ComparOperator::Great:
+            return lhs > rhs ? 1 : 0;
+        case ComparOperator::Less:
+            return lhs < rhs ? 1 : 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief  求调用表达式的值
+ * @param  state  求值状态
+ * @param  frame  当前调用的局部变量
+ * @param  caexpr 调用表达式结点
+ * @return 返回值，被调函数没有返回值时为空
+ */
+auto ConstEvaluator::evalCallExpr(State& state, Frame& frame, const CallExpr& caexpr) const
+    -> std::optional<std::int32_t>
+{
+    auto it = pure_funcs.find(caexpr.callee);
+    if (it == pure_funcs.end() || it->second->header->argv.size() != caexpr.argv.size())
+    {
+        throw Abort{};
+    }
+
+    std::vector<std::int32_t> args;
+    args.reserve(caexpr.argv.size());
+    for (const auto& arg : caexpr.argv)
+    {
+        args.push_back(eval(state, frame, arg));
+    }
+    return call(state, *it->second, args);
+}
+
+}  // namespace semantic
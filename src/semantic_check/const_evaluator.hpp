@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "parser/ast.hpp"
+
+namespace semantic
+{
+
+// 纯函数的编译期求值
+// 纯函数指：形参与返回值均为 i32 (不含引用)，函数体只含语义检查支持的语句与表达式，
+// 且只调用本程序中定义的纯函数。以常量实参调用返回 i32 的纯函数时，直接在步数预算内
+// 解释执行函数体得到返回值；超出预算或调用深度、除零、溢出、读取未初始化的变量时放弃求值，
+// 调用保持原样。求值只读取解析时建立的 AST 字段，可以与语义检查并行进行
+class ConstEvaluator
+{
+   public:
+    static constexpr std::size_t STEP_BUDGET = 1U << 14;  // 一次求值最多执行的语句与表达式数
+    static constexpr std::size_t MAX_DEPTH = 64;          // 最大调用深度
+
+    ConstEvaluator(const std::vector<parser::ast::FuncDeclPtr>& fdecls, const CallGraph& graph);
+
+   public:
+    [[nodiscard]]
+    auto isPure(const std::string& name) const -> bool;
+
+    [[nodiscard]]
+    auto evalCall(const std::string& callee, const std::vector<std::int32_t>& args) const
+        -> std::optional<std::int32_t>;
+
+    [[nodiscard]]
+    static auto arith(parser::ast::ArithOperator op, std::int32_t lhs, std::int32_t rhs)
+        -> std::optional<std::int32_t>;
+    [[nodiscard]]
+    static auto compar(parser::ast::ComparOperator op, std::int32_t lhs, std::int32_t rhs)
+        -> std::int32_t;
+
+   private:
+    struct Abort  // 放弃求值
+    {
+    };
+
+    // 一次调用的局部变量，按声明顺序存放，语句块结束时截断；未初始化的变量值为空
+    struct Frame
+    {
+        std::vector<std::pair<std::string_view, std::optional<std::int32_t>>> vars;
+        std::optional<std::int32_t> ret;  // 返回值
+    };
+
+    struct State
+    {
+        std::size_t steps = 0;  // 已执行的步数
+        std::size_t depth = 0;  // 当前调用深度
+    };
+
+    static void step(State& state);
+
+    auto call(State& state, const parser::ast::FuncDecl& fdecl,
+              const std::vector<std::int32_t>& args) const -> std::optional<std::int32_t>;
+    auto execBlock(State& state, Frame& frame, const parser::ast::BlockStmtPtr& p_bstmt) const
+        -> bool;
+    auto eval(State& state, Frame& frame, const parser::ast::ExprPtr& p_expr) const
+        -> std::int32_t;
+    auto evalCallExpr(State& state, Frame& frame, const parser::ast::CallExpr& caexpr) const
+        -> std::optional<std::int32_t>;
+
+   private:
+    std::unordered_map<std::string_view, const parser::ast::FuncDecl*> pure_funcs;  // 纯函数
+};
+
+}  // namespace semantic
@@ -0,0 +1,312 @@
+#include "const_folder.hpp"
+
+using namespace parser::ast;
+
+namespace semantic
+{
+
+/**
+ * @brief 折叠函数体中的常量表达式，传播常量变量的值
+ * @param p_fdecl 已通过语义检查的函数声明结点指针
+ */
+void ConstFolder::foldFuncDecl(const FuncDeclPtr& p_fdecl)
+{
+    vars.clear();
+    scanBlockStmt(p_fdecl->body);
+    foldBlockStmt(p_fdecl->body);
+}
+
+/**
+ * @brief  取局部变量的赋值情况
+ * @param  p_var 变量符号指针
+ * @return 赋值情况
+ */
+auto ConstFolder::varInfo(const symbol::Variable* p_var) -> VarInfo&
+{
+    if (p_var->local_id >= vars.size())
+    {
+        vars.resize(p_var->local_id + 1);
+    }
+    return vars[p_var->local_id];
+}
+
+/**
+ * @brief  判断变量的值能否在编译期确定
+ * @param  p_var 变量符号指针
+ * @return 只被赋值一次且未被可变引用的局部 i32 变量返回其符号，否则为 nullptr
+ */
+auto ConstFolder::constVar(symbol::Variable* p_var) -> symbol::IntegerPtr
+{
+    if (p_var == nullptr || p_var->formal)
+    {
+        return nullptr;
+    }
+    const auto& info = varInfo(p_var);
+    if (info.assigns != 1 || info.escaped)
+    {
+        return nullptr;
+    }
+    return dynamic_cast<symbol::IntegerPtr>(p_var);
+}
+
+/**
+ * @brief 统计语句块中各变量的赋值次数与可变引用
+ * @param p_bstmt 语句块结点指针
+ */
+void ConstFolder::scanBlockStmt(const BlockStmtPtr& p_bstmt)
+{
+    for (const auto& p_stmt : p_bstmt->stmts)
+    {
+        switch (p_stmt->type())
+        {
+            default:
+                break;
+            case NodeType::RetStmt:
+            {
+                const auto& ret_val = std::dynamic_pointer_cast<RetStmt>(p_stmt)->ret_val;
+                if (ret_val.has_value())
+                {
+                    scanExpr(ret_val.value());
+                }
+                break;
+            }
+            case NodeType::ExprStmt:
+                scanExpr(std::dynamic_pointer_cast<ExprStmt>(p_stmt)->expr);
+                break;
+            case NodeType::AssignStmt:
+            {
+                auto p_astmt = std::dynamic_pointer_cast<AssignStmt>(p_stmt);
+                auto p_lvalue = std::dynamic_pointer_cast<Variable>(p_astmt->lvalue);
+                if (p_lvalue && p_lvalue->p_symbol != nullptr)
+                {
+                    ++varInfo(p_lvalue->p_symbol).assigns;
+                }
+                scanExpr(p_astmt->expr);
+                break;
+            }
+            case NodeType::IfStmt:
+            {
+                auto p_istmt = std::dynamic_pointer_cast<IfStmt>(p_stmt);
+                scanExpr(p_istmt->expr);
+                scanBlockStmt(p_istmt->if_branch);
+                for (const auto& p_clause : p_istmt->else_clauses)
+                {
+                    if (p_clause->expr.has_value())
+                    {
+                        scanExpr(p_clause->expr.value());
+                    }
+                    scanBlockStmt(p_clause->block);
+                }
+                break;
+            }
+            case NodeType::WhileStmt:
+            {
+                auto p_wstmt = std::dynamic_pointer_cast<WhileStmt>(p_stmt);
+                scanExpr(p_wstmt->expr);
+                scanBlockStmt(p_wstmt->block);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 记录表达式中被可变引用的变量
+ * @param p_expr 表达式结点指针
+ */
+void ConstFolder::scanExpr(const ExprPtr& p_expr)
+{
+    switch (p_expr->type())
+    {
+        default:
+            break;
+        case NodeType::Factor:
+        {
+            auto p_factor = std::dynamic_pointer_cast<Factor>(p_expr);
+            auto p_var = std::dynamic_pointer_cast<Variable>(p_factor->element);
+            if (p_factor->ref_type == RefType::Mutable && p_var && p_var->p_symbol != nullptr)
+            {
+                varInfo(p_var->p_symbol).escaped = true;
+            }
+            scanExpr(p_factor->element);
+            break;
+        }
+        case NodeType::ParenthesisExpr:
+            scanExpr(std::dynamic_pointer_cast<ParenthesisExpr>(p_expr)->expr);
+            break;
+        case NodeType::ArithExpr:
+        {
+            auto p_aexpr = std::dynamic_pointer_cast<ArithExpr>(p_expr);
+            scanExpr(p_aexpr->lhs);
+            scanExpr(p_aexpr->rhs);
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto p_coexpr = std::dynamic_pointer_cast<ComparExpr>(p_expr);
+            scanExpr(p_coexpr->lhs);
+            scanExpr(p_coexpr->rhs);
+            break;
+        }
+        case NodeType::CallExpr:
+            for (const auto& arg : std::dynamic_pointer_cast<CallExpr>(p_expr)->argv)
+            {
+                scanExpr(arg);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief 按源码顺序折叠语句块，条件为常量的 if / while 只折叠会执行的分支
+ * @param p_bstmt 语句块结点指针
+ */
+void ConstFolder::foldBlockStmt(const BlockStmtPtr& p_bstmt)
+{
+    for (const auto& p_stmt : p_bstmt->stmts)
+    {
+        switch (p_stmt->type())
+        {
+            default:
+                break;
+            case NodeType::RetStmt:
+            {
+                const auto& ret_val = std::dynamic_pointer_cast<RetStmt>(p_stmt)->ret_val;
+                if (ret_val.has_value())
+                {
+                    foldExpr(ret_val.value());
+                }
+                break;
+            }
+            case NodeType::ExprStmt:
+                foldExpr(std::dynamic_pointer_cast<ExprStmt>(p_stmt)->expr);
+                break;
+            case NodeType::AssignStmt:
+            {
+                auto p_astmt = std::dynamic_pointer_cast<AssignStmt>(p_stmt);
+                auto value = foldExpr(p_astmt->expr);
+                auto p_lvalue = std::dynamic_pointer_cast<Variable>(p_astmt->lvalue);
+                auto* p_int = p_lvalue ? constVar(p_lvalue->p_symbol) : nullptr;
+                if (p_int != nullptr)
+                {
+                    p_int->init_val = value;
+                }
+                break;
+            }
+            case NodeType::IfStmt:
+            {
+                auto p_istmt = std::dynamic_pointer_cast<IfStmt>(p_stmt);
+                auto cond = foldExpr(p_istmt->expr);
+                if (!cond.has_value() || cond.value() != 0)
+                {
+                    foldBlockStmt(p_istmt->if_branch);
+                }
+                if (!cond.has_value() || cond.value() == 0)
+                {
+                    for (const auto& p_clause : p_istmt->else_clauses)
+                    {
+                        foldBlockStmt(p_clause->block);
+                    }
+                }
+                break;
+            }
+            case NodeType::WhileStmt:
+            {
+                auto p_wstmt = std::dynamic_pointer_cast<WhileStmt>(p_stmt);
+                auto cond = foldExpr(p_wstmt->expr);
+                if (!cond.has_value() || cond.value() != 0)
+                {
+                    foldBlockStmt(p_wstmt->block);
+                }
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief  折叠表达式，值为常量的子表达式标注在 const_val 上
+ * @param  p_expr 表达式结点指针
+ * @return 表达式的常量值，不是常量时为空
+ */
+auto ConstFolder::foldExpr(const ExprPtr& p_expr) -> std::optional<std::int32_t>
+{
+    std::optional<std::int32_t> value;
+    switch (p_expr->type())
+    {
+        default:
+            break;
+        case NodeType::Number:
+            return std::dynamic_pointer_cast<Number>(p_expr)->value;
+        case NodeType::Variable:
+        {
+            auto* p_int = constVar(std::dynamic_pointer_cast<Variable>(p_expr)->p_symbol);
+            if (p_int != nullptr)
+            {
+                value = p_int->init_val;
+            }
+            break;
+        }
+        case NodeType::Factor:
+        {
+            auto p_factor = std::dynamic_pointer_cast<Factor>(p_expr);
+            if (p_factor->ref_type == RefType::Normal)
+            {  // 引用需要变量本身，不能替换为值
+                value = foldExpr(p_factor->element);
+            }
+            break;
+        }
+        case NodeType::ParenthesisExpr:
+            value = foldExpr(std::dynamic_pointer_cast<ParenthesisExpr>(p_expr)->expr);
+            break;
+        case NodeType::ArithExpr:
+        {
+            auto p_aexpr = std::dynamic_pointer_cast<ArithExpr>(p_expr);
+            auto lhs = foldExpr(p_aexpr->lhs);
+            auto rhs = foldExpr(p_aexpr->rhs);
+            if (lhs.has_value() && rhs.has_value())
+            {
+                value = ConstEvaluator::arith(p_aexpr->op, lhs.value(), rhs.value());
+            }
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto p_coexpr = std::dynamic_pointer_cast<ComparExpr>(p_expr);
+            auto lhs = foldExpr(p_coexpr->lhs);
+            auto rhs = foldExpr(p_coexpr->rhs);
+            if (lhs.has_value() && rhs.has_value())
+            {
+                value = ConstEvaluator::compar(p_coexpr->op, lhs.value(), rhs.value());
+            }
+            break;
+        }
+        case NodeType::CallExpr:
+        {
+            // 以常量实参调用返回 i32 的纯函数时在编译期求值
+            auto p_caexpr = std::dynamic_pointer_cast<CallExpr>(p_expr);
+            std::vector<std::int32_t> args;
+            args.reserve(p_caexpr->argv.size());
+            for (const auto& arg : p_caexpr->argv)
+            {
+                auto arg_val = foldExpr(arg);
+                if (arg_val.has_value())
+                {
+                    args.push_back(arg_val.value());
+                }
+            }
+            if (args.size() == p_caexpr->argv.size() &&
+                p_caexpr->p_func->retval_type == symbol::VarType::I32 &&
+                evaluator.isPure(p_caexpr->callee))
+            {
+                value = evaluator.evalCall(p_caexpr->callee, args);
+            }
+            break;
+        }
+    }
+
+    p_expr->const_val = value;
+    return value;
+}
+
+}  // namespace semantic
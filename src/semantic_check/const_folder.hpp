@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "const_evaluator.hpp"
+#include "parser/ast.hpp"
+#include "symbol_table.hpp"
+
+namespace semantic
+{
+
+// 函数体的常量折叠与常量传播
+// 在函数体通过语义检查后进行，结果标注在 Expr::const_val 上，IR 生成直接使用标注的值，
+// 并据此删去条件为常量的 if / while 的死分支。不替换结点：结构相同的纯表达式在解析时
+// 已共享结点，父结点也以共享指针持有子结点。
+// 只被赋值一次且未被可变引用的局部变量，若所赋的值为常量，其值记入
+// symbol::Integer::init_val，之后的使用处直接标注为该值。确定初始化检查保证每个使用处
+// 之前都执行过这次赋值，且 if / while 的嵌套结构保证这次赋值在源码中位于所有使用之前，
+// 因此按源码顺序遍历一遍即可完成传播
+class ConstFolder
+{
+   public:
+    explicit ConstFolder(const ConstEvaluator& evaluator) : evaluator(evaluator) {}
+
+   public:
+    void foldFuncDecl(const parser::ast::FuncDeclPtr& p_fdecl);
+
+   private:
+    // 局部变量的赋值情况，下标为 symbol::Variable::local_id
+    struct VarInfo
+    {
+        std::uint32_t assigns = 0;  // 赋值语句的个数
+        bool escaped = false;       // 是否被可变引用
+    };
+
+    auto varInfo(const symbol::Variable* p_var) -> VarInfo&;
+    auto constVar(symbol::Variable* p_var) -> symbol::IntegerPtr;
+
+    void scanBlockStmt(const parser::ast::BlockStmtPtr& p_bstmt);
+    void scanExpr(const parser::ast::ExprPtr& p_expr);
+
+    void foldBlockStmt(const parser::ast::BlockStmtPtr& p_bstmt);
+    auto foldExpr(const parser::ast::ExprPtr& p_expr) -> std::optional<std::int32_t>;
+
+   private:
+    const ConstEvaluator& evaluator;
+    std::vector<VarInfo> vars;
+};
+
+}  // namespace semantic
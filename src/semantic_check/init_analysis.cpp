@@ -0,0 +1,174 @@
+#include "init_analysis.hpp"
+
+#include <algorithm>
+#include <queue>
+
+#include "util/bit_vector.hpp"
+
+namespace semantic
+{
+
+/**
+ * @brief 清空控制流图，只保留入口块
+ */
+void InitAnalysis::reset()
+{
+    blocks.clear();
+    blocks.emplace_back();
+    cur = 0;
+    var_cnt = 0;
+    use_cnt = 0;
+}
+
+/**
+ * @brief  分配局部变量编号
+ * @return 新变量的编号
+ */
+auto InitAnalysis::newVar() -> VarId
+{
+    return var_cnt++;
+}
+
+/**
+ * @brief  新建基本块，新块没有前驱，需要通过 addEdge 连接
+ * @return 新块的编号
+ */
+auto InitAnalysis::newBlock() -> BlockId
+{
+    blocks.emplace_back();
+    return static_cast<BlockId>(blocks.size() - 1);
+}
+
+/**
+ * @brief 添加控制流边
+ * @param from 起点块
+ * @param to   终点块
+ */
+void InitAnalysis::addEdge(BlockId from, BlockId to)
+{
+    blocks[from].succs.push_back(to);
+}
+
+/**
+ * @brief 在当前块中记录变量声明
+ * @param var 变量编号
+ */
+void InitAnalysis::declare(VarId var)
+{
+    blocks[cur].events.push_back(Event{EventKind::Declare, var, 0});
+}
+
+/**
+ * @brief 在当前块中记录变量赋值
+ * @param var 变量编号
+ */
+void InitAnalysis::assign(VarId var)
+{
+    blocks[cur].events.push_back(Event{EventKind::Assign, var, 0});
+}
+
+/**
+ * @brief  在当前块中记录变量使用
+ * @param  var 变量编号
+ * @return 本次使用的编号
+ */
+auto InitAnalysis::use(VarId var) -> UseId
+{
+    blocks[cur].events.push_back(Event{EventKind::Use, var, use_cnt});
+    return use_cnt++;
+}
+
+/**
+ * @brief   求解数据流，找出可能在初始化前发生的使用
+ * @details 块的传递函数为 out = (in - kill) | gen。入口块的 in 为空集，其余块的 in 初始为全集，
+ *          因此不可达的块 (如 return 之后) 不会因为没有前驱而报告此前已赋值的变量。
+ *          工作表中的块处理后，将其 out 与各后继的 in 求交，后继的 in 发生变化时再次入表，
+ *          直至不动点
+ * @return  可能未初始化的使用编号，升序
+ */
+auto InitAnalysis::solve() const -> std::vector<UseId>
+{
+    const auto n = blocks.size();
+
+    std::vector<util::BitVector> gen(n, util::BitVector{var_cnt});
+    std::vector<util::BitVector> kill(n, util::BitVector{var_cnt});
+    for (std::size_t b = 0; b < n; ++b)
+    {
+        for (const auto& event : blocks[b].events)
+        {
+            if (event.kind == EventKind::Declare)
+            {
+                kill[b].set(event.var);
+                gen[b].reset(event.var);
+            }
+            else if (event.kind == EventKind::Assign)
+            {
+                gen[b].set(event.var);
+                kill[b].reset(event.var);
+            }
+        }
+    }
+
+    std::vector<util::BitVector> in(n, util::BitVector{var_cnt, true});
+    in[0] = util::BitVector{var_cnt};
+
+    // 按建块顺序 (即源码顺序) 初始化工作表，大部分块只需处理一次
+    std::queue<BlockId> worklist;
+    std::vector<bool> queued(n, true);
+    for (BlockId b = 0; b < n; ++b)
+    {
+        worklist.push(b);
+    }
+
+    util::BitVector out{var_cnt};
+    while (!worklist.empty())
+    {
+        auto b = worklist.front();
+        worklist.pop();
+        queued[b] = false;
+
+        out = in[b];
+        out.subtract(kill[b]);
+        out.unionWith(gen[b]);
+
+        for (auto s : blocks[b].succs)
+        {
+            if (in[s].intersectWith(out) && !queued[s])
+            {
+                worklist.push(s);
+                queued[s] = true;
+            }
+        }
+    }
+
+    // 在各块的 in 上重放块内事件，逐个判断使用处变量是否已初始化
+    std::vector<UseId> uninit;
+    for (std::size_t b = 0; b < n; ++b)
+    {
+        auto& state = out;  // 复用 out 的存储
+        state = in[b];
+        for (const auto& event : blocks[b].events)
+        {
+            switch (event.kind)
+            {
+                case EventKind::Declare:
+                    state.reset(event.var);
+                    break;
+                case EventKind::Assign:
+                    state.set(event.var);
+                    break;
+                case EventKind::Use:
+                    if (!state.test(event.var))
+                    {
+                        uninit.push_back(event.use);
+                    }
+                    break;
+            }
+        }
+    }
+
+    std::sort(uninit.begin(), uninit.end());
+    return uninit;
+}
+
+}  // namespace semantic
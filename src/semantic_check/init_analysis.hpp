@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace semantic
+{
+
+// 函数内的确定初始化分析 (definite initialization)
+// 语义检查遍历函数体时同步建立控制流图：每个基本块按顺序记录局部变量的声明、赋值与使用，
+// 遍历结束后以工作表算法求解前向的 must 数据流 (交汇运算为交集)，
+// 找出在某条到达路径上尚未赋值就被使用的位置。变量集合用以局部变量编号为下标的位向量表示
+class InitAnalysis
+{
+   public:
+    using VarId = std::uint32_t;    // 局部变量编号
+    using BlockId = std::uint32_t;  // 基本块编号，0 为函数入口
+    using UseId = std::uint32_t;    // 变量使用的编号，按记录顺序递增
+
+    InitAnalysis() { reset(); }
+
+   public:
+    void reset();
+
+    auto newVar() -> VarId;
+    auto newBlock() -> BlockId;
+
+    [[nodiscard]] auto current() const -> BlockId { return cur; }
+    void setCurrent(BlockId block) { cur = block; }
+    void addEdge(BlockId from, BlockId to);
+
+    void declare(VarId var);
+    void assign(VarId var);
+    auto use(VarId var) -> UseId;
+
+    [[nodiscard]] auto solve() const -> std::vector<UseId>;
+
+   private:
+    enum class EventKind : std::uint8_t
+    {
+        Declare,  // 声明，变量回到未初始化状态 (循环中的重复声明)
+        Assign,   // 赋值
+        Use,      // 使用
+    };
+
+    struct Event
+    {
+        EventKind kind;
+        VarId var;
+        UseId use;  // 仅 Use 事件有效
+    };
+
+    struct Block
+    {
+        std::vector<Event> events;   // 块内按顺序发生的事件
+        std::vector<BlockId> succs;  // 后继块
+    };
+
+    std::vector<Block> blocks;
+    BlockId cur = 0;    // 当前正在追加事件的块
+    VarId var_cnt = 0;  // 已分配的局部变量数
+    UseId use_cnt = 0;  // 已记录的使用数
+};
+
+}  // namespace semantic
@@ -1,8 +1,10 @@
 #include "semantic_checker.hpp"
 
 #include <cassert>
+#include <vector>
 
 #include "err_report/error_type.hpp"
+#include "util/parallel.hpp"
 
 using namespace parser::ast;
 
@@ -28,18 +30,116 @@ void SemanticChecker::setSymbolTable(std::shared_ptr<symbol::SymbolTable> p_stab
 }
 
 /**
- * @brief  对程序入口节点执行语义检查，递归检查所有函数声明
- * @param  p_prog 程序根节点指针，包含所有顶层声明
+ * @brief  设置并行检查函数体的线程数
+ * @param  jobs 线程数，不大于 1 时串行检查
  */
-void SemanticChecker::checkProg(const ProgPtr& p_prog)
+void SemanticChecker::setJobs(std::size_t jobs)
 {
+    this->jobs = jobs;
+}
+
+/**
+ * @brief   对程序入口节点执行语义检查，递归检查所有函数声明
+ * @details 分两遍进行：第一遍登记所有函数签名并建立调用图，因此函数体中可以调用在其后定义的函数；
+ *          第二遍并行检查各函数体，每个函数体使用独立的子符号表与错误缓冲，
+ *          检查结果按源码顺序并入错误报告器。未指定 on_func 时子表并入符号表；
+ *          否则按源码顺序将子表交给 on_func，回调返回后子表即被释放。
+ *          on_checked 在检查该函数体的工作线程上执行，可用于并行地翻译各函数
+ * @param   p_prog     程序根节点指针，包含所有顶层声明
+ * @param   on_func    函数体检查完成后按源码顺序执行的回调
+ * @param   on_checked 函数体检查完成后在工作线程上执行的回调
+ */
+void SemanticChecker::checkProg(const ProgPtr& p_prog, const FuncHandler& on_func,
+                                const FuncWorker& on_checked)
+{
+    std::vector<FuncDeclPtr> fdecls;
+    fdecls.reserve(p_prog->decls.size());
     for (const auto& p_decl : p_prog->decls)
     {
         // 最顶层的产生式为 Prog -> (FuncDecl)*
         auto p_fdecl = std::dynamic_pointer_cast<FuncDecl>(p_decl);
         assert(p_fdecl);  // 在 parser 的实现中，只能解析 FuncDecl，碰到非函数声明会直接终止解析！
-        checkFuncDecl(p_fdecl);
+        declareFuncHeader(p_fdecl->header);
+        fdecls.push_back(std::move(p_fdecl));
+    }
+    p_call_graph = std::make_shared<const CallGraph>(fdecls);
+    p_const_eval = std::make_shared<const ConstEvaluator>(fdecls, *p_call_graph);
+
+    // 工作线程直接向收集器提交各函数体的错误，检查结束后按函数顺序并入错误报告器
+    p_diag = std::make_shared<error::DiagnosticSink>();
+    util::orderedParallel(
+        fdecls.size(), jobs,
+        [&](std::size_t i)
+        {
+            SemanticChecker worker{};
+            worker.setSymbolTable(p_stable->makeSubtable());
+            worker.setErrorReporter(std::make_shared<error::ErrorReporter>());
+            worker.p_diag = p_diag;
+            worker.p_const_eval = p_const_eval;
+            worker.checkFuncDecl(fdecls[i]);
+            p_diag->submit(i, std::move(*worker.p_ereporter));
+            if (on_checked)
+            {
+                on_checked(i, fdecls[i]);
+            }
+            return worker.p_stable;
+        },
+        [&](std::size_t i, std::shared_ptr<symbol::SymbolTable>&& p_sub)
+        {
+            if (on_func)
+            {
+                on_func(i, fdecls[i], p_sub);
+            }
+            else
+            {
+                p_stable->mergeSubtable(std::move(*p_sub));
+            }
+        });
+    p_diag->drainInto(*p_ereporter);
+}
+
+/**
+ * @brief  取已发现的语义错误数
+ * @return 已并入错误报告器的语义错误数与并行检查中已提交的错误数之和
+ */
+auto SemanticChecker::errorCount() const -> std::size_t
+{
+    return p_ereporter->semanticErrCount() + (p_diag ? p_diag->errorCount() : 0);
+}
+
+/**
+ * @brief   登记函数签名
+ * @details 同名函数已由符号接口导入且签名一致时，视为本文件给出了它的定义，以本地定义为准；
+ *          签名不一致或本文件中重复定义时报告错误，保留先登记的签名
+ * @param   p_fhdecl 函数头部声明节点指针
+ */
+void SemanticChecker::declareFuncHeader(const FuncHeaderDeclPtr& p_fhdecl)
+{
+    int argc = p_fhdecl->argv.size();
+    auto rt = p_fhdecl->retval_type.has_value() ? symbol::VarType::I32 : symbol::VarType::Null;
+
+    if (auto opt_prev = p_stable->lookupFunc(p_fhdecl->name); opt_prev.has_value())
+    {
+        auto p_prev = opt_prev.value();
+        if (p_prev->imported && p_prev->argc == argc && p_prev->retval_type == rt)
+        {
+            p_prev->imported = false;
+            p_prev->setPos(p_fhdecl->pos);
+            return;
+        }
+
+        auto msg = p_prev->imported
+                       ? std::format("函数 '{}' 与导入的同名函数签名不一致", p_fhdecl->name)
+                       : std::format("函数 '{}' 重复定义", p_fhdecl->name);
+        p_ereporter->report(error::SemanticErrorType::FuncRedefinition, msg,
+                            p_fhdecl->pos.row, p_fhdecl->pos.col, p_stable->getCurScope());
+        return;
     }
+
+    auto p_func = p_stable->createFunction(p_fhdecl->name, argc, rt);
+    p_func->setPos(p_fhdecl->pos);
+
+    p_stable->declareFunc(p_fhdecl->name, p_func);
 }
 
 /**
@@ -48,6 +148,14 @@ void SemanticChecker::checkProg(const ProgPtr& p_prog)
  */
 void SemanticChecker::checkFuncDecl(const FuncDeclPtr& p_fdecl)
 {
+    init_flow.reset();
+    var_uses.clear();
+    p_occurrences = &p_fdecl->occurrences;
+    visit_cnt.clear();
+    type_infer.reset();
+    untyped_vars.clear();
+    type_checks.clear();
+
     p_stable->enterScope(p_fdecl->header->name);  // 注意不要在没进入作用域时就开始声明变量！
     checkFuncHeaderDecl(p_fdecl->header);
     if (!checkBlockStmt(p_fdecl->body))
@@ -66,31 +174,121 @@ void SemanticChecker::checkFuncDecl(const FuncDeclPtr& p_fdecl)
         }
     }
 
+    reportDeferredErrs();
+
+    // 函数体没有语义错误时才折叠常量，折叠依赖检查时标注的符号；
+    // 其他函数已出错时不会生成 IR，也不必折叠
+    if (p_const_eval && p_ereporter->semanticErrCount() == 0 && p_diag->errorCount() == 0)
+    {
+        ConstFolder{*p_const_eval}.foldFuncDecl(p_fdecl);
+    }
+
     p_stable->exitScope();
 }
 
 /**
- * @brief  检查函数头部声明的语义，处理函数名、返回类型和形参
+ * @brief   求解当前函数的确定初始化分析与类型推导，报告可能在初始化前使用的变量及
+ *          无法推导出类型的变量
+ * @details 两类错误都按检查时的位置插入错误报告器，与其他语义错误保持遍历顺序
+ */
+void SemanticChecker::reportDeferredErrs()
+{
+    type_infer.solve();
+    for (const auto& use : var_uses)
+    {  // 使用处标注的是检查时的类型，以推导结果为准
+        use.p_node->var_type = use.p_node->p_symbol->var_type;
+    }
+
+    auto uninit = init_flow.solve();
+    std::vector<std::pair<std::size_t, error::SemanticError>> errs;
+    auto reportUninit = [&](InitAnalysis::UseId use_id)
+    {
+        const auto& use = var_uses[use_id];
+        errs.emplace_back(use.err_slot,
+                          error::SemanticError{
+                              error::SemanticErrorType::UninitializedVariable,
+                              std::format("变量 '{}' 在第一次使用前未初始化", use.p_node->name),
+                              use.pos.row, use.pos.col,
+                              p_stable->getScopeName(use.scope)});
+    };
+
+    const auto& cfunc_name = p_stable->getFuncName();
+    auto ret_type = p_stable->lookupFunc(cfunc_name).value()->retval_type;
+
+    // 两个序列都已按遍历顺序排列，按变量使用的编号归并
+    auto it = uninit.begin();
+    for (const auto& check : type_checks)
+    {
+        error::SemanticErrorType type;
+        std::string msg;
+        if (check.kind == TypeCheck::Kind::Inferred)
+        {
+            if (check.p_var->var_type != symbol::VarType::Unknown)
+            {
+                continue;
+            }
+            type = error::SemanticErrorType::TypeInferenceFailure;
+            msg = std::format("变量 '{}' 无法通过自动类型推导确定类型", check.p_var->name);
+        }
+        else
+        {
+            if (check.p_var->var_type == ret_type)
+            {
+                continue;
+            }
+            type = error::SemanticErrorType::FuncReturnTypeMismatch;
+            msg = std::format("函数 '{}' return 语句返回类型错误", cfunc_name);
+        }
+
+        for (; it != uninit.end() && *it < check.use_cnt; ++it)
+        {
+            reportUninit(*it);
+        }
+        errs.emplace_back(check.err_slot,
+                          error::SemanticError{type, std::move(msg), check.pos.row, check.pos.col,
+                                               p_stable->getScopeName(check.scope)});
+    }
+    for (; it != uninit.end(); ++it)
+    {
+        reportUninit(*it);
+    }
+
+    p_ereporter->insertSemanticErrs(std::move(errs));
+}
+
+/**
+ * @brief 记录语句块中未标注类型的变量，待类型推导完成后确认其类型
+ * @param first 本语句块的变量在 untyped_vars 中的起始下标
+ */
+void SemanticChecker::recordUntypedVars(std::size_t first)
+{
+    for (auto i = first; i < untyped_vars.size(); ++i)
+    {
+        type_checks.push_back(TypeCheck{TypeCheck::Kind::Inferred, untyped_vars[i],
+                                        untyped_vars[i]->pos, p_stable->getCurScopeId(),
+                                        p_ereporter->semanticErrCount(), var_uses.size()});
+    }
+    untyped_vars.resize(first);
+}
+
+/**
+ * @brief  检查函数头部声明的语义，在函数作用域中声明形参 (函数签名已在第一遍登记)
  * @param  p_fhdecl 函数头部声明节点指针
  */
 void SemanticChecker::checkFuncHeaderDecl(const FuncHeaderDeclPtr& p_fhdecl)
 {
-    int argc = p_fhdecl->argv.size();
     for (const auto& arg : p_fhdecl->argv)
     {
         std::string name = arg->variable->name;
         // 形参的初始值在函数调用时才会被赋予
-        auto p_fparam = std::make_shared<symbol::Integer>(name, true, std::nullopt);
+        auto p_fparam = p_stable->createInteger(name, true, std::nullopt);
         p_fparam->setPos(arg->pos);
+        p_fparam->local_id = init_flow.newVar();
+        init_flow.assign(p_fparam->local_id);
+        arg->variable->p_symbol = p_fparam;
+        type_infer.addVar(p_fparam);
         p_stable->declareVar(name, p_fparam);
     }
-
-    auto rt = p_fhdecl->retval_type.has_value() ? symbol::VarType::I32 : symbol::VarType::Null;
-
-    auto p_func = std::make_shared<symbol::Function>(p_fhdecl->name, argc, rt);
-    p_func->setPos(p_fhdecl->pos);
-
-    p_stable->declareFunc(p_fhdecl->name, p_func);
 }
 
 /**
@@ -103,6 +301,8 @@ auto SemanticChecker::checkBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
     int if_cnt = 1;
     int while_cnt = 1;
     bool has_retstmt = false;
+    auto first_untyped = untyped_vars.size();
+    p_bstmt->scope = p_stable->getCurScope();
 
     for (const auto& p_stmt : p_bstmt->stmts)
     {
@@ -115,6 +315,7 @@ auto SemanticChecker::checkBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
                 break;
             case NodeType::RetStmt:
                 checkRetStmt(std::dynamic_pointer_cast<RetStmt>(p_stmt));
+                init_flow.setCurrent(init_flow.newBlock());  // return 之后的语句不可达
                 has_retstmt = true;
                 break;
             case NodeType::ExprStmt:
@@ -124,27 +325,30 @@ auto SemanticChecker::checkBlockStmt(const BlockStmtPtr& p_bstmt) -> bool
                 checkAssignStmt(std::dynamic_pointer_cast<AssignStmt>(p_stmt));
                 break;
             case NodeType::IfStmt:
+            {
+                auto p_istmt = std::dynamic_pointer_cast<IfStmt>(p_stmt);
                 p_stable->enterScope(std::format("if{}", if_cnt++));
-                checkIfStmt(std::dynamic_pointer_cast<IfStmt>(p_stmt));
+                p_istmt->label = p_stable->getCurScopeLabel();
+                checkIfStmt(p_istmt);
                 p_stable->exitScope();
                 break;
+            }
             case NodeType::WhileStmt:
+            {
+                auto p_wstmt = std::dynamic_pointer_cast<WhileStmt>(p_stmt);
                 p_stable->enterScope(std::format("while{}", while_cnt++));
-                checkWhileStmt(std::dynamic_pointer_cast<WhileStmt>(p_stmt));
+                p_wstmt->label = p_stable->getCurScopeLabel();
+                checkWhileStmt(p_wstmt);
                 p_stable->exitScope();
                 break;
+            }
             case NodeType::NullStmt:
                 break;
         }
     }
 
-    auto failed_vars = p_stable->checkAutoTypeInference();  // 语句块后检查变量是否有类型
-    for (const auto& p_var : failed_vars)
-    {
-        p_ereporter->report(error::SemanticErrorType::TypeInferenceFailure,
-                            std::format("变量 '{}' 无法通过自动类型推导确定类型", p_var->name),
-                            p_var->pos.row, p_var->pos.col, p_stable->getCurScope());
-    }
+    // 语句块后检查变量是否有类型，变量的类型可能由之后的赋值确定，要等整个函数体检查完
+    recordUntypedVars(first_untyped);
 
     return has_retstmt;
 }
@@ -161,23 +365,23 @@ void SemanticChecker::checkVarDeclStmt(const VarDeclStmtPtr& p_vdstmt)
     // 因此，我们这里简单的记录变量
     // 需要注意的是，由于存在自动类型推导，如果没有指定类型，理论上只能声明一个 Variable
     // 符号，而不能直接声明一个 Variable 的子类
-    // 简单起见，这里将所有变量声明为一个 i32 的变量
+    // 简单起见，这里将所有变量声明为一个 i32 的变量，以便常量传播记录其初值
 
     const std::string& name = p_vdstmt->variable->name;
 
-    symbol::VariablePtr p_var;
-    if (p_vdstmt->var_type.has_value())
-    {
-        // 1: let mut a : i32; 明确类型，直接构造变量
-        p_var = std::make_shared<symbol::Integer>(name, false, std::nullopt);
-    }
-    else
+    // 1: let mut a : i32; 明确类型，直接构造变量
+    symbol::VariablePtr p_var = p_stable->createInteger(name, false, std::nullopt);
+    if (!p_vdstmt->var_type.has_value())
     {
         // 2: let mut a; 自动类型推导 —— 类型未知
-        p_var = std::make_shared<symbol::Variable>(name, false, symbol::VarType::Unknown);
+        p_var->var_type = symbol::VarType::Unknown;
+        untyped_vars.push_back(p_var);
     }
-    p_var->initialized = false;
     p_var->setPos(p_vdstmt->pos);
+    p_var->local_id = init_flow.newVar();
+    init_flow.declare(p_var->local_id);
+    p_vdstmt->variable->p_symbol = p_var;
+    type_infer.addVar(p_var);
     p_stable->declareVar(name, p_var);
 }
 
@@ -198,7 +402,16 @@ void SemanticChecker::checkRetStmt(const RetStmtPtr& p_rstmt)
 
         if (p_func->retval_type != symbol::VarType::Null)
         {  // 函数有明确返回类型
-            if (p_func->retval_type != ret_type)
+            auto p_src = ret_type == symbol::VarType::Unknown
+                             ? rvalueVar(p_rstmt->ret_val.value())
+                             : nullptr;
+            if (p_src != nullptr)
+            {  // 返回的变量类型尚未确定，待类型推导完成后再检查
+                type_checks.push_back(TypeCheck{TypeCheck::Kind::Return, p_src, p_rstmt->pos,
+                                                p_stable->getCurScopeId(),
+                                                p_ereporter->semanticErrCount(), var_uses.size()});
+            }
+            else if (p_func->retval_type != ret_type)
             {  // 返回值表达式类型与函数返回类型不符
                 p_ereporter->report(error::SemanticErrorType::FuncReturnTypeMismatch,
                                     std::format("函数 '{}' return 语句返回类型错误", cfunc_name),
@@ -255,7 +468,7 @@ auto SemanticChecker::checkExpr(const ExprPtr& p_expr) -> symbol::VarType
         case NodeType::ParenthesisExpr:
         {
             auto paren_expr = std::dynamic_pointer_cast<ParenthesisExpr>(p_expr);
-            return checkExpr(paren_expr->expr);
+            return paren_expr->var_type = checkExpr(paren_expr->expr);
         }
         case NodeType::CallExpr:
             return checkCallExpr(std::dynamic_pointer_cast<CallExpr>(p_expr));
@@ -287,10 +500,15 @@ auto SemanticChecker::checkCallExpr(const CallExprPtr& p_caexpr) -> symbol::VarT
         p_ereporter->report(error::SemanticErrorType::UndefinedFunctionCall,
                             std::format("调用了未定义的函数 '{}'", p_caexpr->callee),
                             p_caexpr->pos.row, p_caexpr->pos.col, p_stable->getCurScope());
-        return symbol::VarType::Null;
+        for (const auto& arg : p_caexpr->argv)
+        {
+            skipOccurrences(arg);
+        }
+        return p_caexpr->var_type = symbol::VarType::Null;
     }
 
     const auto& p_func = opt_func.value();
+    p_caexpr->p_func = p_func;
 
     if (static_cast<int>(p_caexpr->argv.size()) != p_func->argc)
     {
@@ -311,7 +529,7 @@ auto SemanticChecker::checkCallExpr(const CallExprPtr& p_caexpr) -> symbol::VarT
         }
     }
 
-    return p_func->retval_type;
+    return p_caexpr->var_type = p_func->retval_type;
 }
 
 /**
@@ -327,7 +545,7 @@ auto SemanticChecker::checkComparExpr(const ComparExprPtr& p_coexpr) -> symbol::
     checkExprStmt(std::make_shared<ExprStmt>(p_coexpr->rhs));
 
     // 这里只是一个简化的实现，理论上应该是一个 Bool 类型的值
-    return symbol::VarType::I32;
+    return p_coexpr->var_type = symbol::VarType::I32;
 }
 
 /**
@@ -340,7 +558,7 @@ auto SemanticChecker::checkArithExpr(const ArithExprPtr& p_aexpr) -> symbol::Var
     checkExprStmt(std::make_shared<ExprStmt>(p_aexpr->lhs));
     checkExprStmt(std::make_shared<ExprStmt>(p_aexpr->rhs));
 
-    return symbol::VarType::I32;
+    return p_aexpr->var_type = symbol::VarType::I32;
 }
 
 /**
@@ -357,11 +575,14 @@ auto SemanticChecker::checkFactor(const FactorPtr& p_factor) -> symbol::VarType
         default:
             throw std::runtime_error{"不支持的因子类型"};
         case NodeType::Number:
-            return checkNumber(std::dynamic_pointer_cast<Number>(p_factor->element));
+            return p_factor->var_type =
+                       checkNumber(std::dynamic_pointer_cast<Number>(p_factor->element));
         case NodeType::Variable:
-            return checkVariable(std::dynamic_pointer_cast<Variable>(p_factor->element));
+            return p_factor->var_type =
+                       checkVariable(std::dynamic_pointer_cast<Variable>(p_factor->element));
         case NodeType::CallExpr:
-            return checkCallExpr(std::dynamic_pointer_cast<CallExpr>(p_factor->element));
+            return p_factor->var_type =
+                       checkCallExpr(std::dynamic_pointer_cast<CallExpr>(p_factor->element));
     }
 }
 
@@ -374,24 +595,87 @@ auto SemanticChecker::checkVariable(const VariablePtr& p_variable) -> symbol::Va
 {
     auto opt_var = p_stable->lookupVar(p_variable->name);
 
+    auto pos = occurrencePos(p_variable.get());
     if (!opt_var.has_value())
     {
         p_ereporter->report(error::SemanticErrorType::UndeclaredVariable,
-                            std::format("变量 '{}' 未声明", p_variable->name), p_variable->pos.row,
-                            p_variable->pos.col, p_stable->getCurScope());
-        return symbol::VarType::Unknown;
+                            std::format("变量 '{}' 未声明", p_variable->name), pos.row, pos.col,
+                            p_stable->getCurScope());
+        return p_variable->var_type = symbol::VarType::Unknown;
     }
 
     const auto& p_var = opt_var.value();
+    p_variable->p_symbol = p_var;
+
+    // 是否已初始化要等整个函数体检查完后由数据流分析确定
+    init_flow.use(p_var->local_id);
+    var_uses.push_back(VarUse{p_variable.get(), pos, p_stable->getCurScopeId(),
+                              p_ereporter->semanticErrCount()});
 
-    if (!p_var->initialized && !p_var->formal)
+    return p_variable->var_type = p_var->var_type;
+}
+
+/**
+ * @brief   取变量结点本次出现的位置
+ * @param   p_node 变量结点
+ * @return  本次出现的位置
+ * @details 共享的变量结点在源码中出现多次，解析时第一次之后的位置按源码顺序记在出现位置表中。
+ *          检查器按源码顺序恰好访问每次出现一次 (跳过的子表达式由 skipOccurrences 计数)，
+ *          因此第 k 次访问对应第 k 次出现
+ */
+auto SemanticChecker::occurrencePos(const Variable* p_node) -> util::Position
+{
+    auto it = p_occurrences->find(p_node);
+    if (it == p_occurrences->end())
     {
-        p_ereporter->report(error::SemanticErrorType::UninitializedVariable,
-                            std::format("变量 '{}' 在第一次使用前未初始化", p_variable->name),
-                            p_variable->pos.row, p_variable->pos.col, p_stable->getCurScope());
+        return p_node->pos;
     }
 
-    return p_var->var_type;
+    auto k = visit_cnt[p_node]++;
+    assert(k <= it->second.size());
+    return k == 0 ? p_node->pos : it->second[k - 1];
+}
+
+/**
+ * @brief 不检查而跳过表达式时，为其中的变量结点计入本次出现，使之后的出现位置不错位
+ * @param p_expr 被跳过的表达式
+ */
+void SemanticChecker::skipOccurrences(const ExprPtr& p_expr)
+{
+    switch (p_expr->type())
+    {
+        default:
+            break;
+        case NodeType::Variable:
+            occurrencePos(static_cast<const Variable*>(p_expr.get()));
+            break;
+        case NodeType::Factor:
+            skipOccurrences(std::static_pointer_cast<Factor>(p_expr)->element);
+            break;
+        case NodeType::ParenthesisExpr:
+            skipOccurrences(std::static_pointer_cast<ParenthesisExpr>(p_expr)->expr);
+            break;
+        case NodeType::ArithExpr:
+        {
+            auto p_aexpr = std::static_pointer_cast<ArithExpr>(p_expr);
+            skipOccurrences(p_aexpr->lhs);
+            skipOccurrences(p_aexpr->rhs);
+            break;
+        }
+        case NodeType::ComparExpr:
+        {
+            auto p_coexpr = std::static_pointer_cast<ComparExpr>(p_expr);
+            skipOccurrences(p_coexpr->lhs);
+            skipOccurrences(p_coexpr->rhs);
+            break;
+        }
+        case NodeType::CallExpr:
+            for (const auto& arg : std::static_pointer_cast<CallExpr>(p_expr)->argv)
+            {
+                skipOccurrences(arg);
+            }
+            break;
+    }
 }
 
 /**
@@ -401,7 +685,7 @@ auto SemanticChecker::checkVariable(const VariablePtr& p_variable) -> symbol::Va
  */
 auto SemanticChecker::checkNumber(const NumberPtr& p_number) -> symbol::VarType
 {
-    return symbol::VarType::I32;  // 异常简化的实现
+    return p_number->var_type = symbol::VarType::I32;  // 异常简化的实现
 }
 
 /**
@@ -430,15 +714,24 @@ void SemanticChecker::checkAssignStmt(const AssignStmtPtr& p_astmt)
     }
 
     const auto& p_var = opt_var.value();
+    lhs_var->p_symbol = p_var;
 
     // 先检查右侧表达式是否合法
     auto expr_stmt = std::make_shared<ExprStmt>(p_astmt->expr);
     symbol::VarType rhs_type = checkExpr(expr_stmt->expr);
 
-    // 自动类型推导
+    // 自动类型推导：右侧为类型尚未确定的变量时记录约束，留待函数体检查完后求解
     if (p_var->var_type == symbol::VarType::Unknown)
     {
-        p_var->var_type = rhs_type;
+        auto p_src = rhs_type == symbol::VarType::Unknown ? rvalueVar(p_astmt->expr) : nullptr;
+        if (p_src != nullptr)
+        {
+            type_infer.addFlow(p_src, p_var);
+        }
+        else
+        {
+            p_var->var_type = rhs_type;
+        }
     }
     else if (rhs_type != symbol::VarType::Unknown && p_var->var_type != rhs_type)
     {
@@ -447,8 +740,37 @@ void SemanticChecker::checkAssignStmt(const AssignStmtPtr& p_astmt)
                             p_astmt->lvalue->pos.row, p_astmt->lvalue->pos.col,
                             p_stable->getCurScope());
     }
-    // 右侧合法后，标记左侧变量为“已初始化”
-    p_var->initialized = true;
+    // 右侧合法后，左侧变量在此之后视为已初始化
+    init_flow.assign(p_var->local_id);
+}
+
+/**
+ * @brief  取作为右值的单个变量，用于记录类型推导的约束
+ * @param  p_expr 表达式节点指针
+ * @return 表达式 (去掉括号后) 仅为一个已声明的变量时返回该变量，否则为 nullptr
+ */
+auto SemanticChecker::rvalueVar(const ExprPtr& p_expr) const -> symbol::VariablePtr
+{
+    auto p_cur = p_expr;
+    while (true)
+    {
+        switch (p_cur->type())
+        {
+            default:
+                return nullptr;
+            case NodeType::ParenthesisExpr:
+                p_cur = std::static_pointer_cast<ParenthesisExpr>(p_cur)->expr;
+                break;
+            case NodeType::Factor:
+                p_cur = std::static_pointer_cast<Factor>(p_cur)->element;
+                break;
+            case NodeType::Variable:
+            {
+                auto opt_var = p_stable->lookupVar(std::static_pointer_cast<Variable>(p_cur)->name);
+                return opt_var.has_value() ? opt_var.value() : nullptr;
+            }
+        }
+    }
 }
 
 /**
@@ -458,15 +780,32 @@ void SemanticChecker::checkAssignStmt(const AssignStmtPtr& p_astmt)
 void SemanticChecker::checkIfStmt(const IfStmtPtr& p_istmt)
 {
     checkExprStmt(std::make_shared<ExprStmt>(p_istmt->expr));
+
+    // cond -> then -> join，cond -> else -> join (无 else 时 cond -> join)
+    auto cond = init_flow.current();
+    auto then_block = init_flow.newBlock();
+    init_flow.addEdge(cond, then_block);
+    init_flow.setCurrent(then_block);
     checkBlockStmt(p_istmt->if_branch);
+    auto then_end = init_flow.current();
 
     assert(p_istmt->else_clauses.size() <= 1);
+    auto else_end = cond;
     if (p_istmt->else_clauses.size() == 1)
     {
+        auto else_block = init_flow.newBlock();
+        init_flow.addEdge(cond, else_block);
+        init_flow.setCurrent(else_block);
         p_stable->enterScope("else");
         checkBlockStmt(p_istmt->else_clauses[0]->block);
         p_stable->exitScope();
+        else_end = init_flow.current();
     }
+
+    auto join = init_flow.newBlock();
+    init_flow.addEdge(then_end, join);
+    init_flow.addEdge(else_end, join);
+    init_flow.setCurrent(join);
 }
 
 /**
@@ -475,8 +814,21 @@ void SemanticChecker::checkIfStmt(const IfStmtPtr& p_istmt)
  */
 void SemanticChecker::checkWhileStmt(const WhileStmtPtr& p_wstmt)
 {
+    // pre -> head -> body -> head，head -> exit；条件在 head 中求值
+    auto head = init_flow.newBlock();
+    init_flow.addEdge(init_flow.current(), head);
+    init_flow.setCurrent(head);
     checkExprStmt(std::make_shared<ExprStmt>(p_wstmt->expr));
+
+    auto body = init_flow.newBlock();
+    init_flow.addEdge(head, body);
+    init_flow.setCurrent(body);
     checkBlockStmt(p_wstmt->block);
+    init_flow.addEdge(init_flow.current(), head);
+
+    auto exit = init_flow.newBlock();
+    init_flow.addEdge(head, exit);
+    init_flow.setCurrent(exit);
 }
 
 }  // namespace semantic
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
+#include "call_graph.hpp"
+#include "const_evaluator.hpp"
+#include "const_folder.hpp"
+#include "err_report/diagnostic_sink.hpp"
 #include "err_report/error_reporter.hpp"
+#include "init_analysis.hpp"
 #include "parser/ast.hpp"
 #include "symbol_table.hpp"
+#include "type_inference.hpp"
+#include "util/position.hpp"
 
 namespace semantic
 {
@@ -17,11 +29,30 @@ class SemanticChecker
 
     void setErrorReporter(std::shared_ptr<error::ErrorReporter> p_ereporter);
     void setSymbolTable(std::shared_ptr<symbol::SymbolTable> p_stable);
+    void setJobs(std::size_t jobs);
 
    public:
-    void checkProg(const parser::ast::ProgPtr& p_prog);
+    // 函数体检查完成后按源码顺序在调用线程上执行的回调，
+    // 参数为函数下标、函数声明及只含该函数作用域子树的子表
+    using FuncHandler = std::function<void(std::size_t, const parser::ast::FuncDeclPtr&,
+                                           const std::shared_ptr<symbol::SymbolTable>&)>;
+    // 函数体检查完成后立即在工作线程上执行的回调，参数为函数下标与函数声明。
+    // 此时函数的作用域子树仍然存在，各函数的回调可能并发执行
+    using FuncWorker = std::function<void(std::size_t, const parser::ast::FuncDeclPtr&)>;
+
+    void checkProg(const parser::ast::ProgPtr& p_prog, const FuncHandler& on_func = {},
+                   const FuncWorker& on_checked = {});
+
+    // 已发现的语义错误数，并行检查时可在 on_func 中调用，用于提前放弃后续输出
+    [[nodiscard]]
+    auto errorCount() const -> std::size_t;
+
+    // 第一遍检查后即可使用，on_func 中也可调用
+    [[nodiscard]]
+    auto getCallGraph() const -> const CallGraph& { return *p_call_graph; }
 
    private:
+    void declareFuncHeader(const parser::ast::FuncHeaderDeclPtr& p_fhdecl);
     void checkFuncDecl(const parser::ast::FuncDeclPtr& p_fdecl);
     void checkFuncHeaderDecl(const parser::ast::FuncHeaderDeclPtr& p_fhdecl);
     auto checkBlockStmt(const parser::ast::BlockStmtPtr& p_bstmt) -> bool;
@@ -39,9 +70,56 @@ class SemanticChecker
     void checkIfStmt(const parser::ast::IfStmtPtr& p_istmt);
     void checkWhileStmt(const parser::ast::WhileStmtPtr& p_wstmt);
 
+    auto rvalueVar(const parser::ast::ExprPtr& p_expr) const -> symbol::VariablePtr;
+    auto occurrencePos(const parser::ast::Variable* p_node) -> util::Position;
+    void skipOccurrences(const parser::ast::ExprPtr& p_expr);
+    void recordUntypedVars(std::size_t first);
+    void reportDeferredErrs();
+
    private:
+    // 变量的一次使用，在函数体检查完成后用于报告未初始化错误
+    struct VarUse
+    {
+        parser::ast::Variable* p_node;  // AST 中的变量结点
+        util::Position pos;             // 本次使用的位置 (共享结点的位置只是第一次出现处)
+        symbol::ScopeId scope;          // 使用处所在的作用域
+        std::size_t err_slot;  // 使用时已报告的语义错误数，错误按该位置插入以保持报告顺序
+    };
+
+    // 要等类型推导完成后才能进行的类型检查
+    struct TypeCheck
+    {
+        enum class Kind : std::uint8_t
+        {
+            Inferred,  // 语句块结束处，块中未标注类型的变量须能推导出类型
+            Return,    // return 语句返回的变量须与函数返回类型一致
+        };
+
+        Kind kind;
+        symbol::VariablePtr p_var;
+        util::Position pos;     // 报错位置
+        symbol::ScopeId scope;  // 报错时的作用域
+        std::size_t err_slot;   // 检查处已报告的语义错误数
+        std::size_t use_cnt;    // 检查处已记录的变量使用数，用于与未初始化错误排序
+    };
+
     std::shared_ptr<symbol::SymbolTable> p_stable;
     std::shared_ptr<error::ErrorReporter> p_ereporter;
+    std::size_t jobs = 1;  // 并行检查函数体的线程数
+
+    InitAnalysis init_flow;        // 当前函数的确定初始化分析
+    std::vector<VarUse> var_uses;  // 当前函数中的变量使用，下标即 InitAnalysis::UseId
+
+    const parser::ast::OccurrenceTable* p_occurrences = nullptr;  // 当前函数共享结点的出现位置
+    std::unordered_map<const parser::ast::Node*, std::size_t> visit_cnt;  // 共享结点已访问次数
+
+    TypeInference type_infer;                       // 当前函数的局部类型推导
+    std::vector<symbol::VariablePtr> untyped_vars;  // 正在检查的语句块中未标注类型的变量
+    std::vector<TypeCheck> type_checks;             // 当前函数中待确认类型的变量
+
+    std::shared_ptr<error::DiagnosticSink> p_diag;       // 各线程检查函数体时的错误
+    std::shared_ptr<const CallGraph> p_call_graph;       // 函数调用图
+    std::shared_ptr<const ConstEvaluator> p_const_eval;  // 纯函数的编译期求值，各线程共享
 };
 
 }  // namespace semantic
@@ -0,0 +1,148 @@
+#include "symbol_interface.hpp"
+
+#include <array>
+#include <stdexcept>
+
+namespace symbol
+{
+
+static constexpr std::array<char, 4> MAGIC{'S', 'Y', 'M', 'I'};
+static constexpr std::uint32_t VERSION = 1;
+static constexpr std::uint32_t MAX_NAME_LEN = 1U << 16;  // 读入时的函数名长度上限，防止损坏的文件
+
+/**
+ * @brief  计算文本的 64 位 FNV-1a 哈希
+ * @param  text 文本
+ * @return 哈希值
+ */
+auto contentHash(std::string_view text) -> std::uint64_t
+{
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief 以小端序写出无符号整数
+ * @param out   输出流
+ * @param value 整数值
+ */
+template <typename T>
+static void writeUint(std::ostream& out, T value)
+{
+    std::array<char, sizeof(T)> bytes{};
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+    {
+        bytes[i] = static_cast<char>(value >> (8 * i) & 0xff);
+    }
+    out.write(bytes.data(), bytes.size());
+}
+
+/**
+ * @brief  以小端序读入无符号整数
+ * @param  in 输入流
+ * @return 整数值
+ */
+template <typename T>
+static auto readUint(std::istream& in) -> T
+{
+    std::array<char, sizeof(T)> bytes{};
+    if (!in.read(bytes.data(), bytes.size()))
+    {
+        throw std::runtime_error{"symbol interface file is truncated"};
+    }
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+    {
+        value |= static_cast<T>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief 写出符号接口文件
+ * @param out   输出流 (二进制模式)
+ * @param iface 源文件接口
+ */
+void writeInterface(std::ostream& out, const Interface& iface)
+{
+    out.write(MAGIC.data(), MAGIC.size());
+    writeUint<std::uint32_t>(out, VERSION);
+    writeUint<std::uint64_t>(out, iface.source_hash);
+    writeUint<std::uint32_t>(out, iface.funcs.size());
+    for (const auto& func : iface.funcs)
+    {
+        writeUint<std::uint32_t>(out, func.name.size());
+        out.write(func.name.data(), static_cast<std::streamsize>(func.name.size()));
+        writeUint<std::uint32_t>(out, func.argc);
+        writeUint<std::uint8_t>(out, static_cast<std::uint8_t>(func.retval_type));
+        writeUint<std::uint64_t>(out, func.hash);
+    }
+}
+
+/**
+ * @brief  读入符号接口文件
+ * @param  in 输入流 (二进制模式)
+ * @return 源文件接口
+ */
+auto readInterface(std::istream& in) -> Interface
+{
+    std::array<char, 4> magic{};
+    if (!in.read(magic.data(), magic.size()) || magic != MAGIC)
+    {
+        throw std::runtime_error{"not a symbol interface file"};
+    }
+    if (readUint<std::uint32_t>(in) != VERSION)
+    {
+        throw std::runtime_error{"unsupported symbol interface version"};
+    }
+
+    Interface iface;
+    iface.source_hash = readUint<std::uint64_t>(in);
+    auto count = readUint<std::uint32_t>(in);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        FuncInterface func;
+        auto name_len = readUint<std::uint32_t>(in);
+        if (name_len > MAX_NAME_LEN)
+        {
+            throw std::runtime_error{"invalid function name in symbol interface file"};
+        }
+        func.name.resize(name_len);
+        if (!in.read(func.name.data(), static_cast<std::streamsize>(func.name.size())))
+        {
+            throw std::runtime_error{"symbol interface file is truncated"};
+        }
+        func.argc = static_cast<int>(readUint<std::uint32_t>(in));
+        auto rvt = readUint<std::uint8_t>(in);
+        if (rvt > static_cast<std::uint8_t>(VarType::Unknown))
+        {
+            throw std::runtime_error{"invalid return type in symbol interface file"};
+        }
+        func.retval_type = static_cast<VarType>(rvt);
+        func.hash = readUint<std::uint64_t>(in);
+        iface.funcs.push_back(std::move(func));
+    }
+    return iface;
+}
+
+/**
+ * @brief 将接口中的函数声明到符号表，之后对这些函数的调用按其签名检查
+ * @param table 符号表
+ * @param iface 其他源文件的接口
+ */
+void importInterface(SymbolTable& table, const Interface& iface)
+{
+    for (const auto& func : iface.funcs)
+    {
+        auto p_func = table.createFunction(func.name, func.argc, func.retval_type);
+        p_func->imported = true;
+        table.declareFunc(func.name, p_func);
+    }
+}
+
+}  // namespace symbol
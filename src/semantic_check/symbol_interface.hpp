@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "symbol_table.hpp"
+
+namespace symbol
+{
+
+// 符号接口文件 (.symi)
+// 记录一个源文件中所有函数的签名，供其他文件分别编译时解析对这些函数的调用，
+// 无需重新词法分析、语法分析与语义检查该文件。源文件哈希用于判断文件是否改动，
+// 函数哈希用于判断单个函数是否改动。
+//
+// 文件格式 (整数均为小端序)：
+//   magic "SYMI" | version: u32 | source_hash: u64 | count: u32
+//   count 个函数：name_len: u32 | name | argc: u32 | retval_type: u8 | hash: u64
+
+// 接口中的一个函数
+struct FuncInterface
+{
+    std::string name;
+    int argc;
+    VarType retval_type;
+    std::uint64_t hash;  // 函数源码的哈希
+};
+
+// 一个源文件的接口
+struct Interface
+{
+    std::uint64_t source_hash = 0;  // 整个源文件的哈希
+    std::vector<FuncInterface> funcs;
+};
+
+auto contentHash(std::string_view text) -> std::uint64_t;
+
+void writeInterface(std::ostream& out, const Interface& iface);
+auto readInterface(std::istream& in) -> Interface;
+
+void importInterface(SymbolTable& table, const Interface& iface);
+
+}  // namespace symbol
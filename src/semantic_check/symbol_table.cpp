@@ -1,13 +1,105 @@
 #include "symbol_table.hpp"
 
 #include <cassert>
-#include <regex>
-#include <sstream>
 #include <stdexcept>
 
 namespace symbol
 {
 
+SymbolTable::SymbolTable(const SymbolTable* p_parent)
+    : p_parent(p_parent), p_own(storages.emplace_back(std::make_unique<Storage>()).get())
+{
+    scopes.emplace_back(std::string{GLOBAL_SCOPE}, std::string{GLOBAL_SCOPE}, 0, NO_SCOPE, 0,
+                        NO_FUNC);
+}
+
+/**
+ * @brief  在对象池中创建整型变量符号
+ * @param  name   变量名
+ * @param  formal 是否为形参
+ * @param  val    初值
+ * @return 变量符号指针
+ */
+auto SymbolTable::createInteger(std::string name, bool formal, std::optional<std::int32_t> val)
+    -> IntegerPtr
+{
+    return p_own->integer_pool.create(std::move(name), formal, val);
+}
+
+/**
+ * @brief  在对象池中创建变量符号
+ * @param  name   变量名
+ * @param  formal 是否为形参
+ * @param  vt     变量类型
+ * @return 变量符号指针
+ */
+auto SymbolTable::createVariable(std::string name, bool formal, VarType vt) -> VariablePtr
+{
+    return p_own->variable_pool.create(std::move(name), formal, vt);
+}
+
+/**
+ * @brief  在对象池中创建函数符号
+ * @param  name 函数名
+ * @param  argc 参数个数
+ * @param  rvt  返回值类型
+ * @return 函数符号指针
+ */
+auto SymbolTable::createFunction(std::string name, int argc, VarType rvt) -> FunctionPtr
+{
+    return p_own->function_pool.create(std::move(name), argc, rvt);
+}
+
+/**
+ * @brief  创建子表，用于独立检查一个函数体
+ * @return 子表，只含 global 作用域，函数符号从本表中查找
+ */
+auto SymbolTable::makeSubtable() const -> std::shared_ptr<SymbolTable>
+{
+    return std::shared_ptr<SymbolTable>{new SymbolTable{this}};
+}
+
+/**
+ * @brief   将子表中的作用域子树并入本表的 global 作用域下
+ * @details 子表的存储整体转移到本表，其中的符号指针在并入后依然有效
+ * @param   sub 子表
+ */
+void SymbolTable::mergeSubtable(SymbolTable&& sub)
+{
+    assert(sub.p_parent == this && sub.scopes.front().vars.empty());
+
+    // 子表中编号为 id (id >= 1) 的作用域在本表中的编号为 id + offset，子表的 global 即本表的 global
+    auto offset = static_cast<ScopeId>(scopes.size() - 1);
+    auto storage_offset = static_cast<std::uint32_t>(storages.size());
+
+    for (auto& storage : sub.storages)
+    {
+        storages.push_back(std::move(storage));
+    }
+
+    for (std::size_t id = 1; id < sub.scopes.size(); ++id)
+    {
+        auto& scope = sub.scopes[id];
+        scope.parent = scope.parent == 0 ? 0 : scope.parent + offset;
+        scope.storage += storage_offset;
+        for (auto& [name, child] : scope.children)
+        {
+            child += offset;
+        }
+        scopes.push_back(std::move(scope));
+    }
+
+    for (const auto& [name, child] : sub.scopes.front().children)
+    {
+        scopes.front().children[name] = child + offset;
+    }
+
+    sub.storages.clear();
+    sub.scopes.erase(sub.scopes.begin() + 1, sub.scopes.end());
+    sub.scopes.front().children.clear();
+    sub.cscope = 0;
+}
+
 /**
  * @brief 进入作用域
  * @param name         作用域限定符
@@ -15,25 +107,29 @@ namespace symbol
  */
 void SymbolTable::enterScope(const std::string& name, bool create_scope)
 {
-    std::ostringstream oss;
-    oss << cscope_name << "::" << name;
-
     if (!create_scope)
     {
-        assert(scopes.contains(oss.str()));
-        cscope_name = oss.str();
-        p_cscope = scopes[cscope_name];
+        auto& children = scopes[cscope].children;
+        assert(children.contains(name));
+        cscope = children.find(name)->second;
         return;
     }
 
-    if (scopes.contains(name))
-    {
-        throw std::runtime_error{"scope already exists"};
-    }
-
-    cscope_name = oss.str();
-    p_cscope = std::make_shared<Scope>();
-    scopes[cscope_name] = p_cscope;
+    auto id = static_cast<ScopeId>(scopes.size());
+    const auto& parent = scopes[cscope];
+    std::string full_name;
+    full_name.reserve(parent.name.size() + 2 + name.size());
+    full_name.append(parent.name).append("::").append(name);
+    auto label = makeScopeLabel(parent.label, name);
+    // global 的直接子作用域即函数作用域，更深的作用域沿用父作用域所属的函数
+    auto func = parent.parent == NO_SCOPE ? p_own->names.intern(name) : parent.func;
+    auto storage = parent.parent == NO_SCOPE ? 0 : parent.storage;
+    auto local_pos = parent.name.size() + 2;
+
+    // 同名作用域 (如重复定义的函数) 以新建的为准
+    scopes[cscope].children[name] = id;
+    scopes.emplace_back(std::move(full_name), std::move(label), local_pos, cscope, storage, func);
+    cscope = id;
 }
 
 /**
@@ -42,21 +138,14 @@ void SymbolTable::enterScope(const std::string& name, bool create_scope)
  */
 auto SymbolTable::exitScope() -> std::string
 {
-    std::size_t idx = cscope_name.find_last_of(':');
-    if (idx >= cscope_name.length())
+    const auto& scope = scopes[cscope];
+    if (scope.parent == NO_SCOPE)
     {
         throw std::runtime_error{"can't exit scope"};
     }
 
-    std::string name = cscope_name.substr(idx + 1);
-    cscope_name = cscope_name.substr(0, idx - 1);
-    if (!scopes.contains(cscope_name))
-    {
-        throw std::runtime_error{"can't find the upper-level scope"};
-    }
-    p_cscope = scopes[cscope_name];
-
-    return name;
+    cscope = scope.parent;
+    return scope.name.substr(scope.local_pos);
 }
 
 /**
@@ -66,12 +155,13 @@ auto SymbolTable::exitScope() -> std::string
  */
 void SymbolTable::declareFunc(const std::string& fname, FunctionPtr p_func)
 {
-    if (funcs.contains(fname))
+    auto id = p_own->names.intern(fname);
+    if (funcs.find(id) != nullptr)
     {
         throw std::runtime_error{"function name already exists"};
     }
 
-    funcs[fname] = std::move(p_func);
+    funcs.insertOrAssign(id, p_func);
 }
 
 /**
@@ -86,7 +176,8 @@ void SymbolTable::declareVar(const std::string& vname, VariablePtr p_var)
     //     throw std::runtime_error{"variable name already exists"};
     // }
 
-    (*p_cscope)[vname] = std::move(p_var);
+    auto& scope = scopes[cscope];
+    scope.vars.insertOrAssign(storages[scope.storage]->names.intern(vname), p_var);
 }
 
 /**
@@ -97,9 +188,19 @@ void SymbolTable::declareVar(const std::string& vname, VariablePtr p_var)
 [[nodiscard]]
 auto SymbolTable::lookupFunc(const std::string& name) const -> std::optional<FunctionPtr>
 {
-    if (funcs.contains(name))
+    if (p_parent != nullptr)
+    {
+        return p_parent->lookupFunc(name);
+    }
+
+    auto id = p_own->names.find(name);
+    if (!id.has_value())
+    {
+        return std::nullopt;
+    }
+    if (const auto* p_func = funcs.find(id.value()); p_func != nullptr)
     {
-        return funcs.find(name)->second;
+        return *p_func;
     }
     return std::nullopt;
 }
@@ -112,33 +213,34 @@ auto SymbolTable::lookupFunc(const std::string& name) const -> std::optional<Fun
 [[nodiscard]]
 auto SymbolTable::lookupVar(const std::string& name) const -> std::optional<VariablePtr>
 {
-    auto exit_scope = [](std::string& scope_name) -> bool
+    // 同一函数内的作用域共用一个驻留表，只在驻留表变化时重新查找名字的编号；
+    // 从未声明过的名字不在驻留表中，该驻留表对应的作用域都可以跳过
+    std::optional<util::StringInterner::Id> name_id;
+    const util::StringInterner* p_names = nullptr;
+
+    for (ScopeId id = cscope; id != NO_SCOPE; id = scopes[id].parent)
     {
-        std::size_t idx = scope_name.find_last_of(':');
-        if (idx >= scope_name.length())
+        const auto& scope = scopes[id];
+        if (scope.vars.empty())
         {
-            return false;
+            continue;
         }
-        scope_name = scope_name.substr(0, idx - 1);
-        return true;
-    };
-
-    auto scope_name = cscope_name;
-
-    bool flag = false;
-    VariablePtr p_var;
-    do
-    {
-        auto p_scope = scopes.find(scope_name)->second;
-        if (p_scope->contains(name))
+        if (p_names != &names(scope))
+        {
+            p_names = &names(scope);
+            name_id = p_names->find(name);
+        }
+        if (!name_id.has_value())
+        {
+            continue;
+        }
+        if (const auto* p_var = scope.vars.find(name_id.value()); p_var != nullptr)
         {
-            flag = true;
-            p_var = p_scope->find(name)->second;
-            break;
+            return *p_var;
         }
-    } while (exit_scope(scope_name));
+    }
 
-    return flag ? std::optional<VariablePtr>{p_var} : std::nullopt;
+    return std::nullopt;
 }
 
 /**
@@ -167,27 +269,45 @@ static auto varType2Str(VarType vt) -> std::string
  * @brief 打印符号表
  * @param out 输出流
  */
-void SymbolTable::printSymbol(std::ofstream& out)
+void SymbolTable::printSymbol(std::ofstream& out) const
+{
+    printFuncSymbols(out);
+    printVarSymbols(out);
+}
+
+/**
+ * @brief 打印函数符号，以及变量符号部分的标题 (变量符号随后由 printVarSymbols 输出)
+ * @param out 输出流
+ */
+void SymbolTable::printFuncSymbols(std::ofstream& out) const
 {
     out << "搜集到如下函数符号：" << std::endl;
 
-    for (const auto& func : funcs)
+    for (const auto& [id, p_func] : funcs)
     {
-        out << "函数名：" << func.first << "，参数个数：" << func.second->argc << "，返回值类型："
-            << varType2Str(func.second->retval_type) << std::endl;
+        if (p_func->imported)
+        {  // 只输出本文件中定义的函数
+            continue;
+        }
+        out << "函数名：" << p_own->names.str(id) << "，参数个数：" << p_func->argc
+            << "，返回值类型：" << varType2Str(p_func->retval_type) << std::endl;
     }
 
     out << "搜集到如下变量符号：" << std::endl;
+}
 
+/**
+ * @brief 按作用域的创建顺序打印本表中的变量符号
+ * @param out 输出流
+ */
+void SymbolTable::printVarSymbols(std::ofstream& out) const
+{
     for (const auto& scope : scopes)
     {
-        auto scope_name = scope.first;
-        auto p_scope = scope.second;
-
-        for (const auto& var : *p_scope)
+        for (const auto& [id, p_var] : scope.vars)
         {
-            out << "变量名：" << scope_name << "::" << var.first << "，类型："
-                << varType2Str(var.second->var_type) << std::endl;
+            out << "变量名：" << scope.name << "::" << names(scope).str(id) << "，类型："
+                << varType2Str(p_var->var_type) << std::endl;
         }
     }
 }
@@ -198,47 +318,42 @@ void SymbolTable::printSymbol(std::ofstream& out)
  */
 auto SymbolTable::getCurScope() const -> const std::string&
 {
-    return cscope_name;
+    return scopes[cscope].name;
 }
 
 /**
- * @brief 取变量名
- * @return 变量全名，含作用域
+ * @brief 取作用域标签前缀
+ * @return 作用域全名中的 "::" 替换为 "_" 后的结果，用于生成跳转标签
  */
-auto SymbolTable::getTempValName() -> std::string
+auto SymbolTable::getCurScopeLabel() const -> const std::string&
 {
-    return std::format("t{}", tv_cnt++);
+    return scopes[cscope].label;
 }
 
 /**
- * @brief 取函数名
- * @return 函数名，不含global
- */
-auto SymbolTable::getFuncName() -> std::string
+ * @brief  由父作用域的标签前缀得出子作用域的标签前缀
+ * @param  parent_label 父作用域的标签前缀
+ * @param  name         子作用域名
+ * @return "父标签_子作用域名"；函数作用域即 "global_函数名"，中间代码的标号都以此为前缀
+ */
+auto SymbolTable::makeScopeLabel(std::string_view parent_label, std::string_view name)
+    -> std::string
 {
-    std::regex re{R"(^global::(\w+))"};
-    std::smatch match;
-    std::regex_search(cscope_name, match, re);
-    return match[1];
+    std::string label;
+    label.reserve(parent_label.size() + 1 + name.size());
+    label.append(parent_label).append("_").append(name);
+    return label;
 }
 
 /**
- * @brief 检查作用域下变量是否有类型
- * @return 未定义类型变量
+ * @brief 取当前作用域所属的函数名
+ * @return 函数名，不含global；位于 global 时为空串
  */
-auto SymbolTable::checkAutoTypeInference() const -> std::vector<VariablePtr>
+auto SymbolTable::getFuncName() const -> const std::string&
 {
-    std::vector<VariablePtr> failed_vars;
-
-    for (const auto& [name, p_var] : *p_cscope)
-    {
-        if (p_var->var_type == VarType::Unknown)
-        {
-            failed_vars.push_back(p_var);
-        }
-    }
-
-    return failed_vars;
+    static const std::string none;
+    const auto& scope = scopes[cscope];
+    return scope.func == NO_FUNC ? none : names(scope).str(scope.func);
 }
 
 }  // namespace symbol
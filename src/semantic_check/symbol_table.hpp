@@ -5,10 +5,14 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "util/id_map.hpp"
 #include "util/position.hpp"
+#include "util/slab_pool.hpp"
+#include "util/string_interner.hpp"
 
 namespace symbol
 {
@@ -25,7 +29,7 @@ struct Symbol
     explicit Symbol(std::string n) : name(std::move(n)) {}
     virtual ~Symbol() = default;
 };
-using SymbolPtr = std::shared_ptr<Symbol>;
+using SymbolPtr = Symbol*;  // 符号由 SymbolTable 的对象池持有
 
 enum class VarType : std::uint8_t
 {
@@ -48,8 +52,8 @@ struct Variable : Symbol
 {
     // bool mut = true;                      // 变量本身是否可变
     // RefType ref_type = RefType::Normal;   // 若为引用变量，是否允许改变引用对象
-    bool initialized = false;  // 是否已经初始化
     bool formal = false;
+    std::uint32_t local_id = 0;  // 变量在所属函数中的编号，用于函数内的数据流分析
     VarType var_type = VarType::I32;  // 变量类型
 
     Variable() = default;
@@ -59,7 +63,7 @@ struct Variable : Symbol
     }
     ~Variable() override = default;
 };
-using VariablePtr = std::shared_ptr<Variable>;
+using VariablePtr = Variable*;
 
 struct Integer : Variable
 {
@@ -71,12 +75,13 @@ struct Integer : Variable
     }
     ~Integer() override = default;
 };
-using IntegerPtr = std::shared_ptr<Integer>;
+using IntegerPtr = Integer*;
 
 struct Function : Symbol
 {
     int argc;  // 参数个数 -- 基本规则中，不涉及到不可变参数及非 i32 类型变量，因此只需记录参数个数
     VarType retval_type;
+    bool imported = false;  // 是否由其他源文件的符号接口导入
 
     Function() : argc(0), retval_type(VarType::Null) {}
     Function(std::string n, int argc, VarType rvt)
@@ -86,20 +91,34 @@ struct Function : Symbol
 
     void setRetvalType(VarType rvt) { retval_type = rvt; }
 };
-using FunctionPtr = std::shared_ptr<Function>;
+using FunctionPtr = Function*;
 
+// 作用域编号，即作用域在作用域树中的下标
+using ScopeId = std::uint32_t;
+inline constexpr ScopeId NO_SCOPE = static_cast<ScopeId>(-1);  // global 的父作用域
+
+// 符号表
+// 函数体可以在各自的子表 (makeSubtable) 中并行检查：子表只持有一棵函数作用域子树，
+// 函数符号从父表中查找；检查完成后由 mergeSubtable 按源码顺序并入父表
 class SymbolTable
 {
    public:
-    SymbolTable()
-    {
-        p_cscope = std::make_shared<Scope>();
-        cscope_name = "global";
-        scopes[cscope_name] = p_cscope;
-    }
+    SymbolTable() : SymbolTable(nullptr) {}
+    SymbolTable(const SymbolTable&) = delete;
+    auto operator=(const SymbolTable&) -> SymbolTable& = delete;
     ~SymbolTable() = default;
 
    public:
+    // 符号统一在符号表的对象池中创建，生命周期与符号表相同
+    auto createInteger(std::string name, bool formal, std::optional<std::int32_t> val)
+        -> IntegerPtr;
+    auto createVariable(std::string name, bool formal, VarType vt) -> VariablePtr;
+    auto createFunction(std::string name, int argc, VarType rvt) -> FunctionPtr;
+
+    [[nodiscard]]
+    auto makeSubtable() const -> std::shared_ptr<SymbolTable>;
+    void mergeSubtable(SymbolTable&& sub);
+
     void enterScope(const std::string& name, bool create_scope = true);
     auto exitScope() -> std::string;
 
@@ -113,26 +132,80 @@ class SymbolTable
     [[nodiscard]]
     auto lookupVar(const std::string& name) const -> std::optional<VariablePtr>;
 
-    void printSymbol(std::ofstream& out);
+    void printSymbol(std::ofstream& out) const;
+    void printFuncSymbols(std::ofstream& out) const;
+    void printVarSymbols(std::ofstream& out) const;
 
     auto getCurScope() const -> const std::string&;
+    auto getCurScopeId() const -> ScopeId { return cscope; }
+    auto getScopeName(ScopeId id) const -> const std::string& { return scopes[id].name; }
+
+    auto getCurScopeLabel() const -> const std::string&;
+    static auto makeScopeLabel(std::string_view parent_label, std::string_view name)
+        -> std::string;
 
-    auto getTempValName() -> std::string;
+    static constexpr std::string_view GLOBAL_SCOPE = "global";  // 全局作用域的名字与标签前缀
 
-    auto getFuncName() -> std::string;
+    auto getFuncName() const -> const std::string&;
 
-    auto checkAutoTypeInference() const -> std::vector<VariablePtr>;
+   private:
+    explicit SymbolTable(const SymbolTable* p_parent);
 
    private:
-    using Scope = std::unordered_map<std::string, VariablePtr>;
-    using ScopePtr = std::shared_ptr<Scope>;
-    ScopePtr p_cscope;        // pointer (current scope)
-    std::string cscope_name;  // 作用域限定符
+    static constexpr util::StringInterner::Id NO_FUNC = static_cast<util::StringInterner::Id>(-1);
+
+    // 名字与符号的存储，子表并入父表时整体转移，符号地址保持不变
+    struct Storage
+    {
+        util::StringInterner names;  // 变量名与函数名的驻留表
+        util::SlabPool<Integer> integer_pool;
+        util::SlabPool<Variable> variable_pool;
+        util::SlabPool<Function> function_pool;
+    };
+
+    // 作用域树的结点，通过父作用域编号向上查找变量
+    // 所属函数与标签前缀在创建作用域时一并确定，之后的查询无需再解析作用域全名
+    struct Scope
+    {
+        std::string name;               // 作用域全名 (如 global::f::if1)
+        std::string label;              // 作用域全名中的 "::" 替换为 "_" 后的标签前缀
+        std::size_t local_pos;          // 本层作用域名在全名中的起始位置
+        ScopeId parent;                 // 父作用域
+        std::uint32_t storage;          // 驻留变量名与函数名所用的存储
+        util::StringInterner::Id func;  // 所属函数名的驻留编号，global 为 NO_FUNC
+        util::IdMap<VariablePtr> vars;  // 本作用域中声明的变量，键为驻留后的变量名
+        std::unordered_map<std::string, ScopeId> children;  // 本层作用域名 -> 子作用域
+
+        Scope(std::string name, std::string label, std::size_t local_pos, ScopeId parent,
+              std::uint32_t storage, util::StringInterner::Id func)
+            : name(std::move(name)),
+              label(std::move(label)),
+              local_pos(local_pos),
+              parent(parent),
+              storage(storage),
+              func(func)
+        {
+        }
+    };
+
+    [[nodiscard]]
+    auto names(const Scope& scope) const -> const util::StringInterner&
+    {
+        return storages[scope.storage]->names;
+    }
+
+    ScopeId cscope = 0;  // current scope
+
+    const SymbolTable* p_parent;  // 子表所属的父表，只用于查找函数
+
+    std::vector<Scope> scopes;       // 作用域树，按创建顺序存放，下标即作用域编号
+    util::IdMap<FunctionPtr> funcs;  // 键为在 p_own 中驻留后的函数名
 
-    int tv_cnt;  // temp value counter
+    std::vector<std::unique_ptr<Storage>> storages;  // 作用域所用的存储，由 Scope::storage 索引
 
-    std::unordered_map<std::string, ScopePtr> scopes;
-    std::unordered_map<std::string, FunctionPtr> funcs;
+    // 本表创建符号所用的存储 (即 storages[0])。并入子表只会向 storages 追加元素，
+    // 子表并发查找函数时经由该指针访问，不会读取正在变化的 storages
+    Storage* p_own;
 };
 
 }  // namespace symbol
@@ -0,0 +1,94 @@
+#include "type_inference.hpp"
+
+#include <cassert>
+
+namespace semantic
+{
+
+/**
+ * @brief 清空已登记的变量与约束
+ */
+void TypeInference::reset()
+{
+    vars.clear();
+    flows.clear();
+}
+
+/**
+ * @brief 登记局部变量，须按 local_id 递增的顺序调用
+ * @param p_var 变量符号指针
+ */
+void TypeInference::addVar(symbol::VariablePtr p_var)
+{
+    assert(p_var->local_id == vars.size());
+    vars.push_back(p_var);
+}
+
+/**
+ * @brief 记录约束：p_dst 的类型由 p_src 的类型确定
+ * @param p_src 赋值右侧的变量
+ * @param p_dst 赋值左侧的变量
+ */
+void TypeInference::addFlow(symbol::VariablePtr p_src, symbol::VariablePtr p_dst)
+{
+    flows.push_back(Flow{p_src->local_id, p_dst->local_id});
+}
+
+/**
+ * @brief   沿约束边传播类型，结果直接写回变量符号
+ * @details 约束边先按起点分桶，工作表初始为所有已知类型的变量。出表的变量将类型传给
+ *          类型仍未知的后继并使其入表，每个变量至多入表一次，总时间与变量数和约束数成线性。
+ *          一个变量有多条入边时，以最先传播到的类型为准；传播结束后仍为 Unknown 的变量
+ *          即无法推导出类型
+ */
+void TypeInference::solve()
+{
+    if (flows.empty())
+    {
+        return;
+    }
+
+    // 计数排序，得到按起点分桶的后继表：succs[first[v], first[v + 1]) 为 v 的后继
+    std::vector<std::uint32_t> first(vars.size() + 1, 0);
+    for (const auto& flow : flows)
+    {
+        ++first[flow.src + 1];
+    }
+    for (std::size_t v = 0; v < vars.size(); ++v)
+    {
+        first[v + 1] += first[v];
+    }
+    std::vector<VarId> succs(flows.size());
+    auto next = first;
+    for (const auto& flow : flows)
+    {
+        succs[next[flow.src]++] = flow.dst;
+    }
+
+    std::vector<VarId> worklist;
+    for (VarId v = 0; v < vars.size(); ++v)
+    {
+        if (vars[v]->var_type != symbol::VarType::Unknown)
+        {
+            worklist.push_back(v);
+        }
+    }
+
+    while (!worklist.empty())
+    {
+        auto v = worklist.back();
+        worklist.pop_back();
+
+        for (auto i = first[v]; i < first[v + 1]; ++i)
+        {
+            auto* p_dst = vars[succs[i]];
+            if (p_dst->var_type == symbol::VarType::Unknown)
+            {
+                p_dst->var_type = vars[v]->var_type;
+                worklist.push_back(succs[i]);
+            }
+        }
+    }
+}
+
+}  // namespace semantic
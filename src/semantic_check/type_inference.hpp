@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "symbol_table.hpp"
+
+namespace semantic
+{
+
+// 函数内的局部类型推导
+// 语义检查遍历函数体时，形如 x = y 且两侧类型都还未知的赋值记为一条 y -> x 的约束边；
+// 右侧类型已知时直接确定左侧类型，不产生约束。函数体检查完成后从所有已知类型的变量出发，
+// 沿约束边以工作表传播类型，每条边至多处理一次
+class TypeInference
+{
+   public:
+    using VarId = std::uint32_t;  // 局部变量编号，与 Variable::local_id 一致
+
+   public:
+    void reset();
+
+    void addVar(symbol::VariablePtr p_var);
+    void addFlow(symbol::VariablePtr p_src, symbol::VariablePtr p_dst);
+
+    void solve();
+
+   private:
+    struct Flow
+    {
+        VarId src;
+        VarId dst;
+    };
+
+    std::vector<symbol::VariablePtr> vars;  // 下标为局部变量编号
+    std::vector<Flow> flows;                // 约束边，按记录顺序存放
+};
+
+}  // namespace semantic
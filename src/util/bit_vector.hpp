@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace util
+{
+
+// 定长的稠密位向量，按 64 位字存放，集合运算逐字进行
+class BitVector
+{
+   public:
+    BitVector() = default;
+
+    /**
+     * @brief 构造位向量
+     * @param n     位数
+     * @param value 所有位的初值
+     */
+    explicit BitVector(std::size_t n, bool value = false)
+        : words((n + 63) / 64, value ? ~std::uint64_t{0} : 0), nbits(n)
+    {
+        clearPadding();
+    }
+
+   public:
+    [[nodiscard]] auto size() const -> std::size_t { return nbits; }
+
+    [[nodiscard]] auto test(std::size_t i) const -> bool
+    {
+        return (words[i / 64] >> (i % 64) & 1U) != 0;
+    }
+
+    void set(std::size_t i) { words[i / 64] |= std::uint64_t{1} << (i % 64); }
+    void reset(std::size_t i) { words[i / 64] &= ~(std::uint64_t{1} << (i % 64)); }
+
+    /**
+     * @brief  求交集并赋给自身
+     * @param  other 位数相同的位向量
+     * @return 自身是否发生变化
+     */
+    auto intersectWith(const BitVector& other) -> bool
+    {
+        bool changed = false;
+        for (std::size_t i = 0; i < words.size(); ++i)
+        {
+            auto w = words[i] & other.words[i];
+            changed |= w != words[i];
+            words[i] = w;
+        }
+        return changed;
+    }
+
+    /**
+     * @brief 求并集并赋给自身
+     * @param other 位数相同的位向量
+     */
+    void unionWith(const BitVector& other)
+    {
+        for (std::size_t i = 0; i < words.size(); ++i)
+        {
+            words[i] |= other.words[i];
+        }
+    }
+
+    /**
+     * @brief 去掉 other 中置位的位 (差集)
+     * @param other 位数相同的位向量
+     */
+    void subtract(const BitVector& other)
+    {
+        for (std::size_t i = 0; i < words.size(); ++i)
+        {
+            words[i] &= ~other.words[i];
+        }
+    }
+
+    auto operator==(const BitVector& other) const -> bool = default;
+
+   private:
+    // 最后一个字中超出 nbits 的位保持为 0，保证相等比较只取决于有效位
+    void clearPadding()
+    {
+        if (nbits % 64 != 0)
+        {
+            words.back() &= (std::uint64_t{1} << (nbits % 64)) - 1;
+        }
+    }
+
+   private:
+    std::vector<std::uint64_t> words;
+    std::size_t nbits = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace util
+{
+
+// 带缓冲的输出器：先写入固定大小的缓冲区，写满后整块写入输出流
+class BufferedWriter
+{
+   public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    BufferedWriter() = delete;
+    explicit BufferedWriter(std::ostream& out, std::size_t capacity = DEFAULT_CAPACITY)
+        : out(out), capacity(capacity)
+    {
+        buf.reserve(capacity);
+    }
+    BufferedWriter(const BufferedWriter&) = delete;
+    auto operator=(const BufferedWriter&) -> BufferedWriter& = delete;
+    ~BufferedWriter() { flush(); }
+
+   public:
+    auto operator<<(std::string_view s) -> BufferedWriter&
+    {
+        if (buf.size() + s.size() > capacity)
+        {
+            flush();
+        }
+        if (s.size() > capacity)
+        {  // 超过缓冲区大小的内容直接写出
+            out.write(s.data(), static_cast<std::streamsize>(s.size()));
+            return *this;
+        }
+        buf.append(s);
+        return *this;
+    }
+
+    auto operator<<(char c) -> BufferedWriter&
+    {
+        if (buf.size() + 1 > capacity)
+        {
+            flush();
+        }
+        buf.push_back(c);
+        return *this;
+    }
+
+    template <typename T>
+        requires std::is_integral_v<T>
+    auto operator<<(T value) -> BufferedWriter&
+    {
+        char tmp[24];
+        auto [end, ec] = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        return *this << std::string_view{tmp, static_cast<std::size_t>(end - tmp)};
+    }
+
+    /**
+     * @brief 将缓冲区中的内容写入输出流
+     */
+    void flush()
+    {
+        if (!buf.empty())
+        {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            buf.clear();
+        }
+    }
+
+   private:
+    std::ostream& out;     // 输出流
+    std::size_t capacity;  // 缓冲区大小
+    std::string buf;       // 缓冲区
+};
+
+}  // namespace util
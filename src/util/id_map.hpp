@@ -0,0 +1,134 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+// 以整数编号为键的扁平映射表
+// 元素按插入顺序紧凑存放，遍历顺序即插入顺序。元素较少时直接顺序查找；
+// 超过 LINEAR_LIMIT 个元素后再建立开放定址 (线性探测) 的索引表
+template <typename V>
+class IdMap
+{
+   public:
+    using Key = std::uint32_t;
+    using Entry = std::pair<Key, V>;
+
+   public:
+    /**
+     * @brief  查找键对应的值
+     * @param  key 键
+     * @return 值的指针，不存在时为 nullptr
+     */
+    [[nodiscard]] auto find(Key key) const -> const V*
+    {
+        auto idx = indexOf(key);
+        return idx == NPOS ? nullptr : &entries[idx].second;
+    }
+
+    [[nodiscard]] auto find(Key key) -> V*
+    {
+        auto idx = indexOf(key);
+        return idx == NPOS ? nullptr : &entries[idx].second;
+    }
+
+    /**
+     * @brief 插入键值对，键已存在时覆盖原值 (保留原来的位置)
+     * @param key   键
+     * @param value 值
+     */
+    void insertOrAssign(Key key, V value)
+    {
+        if (auto idx = indexOf(key); idx != NPOS)
+        {
+            entries[idx].second = std::move(value);
+            return;
+        }
+
+        entries.emplace_back(key, std::move(value));
+        if (!slots.empty() && entries.size() * 2 <= slots.size())
+        {
+            place(entries.size() - 1);
+        }
+        else if (entries.size() > LINEAR_LIMIT)
+        {
+            rehash(std::bit_ceil(entries.size() * 4));
+        }
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return entries.size(); }
+    [[nodiscard]] auto empty() const -> bool { return entries.empty(); }
+
+    auto begin() const { return entries.begin(); }
+    auto end() const { return entries.end(); }
+
+   private:
+    static constexpr std::size_t LINEAR_LIMIT = 8;
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+
+    static auto hash(Key key) -> std::size_t
+    {
+        return static_cast<std::size_t>(key * 0x9E3779B1U);  // Fibonacci hashing
+    }
+
+    [[nodiscard]] auto indexOf(Key key) const -> std::size_t
+    {
+        if (slots.empty())
+        {
+            for (std::size_t i = 0; i < entries.size(); ++i)
+            {
+                if (entries[i].first == key)
+                {
+                    return i;
+                }
+            }
+            return NPOS;
+        }
+
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t s = hash(key) & mask;; s = (s + 1) & mask)
+        {
+            auto slot = slots[s];
+            if (slot == 0)
+            {
+                return NPOS;
+            }
+            if (entries[slot - 1].first == key)
+            {
+                return slot - 1;
+            }
+        }
+    }
+
+    // 在索引表中记录第 idx 个元素
+    void place(std::size_t idx)
+    {
+        std::size_t mask = slots.size() - 1;
+        std::size_t s = hash(entries[idx].first) & mask;
+        while (slots[s] != 0)
+        {
+            s = (s + 1) & mask;
+        }
+        slots[s] = static_cast<std::uint32_t>(idx + 1);
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        slots.assign(capacity, 0);
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            place(i);
+        }
+    }
+
+   private:
+    std::vector<Entry> entries;       // 按插入顺序存放的元素
+    std::vector<std::uint32_t> slots;  // 索引表，存放元素下标 + 1，0 表示空位
+};
+
+}  // namespace util
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "buffered_writer.hpp"
+
+namespace util
+{
+
+// 流式 JSON 输出器：直接写入缓冲输出，只记录当前嵌套路径上每一层是否已有元素，
+// 因此内存占用只与嵌套深度有关，与输出规模无关
+class JsonWriter
+{
+   public:
+    JsonWriter() = delete;
+    explicit JsonWriter(BufferedWriter& sink) : sink(sink) {}
+    JsonWriter(const JsonWriter&) = delete;
+    auto operator=(const JsonWriter&) -> JsonWriter& = delete;
+
+   public:
+    auto beginObject() -> JsonWriter&
+    {
+        separate();
+        sink << '{';
+        first.push_back(true);
+        return *this;
+    }
+
+    auto endObject() -> JsonWriter&
+    {
+        first.pop_back();
+        sink << '}';
+        return *this;
+    }
+
+    auto beginArray() -> JsonWriter&
+    {
+        separate();
+        sink << '[';
+        first.push_back(true);
+        return *this;
+    }
+
+    auto endArray() -> JsonWriter&
+    {
+        first.pop_back();
+        sink << ']';
+        return *this;
+    }
+
+    /**
+     * @brief  输出对象的键，其后必须紧跟一个值
+     * @param  name 键名，只能包含无需转义的字符
+     */
+    auto key(std::string_view name) -> JsonWriter&
+    {
+        separate();
+        sink << '"' << name << "\":";
+        after_key = true;
+        return *this;
+    }
+
+    /**
+     * @brief 输出字符串值，按 JSON 规则转义
+     * @param s 字符串
+     */
+    auto string(std::string_view s) -> JsonWriter&
+    {
+        separate();
+        sink << '"';
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < s.size(); ++i)
+        {
+            auto c = static_cast<unsigned char>(s[i]);
+            if (c != '"' && c != '\\' && c >= 0x20)
+            {
+                continue;
+            }
+            sink << s.substr(begin, i - begin);
+            switch (c)
+            {
+                case '"':
+                    sink << "\\\"";
+                    break;
+                case '\\':
+                    sink << "\\\\";
+                    break;
+                case '\n':
+                    sink << "\\n";
+                    break;
+                case '\t':
+                    sink << "\\t";
+                    break;
+                case '\r':
+                    sink << "\\r";
+                    break;
+                default:
+                {
+                    constexpr std::string_view hex = "0123456789abcdef";
+                    sink << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+                    break;
+                }
+            }
+            begin = i + 1;
+        }
+        sink << s.substr(begin) << '"';
+        return *this;
+    }
+
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    auto number(T value) -> JsonWriter&
+    {
+        separate();
+        sink << value;
+        return *this;
+    }
+
+    auto boolean(bool value) -> JsonWriter&
+    {
+        separate();
+        sink << (value ? std::string_view{"true"} : std::string_view{"false"});
+        return *this;
+    }
+
+    auto null() -> JsonWriter&
+    {
+        separate();
+        sink << std::string_view{"null"};
+        return *this;
+    }
+
+   private:
+    // 在同一层的相邻元素之间插入逗号
+    void separate()
+    {
+        if (after_key)
+        {
+            after_key = false;
+            return;
+        }
+        if (!first.empty())
+        {
+            if (!first.back())
+            {
+                sink << ',';
+            }
+            first.back() = false;
+        }
+    }
+
+   private:
+    BufferedWriter& sink;     // 缓冲输出
+    std::vector<bool> first;  // 每一层是否还没有元素
+    bool after_key = false;   // 上一个输出是否为键
+};
+
+}  // namespace util
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * @brief  取默认的工作线程数
+ * @return 硬件并发数，无法获取时为 1
+ */
+inline auto defaultJobs() -> std::size_t
+{
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief   并行生产、按序消费
+ * @details 工作线程按下标领取任务并调用 produce(i) 得到结果，调用线程按 0..n-1 的顺序
+ *          对每个结果调用 consume(i, result)。结果一旦被消费即释放；工作线程最多领先
+ *          消费进度 2 * jobs 个下标，因此同一时刻驻留内存的结果不超过 2 * jobs 个。
+ *          jobs <= 1 时在调用线程上串行执行。
+ *          produce 抛出的异常会在轮到该下标时于调用线程重新抛出。
+ * @param   n       任务数
+ * @param   jobs    工作线程数
+ * @param   produce 生产函数 (std::size_t) -> R，须可在多个线程上并发调用
+ * @param   consume 消费函数 (std::size_t, R&&) -> void，只在调用线程上执行
+ */
+template <typename Produce, typename Consume>
+void orderedParallel(std::size_t n, std::size_t jobs, Produce&& produce, Consume&& consume)
+{
+    using Result = std::invoke_result_t<Produce&, std::size_t>;
+
+    jobs = std::min(jobs, n);
+    if (jobs <= 1)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            consume(i, produce(i));
+        }
+        return;
+    }
+
+    struct Slot
+    {
+        std::optional<Result> result;
+        std::exception_ptr error;
+        bool ready = false;
+    };
+
+    std::vector<Slot> slots(n);
+    std::size_t window = 2 * jobs;  // 已领取但尚未消费的下标数上限
+    std::size_t consumed = 0;       // 已消费的结果数，受 mtx 保护
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> cancelled{false};
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    auto worker = [&]()
+    {
+        for (std::size_t i = next++; i < n && !cancelled; i = next++)
+        {
+            {
+                std::unique_lock lock{mtx};
+                cv.wait(lock, [&] { return i < consumed + window || cancelled; });
+            }
+            if (cancelled)
+            {
+                break;
+            }
+
+            Slot local{};
+            try
+            {
+                local.result.emplace(produce(i));
+            }
+            catch (...)
+            {
+                local.error = std::current_exception();
+            }
+            {
+                std::lock_guard lock{mtx};
+                slots[i].result = std::move(local.result);
+                slots[i].error = local.error;
+                slots[i].ready = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(jobs);
+    for (std::size_t t = 0; t < jobs; ++t)
+    {
+        workers.emplace_back(worker);
+    }
+
+    try
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Slot slot{};
+            {
+                std::unique_lock lock{mtx};
+                cv.wait(lock, [&] { return slots[i].ready; });
+                slot = std::move(slots[i]);
+                slots[i] = Slot{};
+                ++consumed;
+            }
+            cv.notify_all();
+            if (slot.error)
+            {
+                std::rethrow_exception(slot.error);
+            }
+            consume(i, std::move(*slot.result));
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard lock{mtx};
+            cancelled = true;  // 让工作线程尽快退出，jthread 析构时 join
+        }
+        cv.notify_all();
+        throw;
+    }
+}
+
+}  // namespace util
@@ -39,6 +39,35 @@ void printHelp(const char* const exec)
               << "  -p, --parse            output the abstract syntax tree (AST) only" << std::endl
               << "  -s, --semantic         check the semantics only" << std::endl
               << "  -g, --generate         generate IR only" << std::endl
+              << "  -j, --jobs N           use N worker threads (default: hardware threads)"
+              << std::endl
+              << "  -O0, -O1, -O2          IR optimization level (default: -O0); -O1 simplifies"
+              << std::endl
+              << "                         the CFG and removes dead code, -O2 also propagates"
+              << std::endl
+              << "                         constants and copies in SSA form" << std::endl
+              << "      --time-passes      report wall time and change counts of each IR pass"
+              << std::endl
+              << "      --hash-cons        share structurally identical pure expressions and"
+              << std::endl
+              << "                         reuse their temporaries" << std::endl
+              << "      --dot-func=NAME    output the AST of function NAME only" << std::endl
+              << "      --dot-max-depth=N  collapse statements/expressions nested deeper than N"
+              << std::endl
+              << "      --emit-ast=json    export the AST as JSON (output.json)" << std::endl
+              << "      --stream           with -s/-g, check and output one function at a time,"
+              << std::endl
+              << "                         freeing its scopes afterwards (bounded memory)"
+              << std::endl
+              << "      --emit-symi        write the function signatures as a binary symbol"
+              << std::endl
+              << "                         interface (output.symi)" << std::endl
+              << "      --import=FILE      declare the functions of symbol interface FILE"
+              << std::endl
+              << "                         (repeatable)" << std::endl
+              << "      --diagnostics-format=FMT" << std::endl
+              << "                         print diagnostics as human (default), json or sarif"
+              << std::endl
               << std::endl
               << "Examples:" << std::endl
               << "  $ path/to/toy_compiler -t -i test.txt" << std::endl
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+// 对象池：以块 (slab) 为单位申请内存，逐个在块中构造对象，块的容量倍增至 SLAB_SIZE 为止；
+// 对象的地址在池的生命周期内保持不变，池析构时统一析构并释放
+template <typename T, std::size_t SLAB_SIZE = 256>
+class SlabPool
+{
+   public:
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    auto operator=(const SlabPool&) -> SlabPool& = delete;
+    SlabPool(SlabPool&&) noexcept = default;
+    auto operator=(SlabPool&&) noexcept -> SlabPool& = default;
+    ~SlabPool() { clear(); }
+
+   public:
+    /**
+     * @brief  在池中构造一个对象
+     * @param  args 构造参数
+     * @return 对象指针，由池持有
+     */
+    template <typename... Args>
+    auto create(Args&&... args) -> T*
+    {
+        if (slabs.empty() || used == slabs.back().capacity)
+        {
+            // 块的容量从 FIRST_SLAB_SIZE 起倍增，避免大量小池浪费整块内存
+            std::size_t capacity =
+                slabs.empty() ? FIRST_SLAB_SIZE : std::min(slabs.back().capacity * 2, SLAB_SIZE);
+            slabs.push_back(Slab{std::make_unique_for_overwrite<Storage[]>(capacity), capacity});
+            used = 0;
+        }
+        T* obj = std::construct_at(reinterpret_cast<T*>(slabs.back().data[used].data),
+                                   std::forward<Args>(args)...);
+        ++used;
+        ++count;
+        return obj;
+    }
+
+    /**
+     * @brief 析构池中所有对象并释放内存
+     */
+    void clear()
+    {
+        for (std::size_t i = 0; i < slabs.size(); ++i)
+        {
+            std::size_t n = (i + 1 == slabs.size()) ? used : slabs[i].capacity;
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                std::destroy_at(reinterpret_cast<T*>(slabs[i].data[j].data));
+            }
+        }
+        slabs.clear();
+        used = 0;
+        count = 0;
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return count; }
+
+   private:
+    static constexpr std::size_t FIRST_SLAB_SIZE = std::min<std::size_t>(8, SLAB_SIZE);
+
+    struct alignas(T) Storage
+    {
+        std::byte data[sizeof(T)];
+    };
+
+    struct Slab
+    {
+        std::unique_ptr<Storage[]> data;
+        std::size_t capacity;
+    };
+
+    std::vector<Slab> slabs;  // 已申请的块
+    std::size_t used = 0;     // 最后一个块中已构造的对象数
+    std::size_t count = 0;    // 池中的对象总数
+};
+
+}  // namespace util
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util
+{
+
+// 字符串驻留表：为每个不同的字符串分配一个从 0 开始的整数编号
+class StringInterner
+{
+   public:
+    using Id = std::uint32_t;
+
+    StringInterner() = default;
+    StringInterner(const StringInterner&) = delete;
+    auto operator=(const StringInterner&) -> StringInterner& = delete;
+
+   public:
+    /**
+     * @brief  取字符串的编号，不存在时新分配一个
+     * @param  s 字符串
+     * @return 编号
+     */
+    auto intern(std::string_view s) -> Id
+    {
+        if (auto it = ids.find(s); it != ids.end())
+        {
+            return it->second;
+        }
+        auto id = static_cast<Id>(strs.size());
+        const auto& stored = strs.emplace_back(s);  // deque 保证已有元素地址不变
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    /**
+     * @brief  查找字符串的编号，不会新分配
+     * @param  s 字符串
+     * @return 编号，字符串从未出现过时为空
+     */
+    [[nodiscard]] auto find(std::string_view s) const -> std::optional<Id>
+    {
+        if (auto it = ids.find(s); it != ids.end())
+        {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] auto str(Id id) const -> const std::string& { return strs[id]; }
+    [[nodiscard]] auto size() const -> std::size_t { return strs.size(); }
+
+    /**
+     * @brief 清空驻留表，之前分配的编号全部失效
+     */
+    void clear()
+    {
+        ids.clear();
+        strs.clear();
+    }
+
+   private:
+    std::unordered_map<std::string_view, Id> ids;  // 字符串 -> 编号，键指向 strs 中的元素
+    std::deque<std::string> strs;                  // 编号 -> 字符串
+};
+
+}  // namespace util
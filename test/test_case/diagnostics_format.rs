@@ -0,0 +1,22 @@
+// 诊断信息的输出格式
+// toy_compiler -s --diagnostics-format=human -i diagnostics_format.rs
+// toy_compiler -s --diagnostics-format=json -i diagnostics_format.rs
+// toy_compiler -s --diagnostics-format=sarif -i diagnostics_format.rs
+// 三种格式报告相同的错误：未声明的变量、参数个数不匹配、调用未定义的函数、缺少返回值
+fn add(mut a: i32, mut b: i32) -> i32
+{
+    return a + b;
+}
+
+fn no_ret(mut x: i32) -> i32
+{
+    x = x + 1;
+}
+
+fn main()
+{
+    let mut r: i32;
+    r = add(1);
+    r = y + 1;
+    missing(r);
+}
@@ -0,0 +1,29 @@
+// AST 的 dot 输出：每个函数一个 subgraph cluster_<函数名>
+// toy_compiler -p -i dot_clusters.rs                       所有函数，各在自己的 cluster 中
+// toy_compiler -p --dot-func=nested -i dot_clusters.rs     只输出 nested 的 cluster
+// toy_compiler -p --dot-max-depth=2 -i dot_clusters.rs     更深的语句 / 表达式折叠为一个结点
+fn leaf(mut x: i32) -> i32
+{
+    return x * 2 + 1;
+}
+
+fn nested(mut n: i32) -> i32
+{
+    let mut s: i32;
+    s = 0;
+    while n > 0 {
+        if n > 10 {
+            s = s + leaf(n) * (n - 1);
+        } else {
+            s = s + 1;
+        }
+        n = n - 1;
+    }
+    return s;
+}
+
+fn main()
+{
+    let mut r: i32;
+    r = nested(20);
+}
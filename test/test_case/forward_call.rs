@@ -0,0 +1,29 @@
+// 先登记所有函数签名再检查函数体，函数可以调用在其后定义的函数 (含相互递归)
+// toy_compiler -s -j4 -i forward_call.rs
+// toy_compiler -g --stream -i forward_call.rs    逐个函数检查并生成，输出与不带 --stream 时相同
+fn main()
+{
+    let mut r: i32;
+    r = is_even(10) + twice(3);
+}
+
+fn is_even(mut n: i32) -> i32
+{
+    if n == 0 {
+        return 1;
+    }
+    return is_odd(n - 1);
+}
+
+fn is_odd(mut n: i32) -> i32
+{
+    if n == 0 {
+        return 0;
+    }
+    return is_even(n - 1);
+}
+
+fn twice(mut x: i32) -> i32
+{
+    return x + x;
+}
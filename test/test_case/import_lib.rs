@@ -0,0 +1,10 @@
+// 被导入的库：toy_compiler -s --emit-symi -i import_lib.rs -o import_lib
+fn add(mut a: i32, mut b: i32) -> i32
+{
+    return a + b;
+}
+
+fn log(mut x: i32)
+{
+    x = x + 1;
+}
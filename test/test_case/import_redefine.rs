@@ -0,0 +1,19 @@
+// 导入库后在本文件中定义同名函数：
+// toy_compiler -s --import=import_lib.symi -i import_redefine.rs -o import_redefine
+// add 与导入的签名一致，以本文件的定义为准；log 签名不一致，报告 FuncRedefinition
+fn add(mut a: i32, mut b: i32) -> i32
+{
+    return a - b;
+}
+
+fn log(mut x: i32) -> i32
+{
+    return x;
+}
+
+fn main()
+{
+    let mut s: i32;
+    s = add(1, 2);
+    log(s);
+}
@@ -0,0 +1,10 @@
+// 符号接口的导出与导入
+// toy_compiler -s --emit-symi -i import_lib.rs -o import_lib
+// toy_compiler -g --import=import_lib.symi -i import_use.rs
+// 导入的函数只登记签名，本文件可以调用，但不输出到符号表和 IR 中
+fn main()
+{
+    let mut s: i32;
+    s = add(1, 2);
+    log(s);
+}
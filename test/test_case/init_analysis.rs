@@ -0,0 +1,37 @@
+// 确定初始化分析与局部类型推导
+// toy_compiler -s -i init_analysis.rs
+// 期望的错误：
+//   第 17 行 'b' 未初始化 (只在一个分支中赋值)
+//   第 27 行 'c' 未初始化 (循环体可能一次也不执行)
+//   第 34 行 'u' 无法推导出类型
+fn branches(mut x: i32) -> i32
+{
+    let mut a: i32;
+    let mut b: i32;
+    if x > 0 {
+        a = 1;
+        b = 1;
+    } else {
+        a = 2;
+    }
+    return a + b;
+}
+
+fn loops(mut n: i32) -> i32
+{
+    let mut c: i32;
+    while n > 0 {
+        c = n;
+        n = n - 1;
+    }
+    return c;
+}
+
+fn infer(mut x: i32)
+{
+    let mut p;
+    let mut q;
+    let mut u;
+    p = x;
+    q = p;
+}
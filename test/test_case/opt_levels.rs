@@ -0,0 +1,29 @@
+// IR 优化级别
+// toy_compiler -g -O0 -i opt_levels.rs    不优化
+// toy_compiler -g -O1 -i opt_levels.rs    化简控制流图并删除死代码
+// toy_compiler -g -O2 -i opt_levels.rs    另在 SSA 形式上传播常量与复制
+// 加 --time-passes 可查看各遍的耗时与改动数
+fn calc(mut x: i32) -> i32
+{
+    let mut a: i32;
+    let mut b: i32;
+    let mut c: i32;
+    a = x;
+    b = a;
+    c = b + 0;
+    while x > 0 {
+        if x > 5 {
+            c = c + b;
+        } else {
+            c = c - 1;
+        }
+        x = x - 1;
+    }
+    return c;
+}
+
+fn main()
+{
+    let mut r: i32;
+    r = calc(8);
+}
@@ -0,0 +1,7 @@
+// 语法错误：toy_compiler -s --diagnostics-format=json -i parse_error.rs
+// 缺少 ';' 时报告 UnexpectedToken，json / sarif 输出与语义错误使用相同的字段
+fn main()
+{
+    let mut a: i32
+    a = 1;
+}